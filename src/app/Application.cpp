@@ -2,16 +2,97 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include <stdio.h>
+#include <algorithm>
+#include <cmath>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "Rendering.h"
+#include "raytracer/ProgressiveRenderer.h"
 
 static void glfw_error_callback(int error, const char* description)
 {
 	fprintf(stderr, "GLFW Error %d: %s\n", error, description);
 }
 
+static void drawStats(const RenderStats& stats)
+{
+	const double rays = static_cast<double>(std::max<uint64_t>(stats.rays(), 1));
+	ImGui::Text("Camera rays: %llu", static_cast<unsigned long long>(stats.camera_rays));
+	ImGui::Text("Bounce rays: %llu", static_cast<unsigned long long>(stats.bounce_rays));
+	ImGui::Text("Hit calls per ray: %.2f", stats.hit_calls / rays);
+	ImGui::Text("Primitive tests per ray: %.2f", stats.primitive_tests / rays);
+
+	ImGui::SeparatorText("Path ends");
+	const double paths = static_cast<double>(std::max<uint64_t>(stats.paths(), 1));
+	ImGui::Text("Escaped: %.1f%%", 100.0 * stats.escaped_paths / paths);
+	ImGui::Text("Absorbed: %.1f%%", 100.0 * stats.absorbed_paths / paths);
+	ImGui::Text("Russian roulette: %.1f%%", 100.0 * stats.roulette_paths / paths);
+	ImGui::Text("Max depth: %.1f%%", 100.0 * stats.truncated_paths / paths);
+
+	ImGui::SeparatorText("Scatter events");
+	for (size_t i = 0; i < material_type_names.size(); ++i)
+		ImGui::Text("%s: %llu", material_type_names[i], static_cast<unsigned long long>(stats.scatter_events[i]));
+
+	// Surfaces hit per path, up to the longest path seen.
+	int used_bins = static_cast<int>(stats.path_depths.size());
+	while (used_bins > 1 && stats.path_depths[used_bins - 1] == 0)
+		--used_bins;
+	float depths[RenderStats::depth_bins];
+	for (int i = 0; i < used_bins; ++i)
+		depths[i] = static_cast<float>(stats.path_depths[i]);
+	ImGui::SeparatorText("Path depth");
+	ImGui::PlotHistogram("##depths", depths, used_bins, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+}
+
+// Turns v about axis by the right-hand rule.
+static Vec3 rotateAbout(const Vec3& v, const Vec3& axis, double radians)
+{
+	const Vec3 k = unit_vector(axis);
+	return std::cos(radians) * v + std::sin(radians) * cross(k, v) + (1 - std::cos(radians)) * dot(k, v) * k;
+}
+
+// Viewport navigation on the last item, which covers the image: dragging with the left button
+// orbits around lookat, with the right or middle button pans, and the wheel zooms. Returns
+// whether the camera moved.
+static bool navigateCamera(Camera& camera, int image_height)
+{
+	const ImGuiIO& io = ImGui::GetIO();
+	Point3 lookfrom = camera.lookfrom;
+	Point3 lookat = camera.lookat;
+	double vfov = camera.vfov;
+	const bool moved = io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f;
+
+	if (ImGui::IsItemActive() && moved && ImGui::IsMouseDragging(ImGuiMouseButton_Left)) {
+		// A quarter degree per pixel; pitching stops short of vup, where the view would flip.
+		Vec3 offset = rotateAbout(lookfrom - lookat, camera.vup, degrees_to_radians(-0.25 * io.MouseDelta.x));
+		const Vec3 pitched = rotateAbout(offset, cross(camera.vup, offset), degrees_to_radians(-0.25 * io.MouseDelta.y));
+		if (std::fabs(dot(unit_vector(pitched), unit_vector(camera.vup))) < 0.99)
+			offset = pitched;
+		lookfrom = lookat + offset;
+	}
+	else if (ImGui::IsItemActive() && moved
+			 && (ImGui::IsMouseDragging(ImGuiMouseButton_Right) || ImGui::IsMouseDragging(ImGuiMouseButton_Middle))) {
+		// The point under the cursor at the distance of lookat follows the cursor.
+		const Vec3 w = unit_vector(lookfrom - lookat);
+		const Vec3 u = unit_vector(cross(camera.vup, w));
+		const Vec3 v = cross(w, u);
+		const double units_per_pixel = 2.0 * std::tan(degrees_to_radians(vfov) / 2) * (lookfrom - lookat).length() / image_height;
+		const Vec3 shift = units_per_pixel * (-io.MouseDelta.x * u + io.MouseDelta.y * v);
+		lookfrom += shift;
+		lookat += shift;
+	}
+	else if (ImGui::IsItemHovered() && io.MouseWheel != 0.0f) {
+		vfov = std::clamp(vfov * std::pow(0.9, io.MouseWheel), 1.0, 150.0);
+	}
+	else {
+		return false;
+	}
+
+	camera.setView(lookfrom, lookat, vfov);
+	return true;
+}
+
 int width = 1280;
 int height = 720;
 
@@ -71,9 +152,16 @@ bool runApplication()
 	// Our state
 	ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
-	ImageWithTexture img(width, height);
-	img.buffer = raytrace(width, height);
+	// Render progressively on a background thread; coarse previews show up first, then passes
+	// of one sample per pixel refine them. Moving the camera restarts the render.
+	auto camera = makeDemoCamera(width);
+	camera.samples_per_pixel = 256;
+	Camera view = camera;
+	DisplaySettings display = camera.display;
+	ProgressiveRenderer renderer(makeDemoScene(), camera);
+	ImageWithTexture img(renderer.width(), renderer.height());
 	img.uploadTexture();
+	renderer.start();
 
 	// Main loop
 	while (!glfwWindowShouldClose(window))
@@ -91,15 +179,79 @@ bool runApplication()
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
 
+		// Upload whatever tiles changed since the last frame. They are staged in a pixel buffer
+		// object, so the texture update runs on the GPU without stalling this frame.
+		if (renderer.hasUpdates()) {
+			if (const auto staging = img.beginUpload(); !staging.empty()) {
+				img.finishUpload(renderer.takeUpdates(staging));
+			}
+			else {
+				for (const auto& tile : renderer.takeUpdates(img.buffer))
+					img.uploadRegion(tile);
+			}
+		}
+
 		// Configurations window
 		ImGui::Begin("Configurations");
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+		ImGui::Separator();
+		const int passes = renderer.completedPasses();
+		ImGui::Text("Samples per pixel: %d / %d", passes, renderer.targetPasses());
+		ImGui::ProgressBar(static_cast<float>(passes) / renderer.targetPasses());
+		if (renderer.timeToFirstPass() > 0.0)
+			ImGui::Text("First pass after %.3f s", renderer.timeToFirstPass());
+		if (renderer.isRunning()) {
+			if (ImGui::Button("Stop"))
+				renderer.stop();
+		}
+		else if (passes < renderer.targetPasses()) {
+			if (ImGui::Button("Resume"))
+				renderer.start();
+		}
+		if (renderer.renderSeconds() > 0.0)
+			ImGui::Text("%.2f Mrays/s", renderer.raysTraced() / renderer.renderSeconds() * 1e-6);
+		// Denoised frames replace the display after passes 1, 2, 4, 8, ... and the last one.
+		bool denoise = renderer.denoiseEnabled();
+		if (ImGui::Checkbox("Denoise", &denoise))
+			renderer.setDenoise(denoise);
+		// Tone mapping only rewrites the display, the samples so far are kept.
+		ImGui::SeparatorText("Display");
+		bool display_changed = ImGui::SliderFloat("Exposure", &display.exposure, -4.0f, 4.0f, "%.1f stops");
+		int curve = static_cast<int>(display.curve);
+		if (ImGui::Combo("Tone curve", &curve, "Gamma 2\0sRGB\0ACES\0")) {
+			display.curve = static_cast<ToneCurve>(curve);
+			display_changed = true;
+		}
+		display_changed |= ImGui::Checkbox("Dither", &display.dither);
+		if (display_changed)
+			renderer.setDisplay(display);
+		ImGui::SeparatorText("Camera");
+		ImGui::TextUnformatted("Drag to orbit, right-drag to pan, scroll to zoom");
+		ImGui::Text("Field of view: %.1f deg", view.vfov);
+		if (ImGui::Button("Reset view")) {
+			view = camera;
+			renderer.setCamera(view);
+		}
+		if (ImGui::CollapsingHeader("Statistics")) {
+			if (render_stats_enabled)
+				drawStats(renderer.renderStats());
+			else
+				ImGui::TextUnformatted("Build with PHOTON_ENABLE_STATS for the render counters");
+		}
 		ImGui::End();
 
-		ImGui::Begin("Viewport");
+		ImGui::Begin("Viewport", nullptr, ImGuiWindowFlags_NoScrollWithMouse | ImGuiWindowFlags_NoMove);
 		ImVec2 uv0 = ImVec2(0.0f, 0.0f); // Bottom-left
 		ImVec2 uv1 = ImVec2(1.0f, 1.0f); // Top-right (flipped vertically)
-		ImGui::Image(img.gl_texture, ImVec2((float)img.width, (float)img.height), uv0, uv1);
+		const ImVec2 image_pos = ImGui::GetCursorScreenPos();
+		const ImVec2 image_size((float)img.width, (float)img.height);
+		ImGui::Image(img.gl_texture, image_size, uv0, uv1);
+		// An invisible button over the image takes the mouse, so dragging steers the camera.
+		ImGui::SetCursorScreenPos(image_pos);
+		ImGui::InvisibleButton("##navigate", image_size,
+			ImGuiButtonFlags_MouseButtonLeft | ImGuiButtonFlags_MouseButtonRight | ImGuiButtonFlags_MouseButtonMiddle);
+		if (navigateCamera(view, img.height))
+			renderer.setCamera(view);
 		ImGui::End();
 
 		// Rendering
@@ -124,6 +276,7 @@ bool runApplication()
 	}
 
 	// Cleanup
+	renderer.stop();
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
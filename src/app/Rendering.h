@@ -1,9 +1,11 @@
 #pragma once
 
 #include <SDL3/SDL_opengl.h>
+#include <span>
 #include <vector>
 
 #include "raytracer/Raytracer.h"
+#include "raytracer/TileScheduler.h"
 
 struct ImageWithTexture {
 
@@ -32,6 +34,8 @@ struct ImageWithTexture {
 	}
 
 	~ImageWithTexture() {
+		if (pbos[0] != 0)
+			glDeleteBuffers(pbo_count, pbos);
 		glDeleteTextures(1, &gl_texture);
 	}
 
@@ -50,10 +54,68 @@ struct ImageWithTexture {
 // 		glBindTexture(GL_TEXTURE_2D, 0);
 	}
 
+	// Uploads only the pixels of one tile of buffer, for progressive updates.
+	void uploadRegion(const Tile& tile)
+	{
+		glBindTexture(GL_TEXTURE_2D, gl_texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+		const auto offset = (static_cast<size_t>(tile.y0) * width + tile.x0) * 4;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, tile.x0, tile.y0, tile.width(), tile.height(),
+			GL_RGBA, GL_UNSIGNED_BYTE, buffer.data() + offset);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+
+	// Maps the next pixel buffer object of the ring for writing, laid out like buffer. Only the
+	// tiles passed to finishUpload() need to be written. Empty if mapping failed.
+	std::span<uint8_t> beginUpload()
+	{
+		if (pbos[0] == 0) {
+			glGenBuffers(pbo_count, pbos);
+			for (GLuint pbo : pbos) {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+				glBufferData(GL_PIXEL_UNPACK_BUFFER, buffer.size(), nullptr, GL_STREAM_DRAW);
+			}
+		}
+
+		// The buffer uploaded from a frame ago may still be read by the GPU, so this one is the
+		// other; invalidating it also lets the driver hand out fresh memory instead of waiting.
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[next_pbo]);
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, buffer.size(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return mapped ? std::span<uint8_t>(static_cast<uint8_t*>(mapped), buffer.size()) : std::span<uint8_t>();
+	}
+
+	// Unmaps the buffer from beginUpload() and copies the tiles from it into the texture. The copy
+	// runs asynchronously on the GPU, so the frame does not wait for it.
+	void finishUpload(std::span<const Tile> tiles)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[next_pbo]);
+		const bool intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+		if (intact) {
+			glBindTexture(GL_TEXTURE_2D, gl_texture);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+			for (const auto& tile : tiles) {
+				// With a pixel buffer bound, the data pointer is an offset into it.
+				const auto offset = (static_cast<size_t>(tile.y0) * width + tile.x0) * 4;
+				glTexSubImage2D(GL_TEXTURE_2D, 0, tile.x0, tile.y0, tile.width(), tile.height(),
+					GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(offset));
+			}
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		next_pbo = (next_pbo + 1) % pbo_count;
+	}
 
 	std::vector<uint8_t> buffer;
 	GLuint gl_texture = 0;
 
+	// Ring of pixel buffer objects for streaming tiles to the texture.
+	static constexpr int pbo_count = 2;
+	GLuint pbos[pbo_count] = {};
+	int next_pbo = 0;
+
 	int width;
 	int height;
 };
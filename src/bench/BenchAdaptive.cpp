@@ -0,0 +1,50 @@
+#include "Benchmark.h"
+
+#include "raytracer/Raytracer.h"
+
+#include <string>
+
+namespace {
+
+void compare(const Scene& scene, Camera camera, const std::string& view)
+{
+	camera.samples_per_pixel = 4096;
+	const auto reference = camera.render(scene);
+
+	auto run = [&](const std::string& config) {
+		std::vector<uint8_t> image;
+		const double seconds = timeSeconds([&] { image = camera.render(scene); });
+		const double pixels = static_cast<double>(camera.image_width) * camera.imageHeight();
+		report("adaptive", view + " " + config, "avg_spp", camera.samplesTraced() / pixels, "");
+		report("adaptive", view + " " + config, "display_rmse", displayRmse(image, reference), "");
+		report("adaptive", view + " " + config, "time", seconds * 1e3, "ms");
+	};
+
+	camera.seed = 1;
+	for (int spp : { 16, 32, 64 }) {
+		camera.samples_per_pixel = spp;
+		run("fixed spp=" + std::to_string(spp));
+	}
+
+	// A 64 spp budget, spent only where it is needed.
+	camera.adaptive_sampling = true;
+	camera.samples_per_pixel = 64;
+	for (double threshold : { 0.04, 0.02, 0.01 }) {
+		camera.adaptive_threshold = threshold;
+		run("adaptive threshold=" + std::to_string(threshold).substr(0, 4));
+	}
+}
+
+}
+
+PHOTON_BENCHMARK(adaptive)
+{
+	const auto scene = makeDemoScene();
+
+	// The demo view: strong defocus blur, noisy nearly everywhere.
+	compare(*scene, makeDemoCamera(96), "demo");
+
+	// A pinhole view towards the horizon, half of it flat sky.
+	Camera horizon(96, 16.0 / 9.0, 64, 10, 60.0, Point3(0, 0.2, 1), Point3(0, 0, -1), Vec3(0, 1, 0), 0.0, 1.0);
+	compare(*scene, horizon, "horizon");
+}
@@ -0,0 +1,61 @@
+#include "Benchmark.h"
+
+#include "raytracer/BVH.h"
+#include "raytracer/HittableList.h"
+#include "raytracer/Sphere.h"
+#include "raytracer/Materials/AllMaterials.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace {
+
+// N small spheres scattered through a cube whose volume grows with N, so density stays constant.
+HittableList randomSpheres(int count, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const double extent = 10.0 * std::cbrt(static_cast<double>(count));
+
+	HittableList list;
+	list.objects.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		const Point3 center(extent * (unit(rng) - 0.5), extent * (unit(rng) - 0.5), extent * (unit(rng) - 0.5));
+		list.add(std::make_shared<Sphere>(center, 0.5 + unit(rng), 0));
+	}
+	return list;
+}
+
+}
+
+PHOTON_BENCHMARK(bvh)
+{
+	for (int count : { 10'000, 100'000, 1'000'000 }) {
+		std::mt19937 rng(1234);
+		const auto config = "spheres=" + std::to_string(count);
+		const auto list = randomSpheres(count, rng);
+		const double extent = 10.0 * std::cbrt(static_cast<double>(count));
+
+		std::unique_ptr<BVH> bvh;
+		const double build_time = timeSeconds([&] { bvh = std::make_unique<BVH>(list); });
+		report("bvh", config, "build_time", build_time * 1e3, "ms");
+		report("bvh", config, "nodes", static_cast<double>(bvh->nodes().size()), "");
+
+		// The linear scan gets a ray budget that keeps it to a few seconds at 1M spheres.
+		const auto rays = randomRays(200'000, extent, rng);
+		const auto linear_ray_count = std::clamp(20'000'000 / count, 16, static_cast<int>(rays.size()));
+		const std::span<const Ray> linear_rays(rays.data(), linear_ray_count);
+
+		std::vector<real> linear_t, bvh_t, check_t;
+		const double linear_rate = linear_rays.size() / castRays(list, linear_rays, linear_t);
+		const double bvh_rate = rays.size() / castRays(*bvh, rays, bvh_t);
+		castRays(*bvh, linear_rays, check_t);
+
+		report("bvh", config, "linear_rays_per_sec", linear_rate, "rays/s");
+		report("bvh", config, "bvh_rays_per_sec", bvh_rate, "rays/s");
+		report("bvh", config, "speedup", bvh_rate / linear_rate, "x");
+		report("bvh", config, "hit_mismatches", std::abs(hitCount(linear_t) - hitCount(check_t)), "");
+		doNotOptimize(bvh_t);
+	}
+}
@@ -0,0 +1,58 @@
+#include "Benchmark.h"
+
+#include "raytracer/Denoiser.h"
+#include "raytracer/Raytracer.h"
+
+#include <string>
+
+namespace {
+
+void compare(const Scene& scene, Camera camera, const std::string& view, TileScheduler& scheduler)
+{
+	camera.samples_per_pixel = 2048;
+	const auto reference = camera.renderLinear(scene, scheduler);
+	const double pixels = static_cast<double>(camera.image_width) * camera.imageHeight();
+
+	camera.seed = 1;
+	for (int spp : { 4, 16, 64 }) {
+		camera.samples_per_pixel = spp;
+		const auto config = view + " spp=" + std::to_string(spp);
+		FeatureBuffers features;
+		const auto noisy = camera.renderLinear(scene, scheduler, features);
+		std::vector<float> denoised;
+		const double seconds = timeSeconds([&] { denoised = denoise(noisy, features, DenoiseSettings{}, scheduler); });
+
+		const auto before = imageError(noisy, reference);
+		const auto after = imageError(denoised, reference);
+		report("denoise", config, "time", seconds * 1e3, "ms");
+		report("denoise", config, "pixels_per_sec", pixels / seconds, "pixels/s");
+		report("denoise", config, "rmse_noisy", before.rmse, "");
+		report("denoise", config, "rmse_denoised", after.rmse, "");
+		report("denoise", config, "relmse_noisy", before.rel_mse, "");
+		report("denoise", config, "relmse_denoised", after.rel_mse, "");
+		report("denoise", config, "psnr_noisy", before.psnr, "dB");
+		report("denoise", config, "psnr_denoised", after.psnr, "dB");
+	}
+}
+
+}
+
+// Low spp renders before and after denoising, against a 2048 spp reference of the same view.
+PHOTON_BENCHMARK(denoise)
+{
+	TileScheduler scheduler;
+	compare(*makeDemoScene(), makeDemoCamera(160), "demo", scheduler);
+	compare(*makeCoverScene(), makeCoverCamera(160), "cover", scheduler);
+
+	// Filter cost alone at 1080p, on features of a cheap render.
+	Camera camera = makeCoverCamera(1920);
+	camera.samples_per_pixel = 1;
+	FeatureBuffers features;
+	const auto noisy = camera.renderLinear(*makeCoverScene(), scheduler, features);
+	std::vector<float> denoised;
+	const double seconds = timeSeconds([&] { denoised = denoise(noisy, features, DenoiseSettings{}, scheduler); });
+	doNotOptimize(denoised);
+	const auto config = "1920x" + std::to_string(camera.imageHeight()) + " threads=" + std::to_string(scheduler.threadCount());
+	report("denoise", config, "time", seconds * 1e3, "ms");
+	report("denoise", config, "pixels_per_sec", static_cast<double>(noisy.size() / 3) / seconds, "pixels/s");
+}
@@ -0,0 +1,118 @@
+#include "Benchmark.h"
+
+#include "raytracer/BVH.h"
+#include "raytracer/DynamicBVH.h"
+#include "raytracer/HittableList.h"
+#include "raytracer/Sphere.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace {
+
+struct MovingSphere {
+	Point3 center;
+	real radius;
+	Vec3 velocity;
+};
+
+}
+
+// 100k spheres of which 1% move every frame, each along its own straight line. Per frame, the
+// dynamic BVH refits (and now and then rebuilds a subtree), the baseline rebuilds the world the
+// way the scenes are made today: a new HittableList of new spheres and a new BVH over it.
+PHOTON_BENCHMARK(dynamic)
+{
+	constexpr int count = 100'000;
+	constexpr int frames = 200;
+	constexpr int moving_per_frame = count / 100;
+	const double extent = 10.0 * std::cbrt(static_cast<double>(count));
+	const auto config = "spheres=" + std::to_string(count) + " moving=1%";
+
+	std::mt19937 rng(2024);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	std::vector<MovingSphere> spheres;
+	spheres.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		const Point3 center(extent * (unit(rng) - 0.5), extent * (unit(rng) - 0.5), extent * (unit(rng) - 0.5));
+		const Vec3 velocity(unit(rng) - 0.5, unit(rng) - 0.5, unit(rng) - 0.5);
+		spheres.push_back(MovingSphere{ center, static_cast<real>(0.5 + unit(rng)), velocity });
+	}
+
+	DynamicBVH dynamic;
+	std::vector<DynamicBVH::Handle> handles;
+	handles.reserve(count);
+	for (const auto& sphere : spheres)
+		handles.push_back(dynamic.addSphere(sphere.center, sphere.radius, 0));
+	const double build_time = timeSeconds([&] { dynamic.update(); });
+	report("dynamic", config, "build_time", build_time * 1e3, "ms");
+	report("dynamic", config, "sah_cost_built", dynamic.sahCost(), "");
+
+	// The same objects move every frame: a fixed 1% of the scene is animated.
+	std::vector<int> moving(count);
+	for (int i = 0; i < count; ++i)
+		moving[i] = i;
+	std::shuffle(moving.begin(), moving.end(), rng);
+	moving.resize(moving_per_frame);
+
+	double update_time = 0.0, rebuild_time = 0.0, worst_update = 0.0;
+	uint64_t refit_nodes = 0, rebuilt_subtrees = 0, rebuilt_objects = 0, full_rebuilds = 0;
+	std::unique_ptr<BVH> rebuilt;
+	for (int frame = 0; frame < frames; ++frame) {
+		for (const int i : moving) {
+			auto& sphere = spheres[i];
+			sphere.center += sphere.velocity;
+			dynamic.setSphere(handles[i], sphere.center, sphere.radius);
+		}
+
+		DynamicBVH::UpdateReport update;
+		const double seconds = timeSeconds([&] { update = dynamic.update(); });
+		update_time += seconds;
+		worst_update = std::max(worst_update, seconds);
+		refit_nodes += update.refit_nodes;
+		rebuilt_subtrees += update.rebuilt_subtrees;
+		rebuilt_objects += update.rebuilt_objects;
+		full_rebuilds += update.full_rebuild;
+
+		rebuild_time += timeSeconds([&] {
+			HittableList world;
+			world.objects.reserve(count);
+			for (const auto& sphere : spheres)
+				world.add(std::make_shared<Sphere>(sphere.center, sphere.radius, 0));
+			rebuilt = std::make_unique<BVH>(world);
+		});
+	}
+
+	report("dynamic", config, "update_time", update_time / frames * 1e3, "ms/frame");
+	report("dynamic", config, "worst_update_time", worst_update * 1e3, "ms");
+	report("dynamic", config, "rebuild_time", rebuild_time / frames * 1e3, "ms/frame");
+	report("dynamic", config, "speedup", rebuild_time / update_time, "x");
+	report("dynamic", config, "refit_nodes", static_cast<double>(refit_nodes) / frames, "nodes/frame");
+	report("dynamic", config, "rebuilt_subtrees", static_cast<double>(rebuilt_subtrees) / frames, "subtrees/frame");
+	report("dynamic", config, "rebuilt_objects", static_cast<double>(rebuilt_objects) / frames, "objects/frame");
+	report("dynamic", config, "full_rebuilds", static_cast<double>(full_rebuilds), "");
+	report("dynamic", config, "sah_cost_after", dynamic.sahCost(), "");
+	DynamicBVH fresh;
+	for (const auto& sphere : spheres)
+		fresh.addSphere(sphere.center, sphere.radius, 0);
+	fresh.update();
+	report("dynamic", config, "sah_cost_fresh", fresh.sahCost(), "");
+
+	// Tracing speed after all the frames, against a tree built from scratch over the final
+	// positions, which must give the same hits.
+	const auto rays = randomRays(200'000, extent, rng);
+	std::vector<real> dynamic_t, rebuilt_t;
+	const double dynamic_rate = rays.size() / castRays(dynamic, rays, dynamic_t);
+	const double rebuilt_rate = rays.size() / castRays(*rebuilt, rays, rebuilt_t);
+	int mismatches = 0;
+	for (size_t i = 0; i < rays.size(); ++i) {
+		if (dynamic_t[i] != rebuilt_t[i])
+			++mismatches;
+	}
+	report("dynamic", config, "rays_per_sec", dynamic_rate, "rays/s");
+	report("dynamic", config, "rays_per_sec_rebuilt", rebuilt_rate, "rays/s");
+	report("dynamic", config, "mismatches_vs_rebuilt", mismatches, "");
+}
@@ -0,0 +1,99 @@
+#include "Benchmark.h"
+
+#include "raytracer/Instance.h"
+#include "raytracer/TriangleMesh.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace {
+
+// Randomly rotated and scaled copies of one prototype over a square that grows with their count.
+std::vector<InstanceBVH::Placement> randomPlacements(int count, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const double half_extent = 1.5 * std::sqrt(static_cast<double>(count));
+	std::vector<InstanceBVH::Placement> placements;
+	placements.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		const Vec3 scale(0.2 + 0.4 * unit(rng), 0.2 + 0.4 * unit(rng), 0.2 + 0.4 * unit(rng));
+		const Vec3 offset(half_extent * (2 * unit(rng) - 1), scale.y(), half_extent * (2 * unit(rng) - 1));
+		const Vec3 axis(unit(rng) - 0.5, unit(rng) - 0.5, unit(rng) - 0.5);
+		placements.push_back(InstanceBVH::Placement{ 0,
+			Transform::translate(offset) * Transform::rotate(axis, 360 * unit(rng)) * Transform::scale(scale) });
+	}
+	return placements;
+}
+
+// Rays from above the field, looking down at it at random angles.
+std::vector<Ray> fieldRays(int count, double half_extent, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	std::vector<Ray> rays;
+	rays.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		const Point3 origin(half_extent * (2 * unit(rng) - 1), 5.0, half_extent * (2 * unit(rng) - 1));
+		rays.emplace_back(origin, Vec3(unit(rng) - 0.5, -1.0, unit(rng) - 0.5));
+	}
+	return rays;
+}
+
+}
+
+PHOTON_BENCHMARK(instances)
+{
+	std::mt19937 rng(11);
+	const auto prototype = makeIcosphere(4);
+	const auto mesh = std::make_shared<TriangleMesh>(prototype, 0);
+
+	for (int count : { 1'000, 100'000, 1'000'000 }) {
+		const auto config = "instances=" + std::to_string(count) + " triangles=" + std::to_string(mesh->triangleCount());
+		const auto placements = randomPlacements(count, rng);
+
+		std::unique_ptr<InstanceBVH> field;
+		const double build_time = timeSeconds([&] { field = std::make_unique<InstanceBVH>(std::vector<std::shared_ptr<const Hittable>>{ mesh }, placements); });
+		report("instances", config, "build_time", build_time * 1e3, "ms");
+		report("instances", config, "memory", static_cast<double>(field->memoryBytes() + mesh->memoryBytes()) / (1 << 20), "MiB");
+		report("instances", config, "flattened_memory", static_cast<double>(count) * mesh->memoryBytes() / (1 << 20), "MiB");
+
+		const auto rays = fieldRays(200'000, 1.5 * std::sqrt(static_cast<double>(count)), rng);
+		int hits = 0;
+		const double seconds = timeSeconds([&] {
+			HitRecord rec;
+			for (const auto& ray : rays) {
+				if (field->hit(ray, Interval(0, infinity), rec))
+					++hits;
+			}
+		});
+		report("instances", config, "rays_per_sec", rays.size() / seconds, "rays/s");
+		report("instances", config, "hit_fraction", static_cast<double>(hits) / rays.size(), "");
+	}
+
+	// The same copies baked into one world space mesh must be hit at the same points.
+	const int count = 500;
+	const auto placements = randomPlacements(count, rng);
+	const InstanceBVH field({ mesh }, placements);
+	MeshBuffers baked;
+	for (const auto& placement : placements) {
+		const auto base = static_cast<uint32_t>(baked.positions.size());
+		const auto world_to_object = placement.object_to_world.inverse();
+		for (const auto& p : prototype.positions)
+			baked.positions.push_back(placement.object_to_world.applyToPoint(p));
+		for (const auto& n : prototype.normals)
+			baked.normals.push_back(unit_vector(world_to_object.applyTransposeToVector(n)));
+		for (const auto index : prototype.indices)
+			baked.indices.push_back(base + index);
+	}
+	const TriangleMesh reference(std::move(baked), 0);
+
+	int mismatches = 0;
+	for (const auto& ray : fieldRays(100'000, 1.5 * std::sqrt(static_cast<double>(count)), rng)) {
+		HitRecord a, b;
+		const bool hit_a = field.hit(ray, Interval(0, infinity), a);
+		const bool hit_b = reference.hit(ray, Interval(0, infinity), b);
+		if (hit_a != hit_b || (hit_a && ((a.p - b.p).length() > 1e-4 || dot(a.normal, b.normal) < 0.999)))
+			++mismatches;
+	}
+	report("instances", "instances=" + std::to_string(count), "mismatches_vs_baked", mismatches, "");
+}
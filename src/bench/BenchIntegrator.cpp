@@ -0,0 +1,78 @@
+#include "Benchmark.h"
+
+#include "raytracer/Camera.h"
+#include "raytracer/PackedSpheres.h"
+#include "raytracer/Materials/AllMaterials.h"
+
+#include <atomic>
+#include <string>
+
+namespace {
+
+// Counts the rays traced against the wrapped scene.
+class CountingHittable : public Hittable {
+public:
+	explicit CountingHittable(const Hittable& inner) noexcept : inner(inner) {}
+
+	bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept override {
+		rays.fetch_add(1, std::memory_order_relaxed);
+		return inner.hit(r, ray_t, rec);
+	}
+	[[nodiscard]] AABB boundingBox() const noexcept override { return inner.boundingBox(); }
+
+	mutable std::atomic<uint64_t> rays{0};
+
+private:
+	const Hittable& inner;
+};
+
+// A 5 x 5 grid of glass and mirror spheres on a ground plane: long specular paths.
+Scene glassScene()
+{
+	Scene scene;
+	auto world = std::make_shared<PackedSpheres>();
+	world->add(Point3(0, -1000, 0), 1000, scene.materials.add(Lambertian(Color(0.5, 0.5, 0.5))));
+	const auto glass = scene.materials.add(Dielectric(1.5));
+	const auto mirror = scene.materials.add(Metal(Color(0.9, 0.9, 0.9), 0.0));
+	for (int a = -2; a <= 2; ++a) {
+		for (int b = -2; b <= 2; ++b)
+			world->add(Point3(1.1 * a, 0.5, 1.1 * b), 0.5, (a + b) % 2 == 0 ? glass : mirror);
+	}
+	scene.world = world;
+	return scene;
+}
+
+double meanValue(const std::vector<uint8_t>& rgba)
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < rgba.size(); ++i) {
+		if (i % 4 != 3)
+			sum += rgba[i];
+	}
+	return sum / (rgba.size() / 4 * 3);
+}
+
+}
+
+PHOTON_BENCHMARK(integrator)
+{
+	const auto scene = glassScene();
+
+	for (int max_depth : { 10, 50 }) {
+		for (bool roulette : { false, true }) {
+			auto world = std::make_shared<CountingHittable>(*scene.world);
+			const Scene counted{ world, scene.materials, scene.lights, scene.sky };
+			Camera camera(160, 16.0 / 9.0, 32, max_depth, 30.0, Point3(6, 3, 6), Point3(0, 0.4, 0), Vec3(0, 1, 0), 0.0, 1.0);
+			camera.russian_roulette = roulette;
+
+			std::vector<uint8_t> image;
+			const double seconds = timeSeconds([&] { image = camera.render(counted); });
+			const double samples = static_cast<double>(camera.samplesTraced());
+
+			const auto config = "depth=" + std::to_string(max_depth) + (roulette ? " roulette" : " fixed");
+			report("integrator", config, "avg_path_length", world->rays.load() / samples, "rays");
+			report("integrator", config, "time_per_sample", seconds * 1e9 / samples, "ns");
+			report("integrator", config, "mean_pixel_value", meanValue(image), "");
+		}
+	}
+}
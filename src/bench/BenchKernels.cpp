@@ -0,0 +1,179 @@
+#include "Benchmark.h"
+
+#include "raytracer/HittableList.h"
+#include "raytracer/Sampler.h"
+#include "raytracer/Sphere.h"
+#include "raytracer/Tonemap.h"
+#include "raytracer/Materials/AllMaterials.h"
+
+#include <random>
+#include <string>
+
+namespace {
+
+constexpr int inputs = 1 << 16;	// Per kernel, reused by every run
+constexpr int passes = 32;		// Over the inputs per timed run
+constexpr int runs = 5;			// Timed runs, the best counts
+
+// Nanoseconds per call of a kernel that makes inputs calls per pass.
+template <typename Fn>
+double nsPerCall(Fn&& pass)
+{
+	const double seconds = bestSeconds(runs, [&] {
+		for (int p = 0; p < passes; ++p)
+			pass();
+	});
+	return seconds * 1e9 / (static_cast<double>(passes) * inputs);
+}
+
+Vec3 randomUnitVector(std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	return sample_uniform_sphere(real(unit(rng)), real(unit(rng)));
+}
+
+// Rays from a sphere of radius 4 around the origin towards points within 1.5 of it, so about
+// 40% of them hit a unit sphere at the origin.
+std::vector<Ray> raysAtOrigin(std::mt19937& rng)
+{
+	std::vector<Ray> rays;
+	rays.reserve(inputs);
+	for (int i = 0; i < inputs; ++i) {
+		const Point3 origin = 4 * randomUnitVector(rng);
+		rays.emplace_back(origin, 1.5 * randomUnitVector(rng) - origin);
+	}
+	return rays;
+}
+
+// count spheres of radius 0.1 to 0.3 spread over the 2 x 2 x 2 cube around the origin.
+HittableList sphereCluster(int count, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	HittableList list;
+	for (int i = 0; i < count; ++i) {
+		const Point3 center(2 * unit(rng) - 1, 2 * unit(rng) - 1, 2 * unit(rng) - 1);
+		list.add(std::make_shared<Sphere>(center, 0.1 + 0.2 * unit(rng), 0));
+	}
+	return list;
+}
+
+}
+
+// The per-call cost of the innermost functions of the path tracer, each on fixed-seed inputs
+// that are generated once and stay in cache.
+PHOTON_BENCHMARK(kernels)
+{
+	std::mt19937 rng(2024);
+	const auto rays = raysAtOrigin(rng);
+
+	{
+		const Sphere sphere(Point3(0, 0, 0), 1, 0);
+		int hits = 0;
+		const double ns = nsPerCall([&] {
+			HitRecord rec;
+			for (const auto& ray : rays)
+				hits += sphere.hit(ray, Interval(0.001, infinity), rec);
+			doNotOptimize(rec);
+		});
+		report("kernels", "sphere_hit", "ns_per_call", ns, "ns");
+		report("kernels", "sphere_hit", "hit_fraction", static_cast<double>(hits) / (static_cast<double>(runs) * passes * inputs), "");
+	}
+
+	for (int count : { 4, 16, 64 }) {
+		const auto list = sphereCluster(count, rng);
+		const auto config = "hittable_list spheres=" + std::to_string(count);
+		int hits = 0;
+		const double ns = nsPerCall([&] {
+			HitRecord rec;
+			for (const auto& ray : rays)
+				hits += list.hit(ray, Interval(0.001, infinity), rec);
+			doNotOptimize(rec);
+		});
+		report("kernels", config, "ns_per_ray", ns, "ns");
+		report("kernels", config, "ns_per_sphere_test", ns / count, "ns");
+	}
+
+	{
+		seed_random(0, 0, 0, 2024);
+		Vec3 sum(0, 0, 0);
+		const double ns = nsPerCall([&] {
+			for (int i = 0; i < inputs; ++i)
+				sum += random_unit_vector();
+		});
+		doNotOptimize(sum);
+		report("kernels", "random_unit_vector", "ns_per_call", ns, "ns");
+	}
+
+	// Unit directions and normals facing them, as a scatter at a surface sees them.
+	std::vector<Vec3> directions(inputs), normals(inputs);
+	for (int i = 0; i < inputs; ++i) {
+		directions[i] = randomUnitVector(rng);
+		normals[i] = randomUnitVector(rng);
+		if (dot(directions[i], normals[i]) > 0)
+			normals[i] = -normals[i];
+	}
+	{
+		Vec3 sum(0, 0, 0);
+		const double ns = nsPerCall([&] {
+			for (int i = 0; i < inputs; ++i)
+				sum += reflect(directions[i], normals[i]);
+		});
+		doNotOptimize(sum);
+		report("kernels", "reflect", "ns_per_call", ns, "ns");
+	}
+	{
+		Vec3 sum(0, 0, 0);
+		const double ns = nsPerCall([&] {
+			for (int i = 0; i < inputs; ++i)
+				sum += refract(directions[i], normals[i], real(1 / 1.5));
+		});
+		doNotOptimize(sum);
+		report("kernels", "refract", "ns_per_call", ns, "ns");
+	}
+
+	// Glass hit from outside and inside alternately, at a unit sphere.
+	{
+		std::vector<Ray> incoming;
+		std::vector<HitRecord> records(inputs);
+		for (int i = 0; i < inputs; ++i) {
+			records[i].p = -normals[i];
+			records[i].normal = normals[i];
+			records[i].front_face = i % 2 == 0;
+			records[i].p_error = real(1e-6);
+			incoming.emplace_back(records[i].p - directions[i], directions[i]);
+		}
+
+		const Dielectric glass(1.5);
+		const auto sampler = makeSampler(SamplerType::Independent, 1, 2024);
+		sampler->startPixelSample(0, 0, 0);
+		Color attenuation;
+		Ray scattered;
+		Vec3 sum(0, 0, 0);
+		const double ns = nsPerCall([&] {
+			for (int i = 0; i < inputs; ++i) {
+				(void)glass.scatter(incoming[i], records[i], attenuation, scattered, *sampler);
+				sum += scattered.direction();
+			}
+		});
+		doNotOptimize(sum);
+		report("kernels", "dielectric_scatter", "ns_per_call", ns, "ns");
+	}
+
+	// write_color() per pixel became toneMapRow() over rows; the tonemap benchmark covers whole
+	// images on the pool, this the per-pixel cost on one thread.
+	{
+		std::vector<float> rgb(3 * static_cast<size_t>(inputs));
+		std::uniform_real_distribution<float> radiance(0.0f, 2.0f);
+		for (auto& value : rgb)
+			value = radiance(rng);
+		std::vector<uint8_t> rgba(4 * static_cast<size_t>(inputs));
+		for (auto curve : { ToneCurve::Gamma2, ToneCurve::ACES }) {
+			const DisplaySettings settings{ 0.0f, curve, false };
+			const double ns = nsPerCall([&] {
+				toneMapRow(rgb.data(), rgba.data(), inputs, 0, 0, settings);
+				doNotOptimize(rgba);
+			});
+			report("kernels", std::string("tone_map_row ") + toneCurveName(curve), "ns_per_pixel", ns, "ns");
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#include "Benchmark.h"
+
+#include "raytracer/Raytracer.h"
+
+#include <string>
+
+namespace {
+
+// Low spp renders with and without light sampling against a 2048 spp reference with it, which is
+// unbiased either way and converges faster.
+void converge(uint32_t light_count, TileScheduler& scheduler)
+{
+	const auto scene = makeLightsScene(light_count);
+	Camera camera = makeLightsCamera(160);
+	camera.samples_per_pixel = 2048;
+	const auto reference = camera.renderLinear(*scene, scheduler);
+
+	camera.seed = 1;
+	for (int spp : { 4, 16, 64 }) {
+		camera.samples_per_pixel = spp;
+		for (bool light_sampling : { false, true }) {
+			camera.light_sampling = light_sampling;
+			const auto config = "lights=" + std::to_string(light_count) + " spp=" + std::to_string(spp)
+				+ (light_sampling ? " nee+mis" : " bsdf");
+			std::vector<float> image;
+			const double seconds = timeSeconds([&] { image = camera.renderLinear(*scene, scheduler); });
+			const auto error = imageError(image, reference);
+			report("lights", config, "time", seconds * 1e3, "ms");
+			report("lights", config, "relmse", error.rel_mse, "");
+			report("lights", config, "psnr", error.psnr, "dB");
+			// Inverse error per second: which strategy gets to a given error sooner.
+			report("lights", config, "efficiency", 1.0 / (error.rel_mse * seconds), "1/s");
+		}
+	}
+}
+
+}
+
+PHOTON_BENCHMARK(lights)
+{
+	TileScheduler scheduler;
+	converge(1, scheduler);
+	converge(64, scheduler);
+	converge(4096, scheduler);
+
+	// Picking a light costs the same however many there are, so the time per path should barely
+	// grow with the count; what grows is the BVH the rays traverse.
+	for (uint32_t count : { 16u, 256u, 4096u, 65536u }) {
+		const auto scene = makeLightsScene(count);
+		Camera camera = makeLightsCamera(160);
+		camera.samples_per_pixel = 16;
+		for (bool light_sampling : { false, true }) {
+			camera.light_sampling = light_sampling;
+			const double seconds = timeSeconds([&] { doNotOptimize(camera.renderLinear(*scene, scheduler)); });
+			const auto config = "lights=" + std::to_string(count) + (light_sampling ? " nee+mis" : " bsdf");
+			report("lights", config, "mrays_per_sec", camera.raysTraced() / seconds * 1e-6, "Mrays/s");
+			report("lights", config, "samples_per_sec", camera.samplesTraced() / seconds, "samples/s");
+		}
+	}
+}
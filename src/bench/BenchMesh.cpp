@@ -0,0 +1,76 @@
+#include "Benchmark.h"
+
+#include "raytracer/ObjLoader.h"
+#include "raytracer/TriangleMesh.h"
+
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace {
+
+void writeOBJ(const std::string& path, const MeshBuffers& mesh)
+{
+	std::ofstream file(path);
+	file.precision(17);
+	for (const auto& p : mesh.positions)
+		file << "v " << p.x() << ' ' << p.y() << ' ' << p.z() << '\n';
+	for (const auto& n : mesh.normals)
+		file << "vn " << n.x() << ' ' << n.y() << ' ' << n.z() << '\n';
+	for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+		file << 'f';
+		for (size_t k = 0; k < 3; ++k)
+			file << ' ' << mesh.indices[t + k] + 1 << "//" << mesh.indices[t + k] + 1;
+		file << '\n';
+	}
+}
+
+}
+
+PHOTON_BENCHMARK(mesh)
+{
+	namespace fs = std::filesystem;
+
+	for (int subdivisions : { 4, 6, 8 }) {
+		const auto source = makeIcosphere(subdivisions);
+		const auto config = "triangles=" + std::to_string(source.indices.size() / 3);
+		const auto path = (fs::temp_directory_path() / ("photon_bench_mesh_" + std::to_string(subdivisions) + ".obj")).string();
+		writeOBJ(path, source);
+
+		MeshBuffers buffers;
+		std::string error;
+		const double load_time = timeSeconds([&] { (void)loadOBJ(path, buffers, error); });
+		fs::remove(path);
+		std::unique_ptr<TriangleMesh> mesh;
+		const double build_time = timeSeconds([&] { mesh = std::make_unique<TriangleMesh>(std::move(buffers), 0); });
+		report("mesh", config, "obj_load_time", load_time * 1e3, "ms");
+		report("mesh", config, "build_time", build_time * 1e3, "ms");
+		report("mesh", config, "bytes_per_triangle", static_cast<double>(mesh->memoryBytes()) / mesh->triangleCount(), "B");
+
+		// Rays from inside the closed mesh aimed exactly at its vertices and edge midpoints, where a
+		// non-watertight test lets rays slip between neighbouring triangles.
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<double> unit(-0.1, 0.1);
+		std::vector<Ray> rays;
+		for (size_t t = 0; t < source.indices.size() && rays.size() < 400'000; t += 3) {
+			const Point3 origin(unit(rng), unit(rng), unit(rng));
+			const auto& a = source.positions[source.indices[t]];
+			const auto& b = source.positions[source.indices[t + 1]];
+			rays.emplace_back(origin, a - origin);
+			rays.emplace_back(origin, real(0.5) * (a + b) - origin);
+		}
+		int misses = 0;
+		const double seconds = timeSeconds([&] {
+			HitRecord rec;
+			for (const auto& ray : rays) {
+				if (!mesh->hit(ray, Interval(0, infinity), rec))
+					++misses;
+			}
+		});
+		report("mesh", config, "rays_per_sec", rays.size() / seconds, "rays/s");
+		report("mesh", config, "edge_vertex_leaks", misses, "");
+	}
+}
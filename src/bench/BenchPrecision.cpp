@@ -0,0 +1,67 @@
+#include "Benchmark.h"
+
+#include "raytracer/Camera.h"
+#include "raytracer/PackedSpheres.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace {
+
+constexpr const char* precision_name = sizeof(real) == sizeof(float) ? "float" : "double";
+
+// The demo scene, moved by `offset`.
+Scene demoScene(const Vec3& offset)
+{
+	Scene scene;
+	auto world = std::make_shared<PackedSpheres>();
+	world->add(offset + Point3(0.0, -100.5, -1.0), 100.0, scene.materials.add(Lambertian(Color(0.8, 0.8, 0.0))));
+	world->add(offset + Point3(0.0, 0.0, -1.2), 0.5, scene.materials.add(Lambertian(Color(0.1, 0.2, 0.5))));
+	world->add(offset + Point3(-1.0, 0.0, -1.0), 0.5, scene.materials.add(Dielectric(1.50)));
+	world->add(offset + Point3(-1.0, 0.0, -1.0), 0.4, scene.materials.add(Dielectric(1.00 / 1.50)));
+	world->add(offset + Point3(1.0, 0.0, -1.0), 0.5, scene.materials.add(Metal(Color(0.8, 0.6, 0.2), 1.0)));
+	scene.world = world;
+	return scene;
+}
+
+Camera demoCamera(const Vec3& offset)
+{
+	return Camera(320, 16.0 / 9.0, 64, 10, 20.0, offset + Point3(-2, 2, 1), offset + Point3(0, 0, -1), Vec3(0, 1, 0), 0.0, 3.4);
+}
+
+}
+
+// Build photon_bench with and without PHOTON_USE_FLOAT and run `photon_bench precision` with both
+// from the same directory: each run leaves its image behind and compares against the other's.
+PHOTON_BENCHMARK(precision)
+{
+	const std::string config = precision_name;
+	report("precision", config, "sizeof_ray", sizeof(Ray), "bytes");
+	report("precision", config, "sizeof_hit_record", sizeof(HitRecord), "bytes");
+
+	const auto scene = demoScene(Vec3(0, 0, 0));
+	auto camera = demoCamera(Vec3(0, 0, 0));
+	std::vector<uint8_t> image;
+	const double seconds = timeSeconds([&] { image = camera.render(scene); });
+	report("precision", config, "samples_per_sec", camera.samplesTraced() / seconds, "samples/s");
+
+	// Far from the origin rounding errors grow with the coordinates; without error-bounded ray offsets
+	// this shows up as self-intersection noise.
+	for (double distance : { 1e2, 1e3, 1e4 }) {
+		const Vec3 offset(distance, 0, distance);
+		auto moved = demoCamera(offset);
+		const auto moved_image = moved.render(demoScene(offset));
+		report("precision", config + " offset=" + std::to_string(static_cast<int>(distance)), "display_rmse",
+			   displayRmse(moved_image, image), "");
+	}
+
+	std::ofstream(std::string("photon_precision_") + precision_name + ".rgba", std::ios::binary)
+		.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+
+	const std::string other = sizeof(real) == sizeof(float) ? "double" : "float";
+	std::ifstream in("photon_precision_" + other + ".rgba", std::ios::binary);
+	const std::vector<uint8_t> reference((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if (reference.size() == image.size())
+		report("precision", config + " vs " + other, "display_rmse", displayRmse(image, reference), "");
+}
@@ -0,0 +1,61 @@
+#include "Benchmark.h"
+
+#include "raytracer/math_utils.h"
+
+#include <random>
+
+PHOTON_BENCHMARK(random)
+{
+	constexpr int draws = 50'000'000;
+
+	// The generator random_double() used before: a std::mt19937 behind a distribution.
+	{
+		std::mt19937 generator;
+		std::uniform_real_distribution<double> distribution(0.0, 1.0);
+		double sum = 0.0;
+		const double seconds = timeSeconds([&] {
+			for (int i = 0; i < draws; ++i)
+				sum += distribution(generator);
+		});
+		doNotOptimize(sum);
+		report("random", "mt19937", "ns_per_draw", seconds * 1e9 / draws, "ns");
+		report("random", "mt19937", "state_size", sizeof(generator), "bytes");
+	}
+
+	{
+		Pcg32 generator;
+		double sum = 0.0;
+		const double seconds = timeSeconds([&] {
+			for (int i = 0; i < draws; ++i)
+				sum += generator.nextDouble();
+		});
+		doNotOptimize(sum);
+		report("random", "pcg32", "ns_per_draw", seconds * 1e9 / draws, "ns");
+		report("random", "pcg32", "state_size", sizeof(generator), "bytes");
+	}
+
+	// What the renderer actually calls: the thread-local generator through random_double().
+	{
+		double sum = 0.0;
+		const double seconds = timeSeconds([&] {
+			for (int i = 0; i < draws; ++i)
+				sum += random_double();
+		});
+		doNotOptimize(sum);
+		report("random", "random_double", "ns_per_draw", seconds * 1e9 / draws, "ns");
+	}
+
+	// Cost of the per-sample reseed done once per camera sample.
+	{
+		constexpr int seeds = 10'000'000;
+		double sum = 0.0;
+		const double seconds = timeSeconds([&] {
+			for (int i = 0; i < seeds; ++i) {
+				seed_random(static_cast<uint32_t>(i), 3, 0);
+				sum += random_double();
+			}
+		});
+		doNotOptimize(sum);
+		report("random", "seed_random", "ns_per_seed", seconds * 1e9 / seeds, "ns");
+	}
+}
@@ -0,0 +1,74 @@
+#include "Benchmark.h"
+
+#include "raytracer/Camera.h"
+#include "raytracer/PackedSpheres.h"
+#include "raytracer/Materials/AllMaterials.h"
+
+#include <cmath>
+#include <string>
+
+namespace {
+
+// The demo scene from raytrace(), glass and defocus included.
+Scene demoSpheres()
+{
+	Scene scene;
+	auto world = std::make_shared<PackedSpheres>();
+	world->add(Point3(0.0, -100.5, -1.0), 100.0, scene.materials.add(Lambertian(Color(0.8, 0.8, 0.0))));
+	world->add(Point3(0.0, 0.0, -1.2), 0.5, scene.materials.add(Lambertian(Color(0.1, 0.2, 0.5))));
+	world->add(Point3(-1.0, 0.0, -1.0), 0.5, scene.materials.add(Dielectric(1.50)));
+	world->add(Point3(-1.0, 0.0, -1.0), 0.4, scene.materials.add(Dielectric(1.00 / 1.50)));
+	world->add(Point3(1.0, 0.0, -1.0), 0.5, scene.materials.add(Metal(Color(0.8, 0.6, 0.2), 1.0)));
+	scene.world = world;
+	return scene;
+}
+
+std::vector<double> renderLinear(const Scene& scene, SamplerType type, int spp, uint32_t seed)
+{
+	Camera cam(64, 16.0 / 9.0, spp, 10, 20.0, Point3(-2, 2, 1), Point3(0, 0, -1), Vec3(0, 1, 0), 10.0, 3.4);
+	cam.sampler_type = type;
+	cam.seed = seed;
+	const auto rgba = cam.render(scene);
+
+	// Undo the gamma-2 encoding; the 8-bit quantization is well below the noise at these spp.
+	std::vector<double> linear;
+	linear.reserve(rgba.size() / 4 * 3);
+	for (size_t i = 0; i < rgba.size(); i += 4) {
+		for (int c = 0; c < 3; ++c) {
+			const double v = (rgba[i + c] + 0.5) / 256.0;
+			linear.push_back(v * v);
+		}
+	}
+	return linear;
+}
+
+double rmse(const std::vector<double>& image, const std::vector<double>& reference)
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < image.size(); ++i)
+		sum += (image[i] - reference[i]) * (image[i] - reference[i]);
+	return std::sqrt(sum / image.size());
+}
+
+}
+
+PHOTON_BENCHMARK(sampling)
+{
+	const auto scene = demoSpheres();
+	const auto reference = renderLinear(scene, SamplerType::Sobol, 4096, 7);
+
+	for (auto type : { SamplerType::Independent, SamplerType::Stratified, SamplerType::Sobol }) {
+		for (int spp : { 1, 4, 16, 64, 256 }) {
+			// Average over a few seeds so a lucky seed does not decide the comparison.
+			double error = 0.0;
+			constexpr int seeds = 4;
+			const double seconds = timeSeconds([&] {
+				for (uint32_t seed = 0; seed < seeds; ++seed)
+					error += rmse(renderLinear(scene, type, spp, 100 + seed), reference) / seeds;
+			});
+			const auto config = std::string(samplerName(type)) + " spp=" + std::to_string(spp);
+			report("sampling", config, "rmse", error, "");
+			report("sampling", config, "time_per_image", seconds * 1e3 / seeds, "ms");
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#include "Benchmark.h"
+
+#include "raytracer/BVH.h"
+#include "raytracer/SceneFile.h"
+#include "raytracer/Sphere.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace {
+
+// A .scene file with N small spheres in a cube whose volume grows with N and 16 materials.
+void writeRandomScene(const std::string& path, int count, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const double extent = 10.0 * std::cbrt(static_cast<double>(count));
+
+	std::ofstream file(path);
+	file << "camera lookfrom 0 0 " << extent << " lookat 0 0 0 vfov 60\n";
+	for (int m = 0; m < 16; ++m)
+		file << "material m" << m << " lambertian " << unit(rng) << ' ' << unit(rng) << ' ' << unit(rng) << '\n';
+	for (int i = 0; i < count; ++i) {
+		file << "sphere " << extent * (unit(rng) - 0.5) << ' ' << extent * (unit(rng) - 0.5) << ' '
+			 << extent * (unit(rng) - 0.5) << ' ' << 0.5 + unit(rng) << " m" << i % 16 << '\n';
+	}
+}
+
+}
+
+PHOTON_BENCHMARK(scene_load)
+{
+	namespace fs = std::filesystem;
+
+	for (int count : { 10'000, 100'000, 1'000'000 }) {
+		std::mt19937 rng(1234);
+		const auto config = "spheres=" + std::to_string(count);
+		const auto path = (fs::temp_directory_path() / ("photon_bench_" + std::to_string(count) + ".scene")).string();
+		const auto cache_path = path + scene_cache_suffix;
+		writeRandomScene(path, count, rng);
+		fs::remove(cache_path);
+
+		// The old way: one make_shared per sphere and a BVH built over them at every start.
+		SceneDescription description;
+		std::string error;
+		const double parse_time = timeSeconds([&] { (void)parseSceneText(path, description, error); });
+		std::unique_ptr<BVH> objects;
+		const double build_time = timeSeconds([&] {
+			HittableList list;
+			for (const auto& sphere : description.spheres) {
+				const Point3 center(sphere.center[0], sphere.center[1], sphere.center[2]);
+				list.add(std::make_shared<Sphere>(center, static_cast<real>(sphere.radius), sphere.material));
+			}
+			objects = std::make_unique<BVH>(list);
+		});
+		report("scene_load", config, "parse_time", parse_time * 1e3, "ms");
+		report("scene_load", config, "shared_ptr_build_time", build_time * 1e3, "ms");
+
+		LoadedScene first, cached;
+		const double first_time = timeSeconds([&] { (void)loadScene(path, first, error); });
+		const double cached_time = timeSeconds([&] { (void)loadScene(path, cached, error); });
+		report("scene_load", config, "first_load_time", first_time * 1e3, "ms");
+		report("scene_load", config, "cached_load_time", cached_time * 1e3, "ms");
+		report("scene_load", config, "cache_size", fs::file_size(cache_path) / 1048576.0, "MiB");
+
+		// The mapped arrays against the pointer-based BVH over the same spheres.
+		const auto rays = randomRays(200'000, 10.0 * std::cbrt(static_cast<double>(count)), rng);
+		std::vector<real> object_t, mapped_t;
+		const double object_rate = rays.size() / castRays(*objects, rays, object_t);
+		const double mapped_rate = rays.size() / castRays(*cached.scene->world, rays, mapped_t);
+		report("scene_load", config, "object_bvh_rays_per_sec", object_rate, "rays/s");
+		report("scene_load", config, "mapped_bvh_rays_per_sec", mapped_rate, "rays/s");
+		report("scene_load", config, "hit_mismatches", std::abs(hitCount(object_t) - hitCount(mapped_t)), "");
+
+		first = cached = LoadedScene();
+		fs::remove(path);
+		fs::remove(cache_path);
+	}
+}
@@ -0,0 +1,89 @@
+#include "Benchmark.h"
+
+#include "raytracer/BVH.h"
+#include "raytracer/Raytracer.h"
+#include "raytracer/Sphere.h"
+#include "raytracer/Materials/AllMaterials.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace {
+
+constexpr int width = 320;
+constexpr int samples_per_pixel = 16;
+
+// The cover scene's field of small random spheres, grown to count spheres at the same density
+// around the same three large ones; the cover camera sees its middle.
+std::shared_ptr<Scene> makeSphereField(int count, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	auto scene = std::make_shared<Scene>();
+	HittableList spheres;
+	spheres.add(std::make_shared<Sphere>(Point3(0, -1000, 0), 1000, scene->materials.add(Lambertian(Color(0.5, 0.5, 0.5)))));
+
+	const double half_extent = std::sqrt(static_cast<double>(count)) / 2;
+	const auto random_color = [&] { return Color(unit(rng), unit(rng), unit(rng)); };
+	for (int i = 0; i < count; ++i) {
+		const Point3 center(half_extent * (2 * unit(rng) - 1), 0.2, half_extent * (2 * unit(rng) - 1));
+		const double choose_mat = unit(rng);
+		uint32_t material;
+		if (choose_mat < 0.8)
+			material = scene->materials.add(Lambertian(random_color() * random_color()));
+		else if (choose_mat < 0.95)
+			material = scene->materials.add(Metal(0.5 * random_color() + Color(0.5, 0.5, 0.5), 0.5 * unit(rng)));
+		else
+			material = scene->materials.add(Dielectric(1.5));
+		spheres.add(std::make_shared<Sphere>(center, 0.2, material));
+	}
+
+	spheres.add(std::make_shared<Sphere>(Point3(0, 1, 0), 1.0, scene->materials.add(Dielectric(1.5))));
+	spheres.add(std::make_shared<Sphere>(Point3(-4, 1, 0), 1.0, scene->materials.add(Lambertian(Color(0.4, 0.2, 0.1)))));
+	spheres.add(std::make_shared<Sphere>(Point3(4, 1, 0), 1.0, scene->materials.add(Metal(Color(0.7, 0.6, 0.5), 0.0))));
+	scene->world = std::make_shared<BVH>(spheres);
+	return scene;
+}
+
+// Mean of the linear image, which changes whenever the rendered samples do; comparing it across
+// commits tells an optimization apart from a change of the image.
+double meanRadiance(const std::vector<float>& rgb)
+{
+	double sum = 0.0;
+	for (const float value : rgb)
+		sum += value;
+	return sum / rgb.size();
+}
+
+void renderScene(const std::string& config, const Scene& scene, Camera camera, TileScheduler& scheduler)
+{
+	camera.samples_per_pixel = samples_per_pixel;
+	std::vector<float> image;
+	const double seconds = timeSeconds([&] { image = camera.renderLinear(scene, scheduler); });
+	report("scenes", config, "time", seconds * 1e3, "ms");
+	report("scenes", config, "samples_per_sec", camera.samplesTraced() / seconds, "samples/s");
+	report("scenes", config, "mrays_per_sec", camera.raysTraced() / seconds * 1e-6, "Mrays/s");
+	report("scenes", config, "mean_radiance", meanRadiance(image), "");
+}
+
+}
+
+// Whole renders on the pool at a fixed size and sample count: the demo scene, the cover scene and
+// random sphere fields from a hundred to a million spheres.
+PHOTON_BENCHMARK(scenes)
+{
+	TileScheduler scheduler;
+	const auto threads = " threads=" + std::to_string(scheduler.threadCount());
+
+	renderScene("demo" + threads, *makeDemoScene(), makeDemoCamera(width), scheduler);
+	renderScene("cover" + threads, *makeCoverScene(), makeCoverCamera(width), scheduler);
+
+	for (int count : { 100, 10'000, 1'000'000 }) {
+		std::mt19937 rng(count);
+		std::shared_ptr<Scene> scene;
+		const double build_time = timeSeconds([&] { scene = makeSphereField(count, rng); });
+		const auto config = "spheres=" + std::to_string(count) + threads;
+		report("scenes", config, "build_time", build_time * 1e3, "ms");
+		renderScene(config, *scene, makeCoverCamera(width), scheduler);
+	}
+}
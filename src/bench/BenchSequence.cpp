@@ -0,0 +1,63 @@
+#include "Benchmark.h"
+
+#include "raytracer/ImageIO.h"
+#include "raytracer/Raytracer.h"
+#include "raytracer/Sequence.h"
+
+#include <filesystem>
+#include <string>
+
+// A turntable of the instances scene, rendered the way a script of single-frame renders does it
+// (build the scene, start the threads, trace, tone map and write, once per frame) against one
+// sequence render, which builds and starts once and writes while the next frame traces.
+PHOTON_BENCHMARK(sequence)
+{
+	namespace fs = std::filesystem;
+	constexpr int frames = 6;
+	constexpr uint32_t instances = 100'000;
+	const auto directory = fs::temp_directory_path() / "photon_bench_sequence";
+	fs::create_directories(directory);
+	const auto pattern = (directory / "frame_##.png").string();
+
+	auto makeCamera = [] {
+		Camera camera = makeInstanceCamera(480);
+		camera.samples_per_pixel = 2;
+		return camera;
+	};
+	const auto path = CameraPath::turntable(makeCamera(), frames);
+
+	const auto config = "instances=" + std::to_string(instances) + " frames=" + std::to_string(frames);
+	const double separate = timeSeconds([&] {
+		for (int frame = 0; frame < frames; ++frame) {
+			const auto scene = makeInstanceScene(instances);
+			Camera camera = makeCamera();
+			const auto key = path.at(frame);
+			camera.setView(key.lookfrom, key.lookat, key.vfov, key.focus_dist);
+			camera.frame = static_cast<uint32_t>(frame);
+			TileScheduler scheduler(camera.thread_count);
+			const auto rgba = camera.render(*scene, scheduler);
+			if (!writePNG(framePath(pattern, frame), rgba, camera.image_width, camera.imageHeight()))
+				report("sequence", config, "write_failures", 1, "");
+		}
+	});
+	report("sequence", config + " separate", "frame_time", separate / frames * 1e3, "ms");
+
+	SequenceReport sequence;
+	const double together = timeSeconds([&] {
+		const auto scene = makeInstanceScene(instances);
+		const Camera camera = makeCamera();
+		TileScheduler scheduler(camera.thread_count);
+		SequenceSettings settings;
+		settings.last_frame = frames - 1;
+		settings.output = pattern;
+		std::string error;
+		if (!renderSequence(camera, *scene, path, scheduler, settings, sequence, error))
+			report("sequence", config, "write_failures", 1, "");
+	});
+	report("sequence", config + " sequence", "frame_time", together / frames * 1e3, "ms");
+	report("sequence", config + " sequence", "write_time", sequence.write_seconds / frames * 1e3, "ms");
+	report("sequence", config + " sequence", "stall_time", sequence.stall_seconds / frames * 1e3, "ms");
+	report("sequence", config, "speedup", separate / together, "x");
+
+	fs::remove_all(directory);
+}
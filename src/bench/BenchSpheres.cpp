@@ -0,0 +1,54 @@
+#include "Benchmark.h"
+
+#include "raytracer/HittableList.h"
+#include "raytracer/PackedSpheres.h"
+#include "raytracer/Sphere.h"
+#include "raytracer/Materials/AllMaterials.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+
+PHOTON_BENCHMARK(packed_spheres)
+{
+	// Sphere counts around the demo scene's size, where a flat list beats a BVH.
+	for (int count : { 5, 16, 64, 256 }) {
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+		HittableList list;
+		PackedSpheres packed;
+		for (int i = 0; i < count; ++i) {
+			const Point3 center(8.0 * (unit(rng) - 0.5), 8.0 * (unit(rng) - 0.5), -4.0 - 8.0 * unit(rng));
+			const double radius = 0.2 + 0.5 * unit(rng);
+			list.add(std::make_shared<Sphere>(center, radius, 0));
+			packed.add(center, radius, 0);
+		}
+
+		std::vector<Ray> rays;
+		for (int i = 0; i < 200'000; ++i)
+			rays.emplace_back(Point3(0, 0, 0), Vec3(unit(rng) - 0.5, unit(rng) - 0.5, -1.0));
+
+		auto rate = [&](const Hittable& world, double& t_sum) {
+			t_sum = 0.0;
+			const double seconds = timeSeconds([&] {
+				HitRecord rec;
+				for (const auto& ray : rays) {
+					if (world.hit(ray, Interval(0.001, infinity), rec))
+						t_sum += rec.t;
+				}
+			});
+			return rays.size() / seconds;
+		};
+
+		double list_sum = 0.0, packed_sum = 0.0;
+		const double list_rate = rate(list, list_sum);
+		const double packed_rate = rate(packed, packed_sum);
+
+		const auto config = "spheres=" + std::to_string(count);
+		report("packed", config, "list_rays_per_sec", list_rate, "rays/s");
+		report("packed", config, "packed_rays_per_sec", packed_rate, "rays/s");
+		report("packed", config, "speedup", packed_rate / list_rate, "x");
+		report("packed", config, "t_sum_rel_error", std::abs(packed_sum - list_sum) / list_sum, "");
+	}
+}
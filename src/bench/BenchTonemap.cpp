@@ -0,0 +1,72 @@
+#include "Benchmark.h"
+
+#include "raytracer/Tonemap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace {
+
+// The per-pixel path the renderer used before the tonemap pass: gamma 2 in double precision,
+// one pixel at a time.
+void writeColorPerPixel(const std::vector<float>& rgb, std::vector<uint8_t>& rgba, int width, int height)
+{
+	for (int j = 0; j < height; ++j) {
+		for (int i = 0; i < width; ++i) {
+			const auto p = static_cast<size_t>(j) * width + i;
+			for (int c = 0; c < 3; ++c) {
+				const double v = rgb[3 * p + c] > 0 ? std::sqrt(static_cast<double>(rgb[3 * p + c])) : 0.0;
+				rgba[4 * p + c] = static_cast<uint8_t>(256 * std::clamp(v, 0.0, 0.999));
+			}
+			rgba[4 * p + 3] = 255;
+		}
+	}
+}
+
+// Best of a few runs, in pixels per second.
+template <typename Fn>
+double pixelsPerSecond(double pixels, Fn&& fn)
+{
+	return pixels / bestSeconds(5, fn);
+}
+
+}
+
+// Linear framebuffer to RGBA8 at 1080p: the old per-pixel conversion against the vectorized
+// pass, on one thread and on the pool.
+PHOTON_BENCHMARK(tonemap)
+{
+	constexpr int width = 1920;
+	constexpr int height = 1080;
+	constexpr double pixels = static_cast<double>(width) * height;
+
+	// A smooth gradient with highlights up to 4, so every curve takes both its branches.
+	std::vector<float> rgb(static_cast<size_t>(width) * height * 3);
+	for (int j = 0; j < height; ++j) {
+		for (int i = 0; i < width; ++i) {
+			for (int c = 0; c < 3; ++c)
+				rgb[3 * (static_cast<size_t>(j) * width + i) + c] = 4.0f * i / width * (c + 1) / 3 + 0.001f * j / height;
+		}
+	}
+	std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+
+	report("tonemap", "per-pixel gamma2", "mpixels_per_sec",
+		   pixelsPerSecond(pixels, [&] { writeColorPerPixel(rgb, rgba, width, height); doNotOptimize(rgba); }) * 1e-6, "Mpixels/s");
+
+	TileScheduler scheduler;
+	const auto pool = " pool threads=" + std::to_string(scheduler.threadCount());
+	for (auto curve : { ToneCurve::Gamma2, ToneCurve::SRGB, ToneCurve::ACES }) {
+		for (bool dither : { false, true }) {
+			const DisplaySettings settings{ 0.0f, curve, dither };
+			const auto config = std::string(toneCurveName(curve)) + (dither ? " dither" : "");
+			const Tile image{ 0, 0, width, height };
+			report("tonemap", config + " threads=1", "mpixels_per_sec",
+				   pixelsPerSecond(pixels, [&] { toneMapTile(rgb, rgba, width, image, settings); doNotOptimize(rgba); }) * 1e-6,
+				   "Mpixels/s");
+			report("tonemap", config + pool, "mpixels_per_sec",
+				   pixelsPerSecond(pixels, [&] { toneMap(rgb, rgba, width, height, settings, scheduler); doNotOptimize(rgba); }) * 1e-6,
+				   "Mpixels/s");
+		}
+	}
+}
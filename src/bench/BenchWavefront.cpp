@@ -0,0 +1,59 @@
+#include "Benchmark.h"
+
+#include "raytracer/Camera.h"
+#include "raytracer/PackedSpheres.h"
+#include "raytracer/Materials/AllMaterials.h"
+
+#include <string>
+
+namespace {
+
+// Many spheres of all three material types, so shading batches actually differ from ray order.
+Scene mixedScene()
+{
+	Scene scene;
+	auto world = std::make_shared<PackedSpheres>();
+	world->add(Point3(0, -1000, 0), 1000, scene.materials.add(Lambertian(Color(0.5, 0.5, 0.5))));
+	for (int a = -8; a < 8; ++a) {
+		for (int b = -8; b < 8; ++b) {
+			const Point3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+			const double choose = random_double();
+			uint32_t material;
+			if (choose < 0.6)
+				material = scene.materials.add(Lambertian(Color::random() * Color::random()));
+			else if (choose < 0.85)
+				material = scene.materials.add(Metal(Color::random(0.5, 1), random_double(0, 0.5)));
+			else
+				material = scene.materials.add(Dielectric(1.5));
+			world->add(center, 0.2, material);
+		}
+	}
+	scene.world = world;
+	return scene;
+}
+
+}
+
+PHOTON_BENCHMARK(wavefront)
+{
+	seed_random(0, 0, 0, 17);
+	const auto scene = mixedScene();
+
+	for (int width : { 320, 1280 }) {
+		std::vector<uint8_t> images[2];
+		for (auto mode : { ExecutionMode::PathByPath, ExecutionMode::Wavefront }) {
+			Camera camera(width, 16.0 / 9.0, 16, 10, 20.0, Point3(13, 2, 3), Point3(0, 0, 0), Vec3(0, 1, 0), 0.6, 10.0);
+			camera.execution_mode = mode;
+
+			auto& image = images[mode == ExecutionMode::Wavefront];
+			const double seconds = timeSeconds([&] { image = camera.render(scene); });
+			const auto config = "width=" + std::to_string(width) + (mode == ExecutionMode::Wavefront ? " wavefront" : " path");
+			report("wavefront", config, "samples_per_sec", camera.samplesTraced() / seconds, "samples/s");
+		}
+
+		size_t differing = 0;
+		for (size_t i = 0; i < images[0].size(); ++i)
+			differing += images[0][i] != images[1][i];
+		report("wavefront", "width=" + std::to_string(width), "differing_channels", static_cast<double>(differing), "");
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "raytracer/Hittable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// Minimal self-registering benchmark harness for photon_bench.
+// A benchmark is a plain function that times its own kernels and records results with report().
+// Inputs come from fixed seeds, so runs of different commits and builds measure the same work and
+// their JSON output (photon_bench --json) can be compared metric by metric.
+
+using BenchmarkFunction = void (*)();
+
+struct Benchmark {
+	const char* name;
+	BenchmarkFunction run;
+};
+
+[[nodiscard]] std::vector<Benchmark>& registeredBenchmarks();
+
+struct BenchmarkRegistrar {
+	BenchmarkRegistrar(const char* name, BenchmarkFunction run) {
+		registeredBenchmarks().push_back(Benchmark{ name, run });
+	}
+};
+
+#define PHOTON_BENCHMARK(name)                                                         \
+	static void benchmark_##name();                                                    \
+	static const BenchmarkRegistrar benchmark_##name##_registrar(#name, &benchmark_##name); \
+	static void benchmark_##name()
+
+// Records one measurement, e.g. report("bvh", "spheres=10000", "rays_per_sec", 1.2e7, "rays/s").
+void report(const std::string& benchmark, const std::string& config, const std::string& metric,
+			double value, const std::string& unit);
+
+// Error of a linear RGB image (3 floats per pixel) against a reference of the same size.
+struct ImageError {
+	double rmse = 0.0;		// Linear RGB
+	double rel_mse = 0.0;	// Squared error over the squared reference, which weighs dark pixels as much as bright ones
+	double psnr = 0.0;		// Of the gamma-encoded image clamped to [0, 1], in dB
+};
+
+[[nodiscard]] ImageError imageError(const std::vector<float>& image, const std::vector<float>& reference);
+
+// RMSE of two RGBA8 images of the same size in display (gamma-encoded) units, alpha ignored.
+[[nodiscard]] double displayRmse(const std::vector<uint8_t>& image, const std::vector<uint8_t>& reference);
+
+// Rays from random points inside a cube of side extent around the origin towards random directions.
+[[nodiscard]] std::vector<Ray> randomRays(int count, double extent, std::mt19937& rng);
+
+// Traces every ray against world and returns the wall time in seconds. distances gets the distance
+// of each ray's closest hit, or -1 where it missed.
+double castRays(const Hittable& world, std::span<const Ray> rays, std::vector<real>& distances);
+
+// Rays that hit something, out of the distances castRays() gave.
+[[nodiscard]] inline int hitCount(const std::vector<real>& distances)
+{
+	return static_cast<int>(std::count_if(distances.begin(), distances.end(), [](real t) { return t >= 0; }));
+}
+
+// Wall time of one call of fn in seconds.
+template <typename Fn>
+[[nodiscard]] double timeSeconds(Fn&& fn)
+{
+	const auto start = std::chrono::steady_clock::now();
+	fn();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Shortest wall time of runs calls of fn in seconds, for kernels short enough that the noise of
+// one run matters.
+template <typename Fn>
+[[nodiscard]] double bestSeconds(int runs, Fn&& fn)
+{
+	double best = timeSeconds(fn);
+	for (int run = 1; run < runs; ++run)
+		best = std::min(best, timeSeconds(fn));
+	return best;
+}
+
+// Keeps the optimizer from discarding a computed value.
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static volatile const T* sink;
+	sink = &value;
+#endif
+}
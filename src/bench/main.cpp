@@ -0,0 +1,286 @@
+#include "Benchmark.h"
+
+#include "raytracer/RenderStats.h"
+#include "raytracer/Vec3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <tuple>
+
+namespace {
+
+struct Result {
+	std::string benchmark;
+	std::string config;
+	std::string metric;
+	double value;
+	std::string unit;
+};
+
+using ResultKey = std::tuple<std::string, std::string, std::string>;
+
+std::vector<Result> results;
+std::map<ResultKey, double> baseline;
+
+std::string jsonString(std::string_view text)
+{
+	std::string quoted = "\"";
+	for (const char c : text) {
+		if (c == '"' || c == '\\') {
+			quoted += '\\';
+			quoted += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20) {
+			char escape[8];
+			std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+			quoted += escape;
+		}
+		else {
+			quoted += c;
+		}
+	}
+	return quoted + '"';
+}
+
+// JSON has no infinities or NaNs; a metric that has none of its own (a PSNR of identical images)
+// is written as null.
+std::string jsonNumber(double value)
+{
+	if (!std::isfinite(value))
+		return "null";
+	char text[32];
+	std::snprintf(text, sizeof(text), "%.9g", value);
+	return text;
+}
+
+// What the numbers were measured on, so results of different builds are not mistaken for each
+// other.
+std::string contextJson(const std::string& label)
+{
+	const auto now = std::time(nullptr);
+	char date[32];
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+#if defined(__clang__)
+	const std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	const std::string compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	const std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+	const std::string compiler = "unknown";
+#endif
+#ifdef NDEBUG
+	constexpr bool optimized = true;
+#else
+	constexpr bool optimized = false;
+#endif
+#ifdef __AVX2__
+	constexpr bool avx2 = true;
+#else
+	constexpr bool avx2 = false;
+#endif
+
+	std::ostringstream json;
+	json << "{\n"
+		 << "    \"label\": " << jsonString(label) << ",\n"
+		 << "    \"date\": " << jsonString(date) << ",\n"
+		 << "    \"compiler\": " << jsonString(compiler) << ",\n"
+		 << "    \"ndebug\": " << (optimized ? "true" : "false") << ",\n"
+		 << "    \"real\": " << jsonString(sizeof(real) == sizeof(float) ? "float" : "double") << ",\n"
+		 << "    \"avx2\": " << (avx2 ? "true" : "false") << ",\n"
+		 << "    \"stats\": " << (render_stats_enabled ? "true" : "false") << ",\n"
+		 << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << "\n"
+		 << "  }";
+	return json.str();
+}
+
+bool writeJson(const std::string& path, const std::string& label)
+{
+	std::ofstream file(path);
+	file << "{\n  \"context\": " << contextJson(label) << ",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const auto& r = results[i];
+		file << "    {\"benchmark\": " << jsonString(r.benchmark) << ", \"config\": " << jsonString(r.config)
+			 << ", \"metric\": " << jsonString(r.metric) << ", \"value\": " << jsonNumber(r.value)
+			 << ", \"unit\": " << jsonString(r.unit) << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	file << "  ]\n}\n";
+	return static_cast<bool>(file);
+}
+
+// The string value of key in one result line of writeJson(), unescaped.
+bool jsonField(std::string_view line, std::string_view key, std::string& value)
+{
+	std::string pattern;
+	pattern.reserve(key.size() + 4);
+	pattern += '"';
+	pattern += key;
+	pattern += "\": \"";
+	auto at = line.find(pattern);
+	if (at == std::string_view::npos)
+		return false;
+	value.clear();
+	for (at += pattern.size(); at < line.size() && line[at] != '"'; ++at) {
+		if (line[at] == '\\' && at + 1 < line.size()) {
+			++at;
+			if (line[at] == 'u' && at + 4 < line.size()) {
+				value += static_cast<char>(std::strtol(std::string(line.substr(at + 1, 4)).c_str(), nullptr, 16));
+				at += 4;
+				continue;
+			}
+		}
+		value += line[at];
+	}
+	return at < line.size();
+}
+
+// Reads the results of an earlier --json run. Only the layout writeJson() produces is understood:
+// one result per line.
+bool readBaseline(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+	std::string line;
+	while (std::getline(file, line)) {
+		std::string benchmark, config, metric;
+		const auto value_at = line.find("\"value\": ");
+		if (value_at == std::string::npos || !jsonField(line, "benchmark", benchmark) || !jsonField(line, "config", config)
+			|| !jsonField(line, "metric", metric))
+			continue;
+		const char* number = line.c_str() + value_at + std::strlen("\"value\": ");
+		char* end;
+		const double value = std::strtod(number, &end);
+		if (end != number)
+			baseline[{ benchmark, config, metric }] = value;
+	}
+	return true;
+}
+
+}
+
+std::vector<Benchmark>& registeredBenchmarks()
+{
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+void report(const std::string& benchmark, const std::string& config, const std::string& metric,
+			double value, const std::string& unit)
+{
+	results.push_back(Result{ benchmark, config, metric, value, unit });
+	std::printf("%-12s %-28s %-20s %14.4g %s", benchmark.c_str(), config.c_str(), metric.c_str(), value, unit.c_str());
+	if (const auto before = baseline.find({ benchmark, config, metric }); before != baseline.end() && before->second != 0.0)
+		std::printf("%*s x%.3f of baseline", static_cast<int>(10 - std::min<size_t>(unit.size(), 10)), "", value / before->second);
+	std::printf("\n");
+	std::fflush(stdout);
+}
+
+ImageError imageError(const std::vector<float>& image, const std::vector<float>& reference)
+{
+	double squared = 0.0, relative = 0.0, display = 0.0;
+	for (size_t i = 0; i < image.size(); ++i) {
+		const double d = image[i] - reference[i];
+		squared += d * d;
+		relative += d * d / (reference[i] * reference[i] + 1e-2);
+		const auto encode = [](double v) { return std::sqrt(std::clamp(v, 0.0, 1.0)); };
+		const double e = encode(image[i]) - encode(reference[i]);
+		display += e * e;
+	}
+	const double n = static_cast<double>(image.size());
+	return ImageError{ std::sqrt(squared / n), relative / n, -10.0 * std::log10(display / n) };
+}
+
+double displayRmse(const std::vector<uint8_t>& image, const std::vector<uint8_t>& reference)
+{
+	double sum = 0.0;
+	size_t n = 0;
+	for (size_t i = 0; i < image.size(); ++i) {
+		if (i % 4 == 3)
+			continue;
+		const double d = (image[i] - reference[i]) / 255.0;
+		sum += d * d;
+		++n;
+	}
+	return std::sqrt(sum / n);
+}
+
+std::vector<Ray> randomRays(int count, double extent, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	std::vector<Ray> rays;
+	rays.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		const Point3 origin(extent * (unit(rng) - 0.5), extent * (unit(rng) - 0.5), extent * (unit(rng) - 0.5));
+		const Vec3 direction(unit(rng) - 0.5, unit(rng) - 0.5, unit(rng) - 0.5);
+		rays.emplace_back(origin, direction);
+	}
+	return rays;
+}
+
+double castRays(const Hittable& world, std::span<const Ray> rays, std::vector<real>& distances)
+{
+	distances.assign(rays.size(), -1);
+	return timeSeconds([&] {
+		HitRecord rec;
+		for (size_t i = 0; i < rays.size(); ++i) {
+			if (world.hit(rays[i], Interval(0.001, infinity), rec))
+				distances[i] = rec.t;
+		}
+	});
+}
+
+// Usage: photon_bench [--json PATH] [--label TEXT] [--baseline PATH] [--list] [filter]
+// Runs every benchmark whose name contains the filter, or all of them. --json writes the results
+// and the build they were measured with to PATH, labelled with TEXT (a commit, say); --baseline
+// prints each result as a multiple of the same metric in an earlier --json file.
+int main(int argc, char** argv)
+{
+	std::string filter, json_path, label, baseline_path;
+	bool list = false;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--list") {
+			list = true;
+		}
+		else if ((arg == "--json" || arg == "--label" || arg == "--baseline") && i + 1 < argc) {
+			(arg == "--json" ? json_path : arg == "--label" ? label : baseline_path) = argv[++i];
+		}
+		else if (arg.starts_with("--")) {
+			std::fprintf(stderr, "Usage: photon_bench [--json PATH] [--label TEXT] [--baseline PATH] [--list] [filter]\n");
+			return 1;
+		}
+		else {
+			filter = arg;
+		}
+	}
+
+	if (!baseline_path.empty() && !readBaseline(baseline_path)) {
+		std::fprintf(stderr, "Cannot read the baseline %s\n", baseline_path.c_str());
+		return 1;
+	}
+
+	for (const auto& benchmark : registeredBenchmarks()) {
+		if (std::strstr(benchmark.name, filter.c_str()) == nullptr)
+			continue;
+		if (list)
+			std::printf("%s\n", benchmark.name);
+		else
+			benchmark.run();
+	}
+
+	if (!json_path.empty() && !list && !writeJson(json_path, label)) {
+		std::fprintf(stderr, "Could not write %s\n", json_path.c_str());
+		return 1;
+	}
+	return 0;
+}
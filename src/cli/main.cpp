@@ -0,0 +1,717 @@
+#include "raytracer/Checkpoint.h"
+#include "raytracer/Denoiser.h"
+#include "raytracer/Distributed.h"
+#include "raytracer/ImageIO.h"
+#include "raytracer/Raytracer.h"
+#include "raytracer/SceneFile.h"
+#include "raytracer/Sequence.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+namespace {
+
+struct Options {
+	std::string scene = "demo";
+	int width = 1280;
+	int height = 720;
+	int samples_per_pixel = 0;	// 0 = the scene's default
+	int max_depth = 0;			// 0 = the scene's default
+	int threads = 0;
+	uint32_t seed = 0;
+	uint32_t instances = 10000;	// Copies in the instances scene
+	uint32_t lights = 64;		// Small lights in the lights scene
+	SamplerType sampler = SamplerType::Sobol;
+	bool wavefront = false;
+	bool light_sampling = true;
+	bool denoise = false;
+	DisplaySettings display;	// Of .png and .ppm output
+	std::string output = "photon.png";
+	std::string features;		// Prefix of the feature images, empty = none
+	std::string stats;			// JSON file for the render counters, empty = none
+	std::string checkpoint;		// Where render progress is saved, empty = nowhere
+	double checkpoint_interval = 300.0;	// Seconds between checkpoints
+	bool resume = false;		// Continue the render in checkpoint
+	std::string camera_path;	// Keyframe file of an animation, empty = none
+	int turntable = 0;			// Frames of a turntable animation, 0 = none
+	int first_frame = 0;		// Frame range of an animation, last < first = all of it
+	int last_frame = -1;
+	int workers = 0;			// Worker processes to start on this machine
+	std::string listen;			// [HOST:]PORT to accept workers on, empty = a free local port
+	std::string worker;			// HOST:PORT of the coordinator to work for, empty = not a worker
+	double worker_timeout = 300.0;	// Seconds a worker may return no tile before its tiles go to others
+	bool help = false;			// Print the usage and exit
+};
+
+void printUsage(FILE* out)
+{
+	std::fprintf(out,
+		"Usage: photon-render [options]\n"
+		"  -h, --help          print this help\n"
+		"  --scene NAME|FILE   demo | cover | instances | lights | a .scene file or its .scene.bin cache (default demo)\n"
+		"  --instances N       mesh copies in the instances scene (default 10000)\n"
+		"  --lights N          small lights in the lights scene (default 64)\n"
+		"  --size WxH          image resolution (default 1280x720)\n"
+		"  --spp N             samples per pixel (default: the scene's)\n"
+		"  --max-depth N       maximum bounces (default: the scene's)\n"
+		"  --threads N         render threads, 0 = all hardware threads (default 0)\n"
+		"  --sampler NAME      independent | stratified | sobol (default sobol)\n"
+		"  --seed N            noise seed (default 0)\n"
+		"  --wavefront         trace tiles as ray queues instead of path by path\n"
+		"  --no-light-sampling find lights only by scattering, without shadow rays towards them\n"
+		"  --denoise           filter the image guided by its albedo, normal and depth before writing it\n"
+		"  --exposure STOPS    scale the radiance by 2^STOPS before tone mapping (default 0)\n"
+		"  --tonemap CURVE     gamma2 | srgb | aces (default gamma2)\n"
+		"  --dither            dither before quantizing to 8 bits\n"
+		"  --output PATH       .png, .ppm, or linear .pfm or .exr (default photon.png)\n"
+		"  --features PREFIX   also write PREFIX_albedo.png, PREFIX_normal.png and PREFIX_depth.png\n"
+		"  --stats PATH        write the render counters as JSON (needs PHOTON_ENABLE_STATS)\n"
+		"\n"
+		"Animation (--output is a pattern: the last run of # becomes the frame number):\n"
+		"  --camera-path FILE  render the frames of the camera keyframes in FILE\n"
+		"  --turntable N       render N frames of the camera circling its look-at point\n"
+		"  --frames A:B        only frames A to B (default all)\n"
+		"\n"
+		"Checkpoints:\n"
+		"  --checkpoint PATH   save the samples so far to PATH as the render goes, and on Ctrl+C; renders path by path\n"
+		"  --checkpoint-interval SECONDS  time between checkpoints (default 300)\n"
+		"  --resume            continue the render saved in --checkpoint; a larger --spp adds samples to a finished one\n"
+		"\n"
+		"Distributed rendering:\n"
+		"  --workers N         render the tiles in N worker processes on this machine\n"
+		"  --listen [HOST:]PORT  also accept workers started elsewhere with --worker (HOST default 0.0.0.0)\n"
+		"  --worker HOST:PORT  work for the coordinator at HOST:PORT; --threads applies, scene options come from it\n"
+		"  --worker-timeout SECONDS  hand out the tiles of a worker that returns none for this long (default 300)\n");
+}
+
+template <typename T>
+bool parseNumber(std::string_view text, T& value)
+{
+	const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return error == std::errc() && end == text.data() + text.size();
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "-h" || arg == "--help") {
+			options.help = true;
+			return true;
+		}
+		if (arg == "--wavefront") {
+			options.wavefront = true;
+			continue;
+		}
+		if (arg == "--no-light-sampling") {
+			options.light_sampling = false;
+			continue;
+		}
+		if (arg == "--denoise") {
+			options.denoise = true;
+			continue;
+		}
+		if (arg == "--dither") {
+			options.display.dither = true;
+			continue;
+		}
+		if (arg == "--resume") {
+			options.resume = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+			return false;
+		}
+
+		const std::string_view value = argv[++i];
+		bool ok = true;
+		if (arg == "--scene") {
+			options.scene = value;
+		}
+		else if (arg == "--size") {
+			const auto x = value.find('x');
+			ok = x != std::string_view::npos && parseNumber(value.substr(0, x), options.width)
+				&& parseNumber(value.substr(x + 1), options.height) && options.width > 0 && options.height > 0;
+		}
+		else if (arg == "--spp") {
+			ok = parseNumber(value, options.samples_per_pixel) && options.samples_per_pixel > 0;
+		}
+		else if (arg == "--max-depth") {
+			ok = parseNumber(value, options.max_depth) && options.max_depth > 0;
+		}
+		else if (arg == "--threads") {
+			ok = parseNumber(value, options.threads) && options.threads >= 0;
+		}
+		else if (arg == "--instances") {
+			ok = parseNumber(value, options.instances) && options.instances > 0;
+		}
+		else if (arg == "--lights") {
+			ok = parseNumber(value, options.lights) && options.lights > 0;
+		}
+		else if (arg == "--seed") {
+			ok = parseNumber(value, options.seed);
+		}
+		else if (arg == "--sampler") {
+			ok = false;
+			for (auto type : { SamplerType::Independent, SamplerType::Stratified, SamplerType::Sobol }) {
+				if (value == samplerName(type)) {
+					options.sampler = type;
+					ok = true;
+				}
+			}
+		}
+		else if (arg == "--exposure") {
+			ok = parseNumber(value, options.display.exposure) && std::isfinite(options.display.exposure);
+		}
+		else if (arg == "--tonemap") {
+			ok = false;
+			for (auto curve : { ToneCurve::Gamma2, ToneCurve::SRGB, ToneCurve::ACES }) {
+				if (value == toneCurveName(curve)) {
+					options.display.curve = curve;
+					ok = true;
+				}
+			}
+		}
+		else if (arg == "--output") {
+			options.output = value;
+		}
+		else if (arg == "--features") {
+			options.features = value;
+		}
+		else if (arg == "--stats") {
+			options.stats = value;
+		}
+		else if (arg == "--checkpoint") {
+			options.checkpoint = value;
+		}
+		else if (arg == "--worker-timeout") {
+			ok = parseNumber(value, options.worker_timeout) && options.worker_timeout > 0;
+		}
+		else if (arg == "--checkpoint-interval") {
+			ok = parseNumber(value, options.checkpoint_interval) && options.checkpoint_interval >= 0;
+		}
+		else if (arg == "--camera-path") {
+			options.camera_path = value;
+		}
+		else if (arg == "--turntable") {
+			ok = parseNumber(value, options.turntable) && options.turntable > 0;
+		}
+		else if (arg == "--frames") {
+			const auto colon = value.find(':');
+			ok = colon != std::string_view::npos && parseNumber(value.substr(0, colon), options.first_frame)
+				&& parseNumber(value.substr(colon + 1), options.last_frame) && options.first_frame >= 0
+				&& options.last_frame >= options.first_frame;
+		}
+		else if (arg == "--workers") {
+			ok = parseNumber(value, options.workers) && options.workers >= 0;
+		}
+		else if (arg == "--listen") {
+			options.listen = value;
+		}
+		else if (arg == "--worker") {
+			options.worker = value;
+		}
+		else {
+			std::fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+			return false;
+		}
+
+		if (!ok) {
+			std::fprintf(stderr, "Invalid value '%s' for %s\n", argv[i], argv[i - 1]);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Splits "HOST:PORT", or a bare "PORT" if default_host is given.
+bool parseAddress(std::string_view text, const char* default_host, std::string& host, uint16_t& port)
+{
+	const auto colon = text.rfind(':');
+	if (colon == std::string_view::npos && !default_host)
+		return false;
+	host = colon == std::string_view::npos ? default_host : std::string(text.substr(0, colon));
+	return !host.empty() && parseNumber(text.substr(colon == std::string_view::npos ? 0 : colon + 1), port);
+}
+
+// Opens the scene of a job. Scene files come from disk on the coordinator and as the image the
+// coordinator sent on a worker; file receives them, so the image can be passed on.
+bool openScene(const RenderJob& job, std::shared_ptr<Scene>& scene, LoadedScene& file, std::string& error)
+{
+	if (job.scene == "demo") {
+		scene = makeDemoScene();
+	}
+	else if (job.scene == "cover") {
+		scene = makeCoverScene(job.seed);
+	}
+	else if (job.scene == "instances") {
+		scene = makeInstanceScene(job.instance_count, job.seed);
+	}
+	else if (job.scene == "lights") {
+		scene = makeLightsScene(job.light_count, job.seed);
+	}
+	else if (job.scene.ends_with(".scene") || job.scene.ends_with(std::string(".scene") + scene_cache_suffix)) {
+		if (job.scene_image.empty() ? !loadScene(job.scene, file, error)
+									: !openSceneImage(job.scene_image, job.scene_directory, file, error))
+			return false;
+		scene = file.scene;
+	}
+	else {
+		error = "Unknown scene '" + job.scene + "'";
+		return false;
+	}
+	return true;
+}
+
+// Identifies the scene of a job in checkpoints: by its compiled image if it comes from a file,
+// otherwise by what the built-in scene is made from.
+uint64_t sceneHash(const RenderJob& job, const LoadedScene& file)
+{
+	if (file.scene)
+		return hashBytes(file.image);
+	uint64_t hash = hashBytes(std::as_bytes(std::span(job.scene)));
+	for (const uint32_t value : { job.seed, job.instance_count, job.light_count })
+		hash = hashBytes(std::as_bytes(std::span(&value, 1)), hash);
+	return hash;
+}
+
+// Set by the first Ctrl+C or SIGTERM of a checkpointed render, which then saves and exits; a
+// second one kills the process as usual.
+std::atomic<bool> interrupted{false};
+
+void onInterrupt(int signal)
+{
+	interrupted.store(true, std::memory_order_relaxed);
+	std::signal(signal, SIG_DFL);
+}
+
+Camera sceneCamera(const std::string& name, int width, const LoadedScene& file)
+{
+	if (file.scene)
+		return file.camera.makeCamera(width);
+	if (name == "cover")
+		return makeCoverCamera(width);
+	if (name == "instances")
+		return makeInstanceCamera(width);
+	if (name == "lights")
+		return makeLightsCamera(width);
+	return makeDemoCamera(width);
+}
+
+int runWorker(const Options& options)
+{
+	std::string host;
+	uint16_t port = 0;
+	if (!parseAddress(options.worker, nullptr, host, port)) {
+		std::fprintf(stderr, "Invalid coordinator address '%s'\n", options.worker.c_str());
+		return 1;
+	}
+
+	// The coordinator may still be starting up.
+	std::string error;
+	Socket connection;
+	for (int attempt = 0; attempt < 100 && !connection.isOpen(); ++attempt) {
+		if (attempt > 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		connection = Socket::connect(host, port, error);
+	}
+	if (!connection.isOpen()) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	TileScheduler scheduler(options.threads);
+	const auto make_scene = [](const RenderJob& job, std::shared_ptr<Scene>& scene, std::string& scene_error) {
+		LoadedScene file;
+		return openScene(job, scene, file, scene_error);
+	};
+	if (!serveRenderJob(connection, make_scene, scheduler, error)) {
+		std::fprintf(stderr, "Worker: %s\n", error.c_str());
+		return 1;
+	}
+	return 0;
+}
+
+#ifdef _WIN32
+using Process = HANDLE;
+#else
+using Process = pid_t;
+#endif
+
+// Starts this executable again as a worker for the coordinator at host:port.
+bool startWorker(const char* self, const std::string& host, uint16_t port, int threads, std::vector<Process>& processes)
+{
+	const std::string address = host + ":" + std::to_string(port);
+	const std::string thread_count = std::to_string(threads);
+#ifdef _WIN32
+	(void)self;
+	char path[MAX_PATH];
+	if (GetModuleFileNameA(nullptr, path, MAX_PATH) == 0)
+		return false;
+	std::string command = std::string("\"") + path + "\" --worker " + address + " --threads " + thread_count;
+	STARTUPINFOA startup{};
+	startup.cb = sizeof(startup);
+	PROCESS_INFORMATION info{};
+	if (!CreateProcessA(path, command.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info))
+		return false;
+	CloseHandle(info.hThread);
+	processes.push_back(info.hProcess);
+#else
+	const char* argv[] = { self, "--worker", address.c_str(), "--threads", thread_count.c_str(), nullptr };
+	pid_t pid;
+	if (posix_spawnp(&pid, self, nullptr, nullptr, const_cast<char* const*>(argv), environ) != 0)
+		return false;
+	processes.push_back(pid);
+#endif
+	return true;
+}
+
+void waitForWorkers(std::span<const Process> processes)
+{
+	for (const auto process : processes) {
+#ifdef _WIN32
+		WaitForSingleObject(process, INFINITE);
+		CloseHandle(process);
+#else
+		waitpid(process, nullptr, 0);
+#endif
+	}
+}
+
+// Renders the frames of --camera-path or --turntable and prints how it went.
+int runSequence(const Options& options, const Camera& camera, const Scene& scene, TileScheduler& scheduler)
+{
+	CameraPath camera_path;
+	SequenceSettings settings;
+	std::string error;
+	if (options.turntable > 0) {
+		camera_path = CameraPath::turntable(camera, options.turntable);
+		settings.last_frame = options.turntable - 1;
+	}
+	else {
+		if (!loadCameraPath(options.camera_path, camera, camera_path, error)) {
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		settings.first_frame = static_cast<int>(std::ceil(camera_path.keyframes().front().frame));
+		settings.last_frame = static_cast<int>(std::floor(camera_path.keyframes().back().frame));
+	}
+	if (options.last_frame >= options.first_frame) {
+		settings.first_frame = options.first_frame;
+		settings.last_frame = options.last_frame;
+	}
+	settings.output = options.output;
+
+	SequenceReport report;
+	if (!renderSequence(camera, scene, camera_path, scheduler, settings, report, error)) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	std::printf("scene=%s\n", options.scene.c_str());
+	std::printf("resolution=%dx%d\n", camera.image_width, camera.imageHeight());
+	std::printf("spp=%d\n", camera.samples_per_pixel);
+	std::printf("threads=%d\n", scheduler.threadCount());
+	std::printf("frames=%d\n", report.frames);
+	std::printf("sequence_time_s=%.4f\n", report.seconds);
+	std::printf("frame_time_s=%.4f\n", report.seconds / std::max(report.frames, 1));
+	std::printf("trace_time_s=%.4f\n", report.trace_seconds);
+	std::printf("write_time_s=%.4f\n", report.write_seconds);
+	std::printf("stall_time_s=%.4f\n", report.stall_seconds);
+	std::printf("samples_per_sec=%.0f\n", report.samples / report.seconds);
+	std::printf("mrays_per_sec=%.3f\n", report.rays / report.seconds * 1e-6);
+	std::printf("output=%s\n", framePath(settings.output, settings.first_frame).c_str());
+	return 0;
+}
+
+// Writes PREFIX_albedo.png, PREFIX_normal.png with XYZ mapped from [-1, 1] to [0, 1], and
+// PREFIX_depth.png going from black at the camera to white at the farthest hit and in the sky.
+bool writeFeatures(const std::string& prefix, const FeatureBuffers& features)
+{
+	const int width = features.width;
+	const int height = features.height;
+	float farthest = 0.0f;
+	for (const float depth : features.depth) {
+		if (std::isfinite(depth))
+			farthest = std::max(farthest, depth);
+	}
+
+	std::vector<float> normal(features.normal.size()), depth(features.normal.size());
+	for (size_t p = 0; p < features.depth.size(); ++p) {
+		const float shade = farthest > 0.0f ? std::min(features.depth[p] / farthest, 1.0f) : 1.0f;
+		for (int c = 0; c < 3; ++c) {
+			normal[3 * p + c] = 0.5f * features.normal[3 * p + c] + 0.5f;
+			depth[3 * p + c] = shade;
+		}
+	}
+	return writePNG(prefix + "_albedo.png", to_rgba8(features.albedo, width, height), width, height)
+		&& writePNG(prefix + "_normal.png", to_rgba8(normal, width, height), width, height)
+		&& writePNG(prefix + "_depth.png", to_rgba8(depth, width, height), width, height);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage(stderr);
+		return 1;
+	}
+	if (options.help) {
+		printUsage(stdout);
+		return 0;
+	}
+
+	if (!options.worker.empty())
+		return runWorker(options);
+	const bool distributed = options.workers > 0 || !options.listen.empty();
+	const bool checkpointed = !options.checkpoint.empty();
+	if (checkpointed && distributed) {
+		std::fprintf(stderr, "--checkpoint does not work with distributed rendering\n");
+		return 1;
+	}
+	const bool sequence = !options.camera_path.empty() || options.turntable > 0;
+	if (sequence && (distributed || checkpointed || options.denoise || !options.features.empty() || !options.stats.empty())) {
+		std::fprintf(stderr, "Animations render locally, without --checkpoint, --denoise, --features or --stats\n");
+		return 1;
+	}
+	if (options.resume && !checkpointed) {
+		std::fprintf(stderr, "--resume needs the --checkpoint to continue\n");
+		return 1;
+	}
+	// Hours of samples are not overwritten by accident.
+	if (checkpointed && !options.resume && std::filesystem::exists(options.checkpoint)) {
+		std::fprintf(stderr, "%s exists, continue it with --resume or remove it\n", options.checkpoint.c_str());
+		return 1;
+	}
+
+	RenderJob job;
+	job.scene = options.scene;
+	job.seed = options.seed;
+	job.instance_count = options.instances;
+	job.light_count = options.lights;
+
+	std::shared_ptr<Scene> scene;
+	LoadedScene file;
+	const auto load_start = std::chrono::steady_clock::now();
+	std::string error;
+	if (!openScene(job, scene, file, error)) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		if (error.starts_with("Unknown scene"))
+			printUsage(stderr);
+		return 1;
+	}
+	if (distributed && file.scene) {
+		job.scene_image.assign(file.image.begin(), file.image.end());
+		job.scene_directory = std::filesystem::absolute(options.scene).parent_path().string();
+	}
+	Camera camera = sceneCamera(options.scene, options.width, file);
+	const std::chrono::duration<double> load_elapsed = std::chrono::steady_clock::now() - load_start;
+
+	// The camera derives its height from the aspect ratio; nudge the ratio down if rounding would
+	// lose a row.
+	double aspect_ratio = static_cast<double>(options.width) / options.height;
+	if (static_cast<int>(options.width / aspect_ratio) < options.height)
+		aspect_ratio = std::nextafter(aspect_ratio, 0.0);
+	camera = Camera(options.width, aspect_ratio, camera.samples_per_pixel, camera.max_depth, camera.vfov,
+					camera.lookfrom, camera.lookat, camera.vup, camera.defocus_angle, camera.focus_dist);
+
+	if (options.samples_per_pixel > 0)
+		camera.samples_per_pixel = options.samples_per_pixel;
+	if (options.max_depth > 0)
+		camera.max_depth = options.max_depth;
+	camera.thread_count = options.threads;
+	camera.seed = options.seed;
+	camera.sampler_type = options.sampler;
+	camera.execution_mode = options.wavefront ? ExecutionMode::Wavefront : ExecutionMode::PathByPath;
+	camera.light_sampling = options.light_sampling;
+
+	TileScheduler scheduler(camera.thread_count);
+	if (sequence)
+		return runSequence(options, camera, *scene, scheduler);
+	std::vector<float> linear;
+	FeatureBuffers features;
+	const bool need_features = options.denoise || !options.features.empty();
+	DistributedReport report;
+	CheckpointReport checkpoint_report;
+	const auto start = std::chrono::steady_clock::now();
+	if (checkpointed) {
+		RenderCheckpoint checkpoint;
+		if (options.resume && !loadCheckpoint(options.checkpoint, checkpoint, error)) {
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		CheckpointSettings settings;
+		settings.path = options.checkpoint;
+		settings.interval = options.checkpoint_interval;
+		settings.cancel = &interrupted;
+		std::signal(SIGINT, onInterrupt);
+		std::signal(SIGTERM, onInterrupt);
+		const bool rendered = renderCheckpointed(camera, *scene, sceneHash(job, file), scheduler, settings, checkpoint,
+												 checkpoint_report, error);
+		std::signal(SIGINT, SIG_DFL);
+		std::signal(SIGTERM, SIG_DFL);
+		if (!rendered) {
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		if (checkpoint_report.cancelled) {
+			std::fprintf(stderr, "Interrupted with %u of %d samples per pixel done, saved to %s; continue with --resume\n",
+						 checkpoint.completeSamples(), camera.samples_per_pixel, options.checkpoint.c_str());
+			return 130;
+		}
+		linear = checkpoint.average();
+		if (need_features)
+			camera.renderFeatures(*scene, scheduler, features);
+	}
+	else if (!distributed) {
+		linear = need_features ? camera.renderLinear(*scene, scheduler, features) : camera.renderLinear(*scene, scheduler);
+	}
+	else {
+		// Without --listen, only the local workers can reach the coordinator.
+		std::string host = "127.0.0.1";
+		uint16_t port = 0;
+		if (!options.listen.empty() && !parseAddress(options.listen, "0.0.0.0", host, port)) {
+			std::fprintf(stderr, "Invalid address '%s' for --listen\n", options.listen.c_str());
+			return 1;
+		}
+		Socket listener = Socket::listen(host, port, error);
+		if (!listener.isOpen()) {
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		if (!options.listen.empty())
+			std::fprintf(stderr, "Accepting workers on %s:%u\n", host.c_str(), listener.localPort());
+
+		// Local workers share the hardware threads unless told otherwise.
+		const int hardware_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+		const int worker_threads = options.threads > 0 ? options.threads : std::max(1, hardware_threads / std::max(options.workers, 1));
+		const std::string local_host = host == "0.0.0.0" || host == "::" ? "127.0.0.1" : host;
+		std::vector<Process> processes;
+		for (int i = 0; i < options.workers; ++i) {
+			if (!startWorker(argv[0], local_host, listener.localPort(), worker_threads, processes))
+				std::fprintf(stderr, "Could not start worker %d\n", i);
+		}
+
+		DistributedSettings settings;
+		settings.batch_timeout = options.worker_timeout;
+		const bool rendered = renderDistributed(camera, job, *scene, listener, scheduler, settings, linear, report, error);
+		listener.close();
+		waitForWorkers(processes);
+		for (const auto& message : report.worker_errors)
+			std::fprintf(stderr, "Worker: %s\n", message.c_str());
+		if (!rendered) {
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		// The workers only send colors; the features take one pass of camera rays here.
+		if (need_features)
+			camera.renderFeatures(*scene, scheduler, features);
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	double denoise_seconds = 0.0;
+	if (options.denoise) {
+		const auto denoise_start = std::chrono::steady_clock::now();
+		linear = denoise(linear, features, DenoiseSettings(), scheduler);
+		denoise_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - denoise_start).count();
+	}
+
+	const int width = camera.image_width;
+	const int height = camera.imageHeight();
+	bool written;
+	if (options.output.ends_with(".pfm")) {
+		written = writePFM(options.output, linear, width, height);
+	}
+	else if (options.output.ends_with(".exr")) {
+		written = writeEXR(options.output, linear, width, height);
+	}
+	else {
+		std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+		toneMap(linear, rgba, width, height, options.display, scheduler);
+		written = options.output.ends_with(".ppm") ? writePPM(options.output, rgba, width, height)
+												   : writePNG(options.output, rgba, width, height);
+	}
+	if (!written) {
+		std::fprintf(stderr, "Could not write %s\n", options.output.c_str());
+		return 1;
+	}
+	if (!options.features.empty() && !writeFeatures(options.features, features)) {
+		std::fprintf(stderr, "Could not write the feature images %s_*.png\n", options.features.c_str());
+		return 1;
+	}
+
+	if (!options.stats.empty()) {
+		if (!render_stats_enabled)
+			std::fprintf(stderr, "Built without PHOTON_ENABLE_STATS, the counters in %s are all zero\n", options.stats.c_str());
+		std::ofstream stats_file(options.stats);
+		const RenderStats& stats = distributed ? report.stats : checkpointed ? checkpoint_report.stats : camera.renderStats();
+		stats_file << stats.toJson(elapsed.count());
+		if (!stats_file) {
+			std::fprintf(stderr, "Could not write %s\n", options.stats.c_str());
+			return 1;
+		}
+	}
+
+	// One key=value per line, easy to grep from scripts tracking throughput across commits.
+	const double seconds = elapsed.count();
+	std::printf("scene=%s\n", options.scene.c_str());
+	std::printf("resolution=%dx%d\n", width, height);
+	std::printf("spp=%d\n", camera.samples_per_pixel);
+	std::printf("max_depth=%d\n", camera.max_depth);
+	std::printf("load_time_s=%.4f\n", load_elapsed.count());
+	std::printf("threads=%d\n", scheduler.threadCount());
+	std::printf("sampler=%s\n", samplerName(camera.sampler_type));
+	std::printf("mode=%s\n", options.wavefront && !checkpointed ? "wavefront" : "path");
+	std::printf("light_sampling=%d\n", camera.light_sampling ? 1 : 0);
+	std::printf("wall_time_s=%.4f\n", seconds);
+	if (options.denoise)
+		std::printf("denoise_time_s=%.4f\n", denoise_seconds);
+	if (distributed) {
+		std::printf("workers=%d\n", report.workers_joined);
+		std::printf("workers_lost=%d\n", report.workers_lost);
+		std::printf("tiles_reissued=%llu\n", static_cast<unsigned long long>(report.tiles_reissued));
+		std::printf("tiles_local=%llu\n", static_cast<unsigned long long>(report.tiles_local));
+	}
+	if (checkpointed) {
+		std::printf("checkpoints=%d\n", checkpoint_report.checkpoints_written);
+		std::printf("checkpoint_write_s=%.4f\n", checkpoint_report.write_seconds);
+	}
+	uint64_t samples = camera.samplesTraced();
+	uint64_t rays = camera.raysTraced();
+	if (distributed) {
+		samples = static_cast<uint64_t>(width) * height * camera.samples_per_pixel;
+		rays = report.rays;
+	}
+	else if (checkpointed) {
+		samples = checkpoint_report.samples;
+		rays = checkpoint_report.rays;
+	}
+	std::printf("samples_per_sec=%.0f\n", samples / seconds);
+	std::printf("mrays_per_sec=%.3f\n", rays / seconds * 1e-6);
+	std::printf("output=%s\n", options.output.c_str());
+	return 0;
+}
@@ -1,5 +1,5 @@
 #include "app/Application.h"
-#include "raytracer/color.h"
+#include "raytracer/Color.h"
 
 int main(){
 	runApplication();
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Interval.h"
+#include "Vec3.h"
+
+#include <algorithm>
+
+// Axis-aligned bounding box. The default box is empty and absorbs whatever is merged into it.
+class AABB {
+public:
+	Point3 min{ +infinity, +infinity, +infinity };
+	Point3 max{ -infinity, -infinity, -infinity };
+
+	constexpr AABB() noexcept = default;
+	constexpr AABB(const Point3& a, const Point3& b) noexcept
+		: min(std::min(a.x(), b.x()), std::min(a.y(), b.y()), std::min(a.z(), b.z()))
+		, max(std::max(a.x(), b.x()), std::max(a.y(), b.y()), std::max(a.z(), b.z())) {}
+
+	[[nodiscard]] constexpr bool isEmpty() const noexcept {
+		return min.x() > max.x() || min.y() > max.y() || min.z() > max.z();
+	}
+
+	constexpr AABB& expand(const Point3& p) noexcept {
+		for (int a = 0; a < 3; ++a) {
+			min[a] = std::min(min[a], p[a]);
+			max[a] = std::max(max[a], p[a]);
+		}
+		return *this;
+	}
+
+	constexpr AABB& expand(const AABB& box) noexcept {
+		for (int a = 0; a < 3; ++a) {
+			min[a] = std::min(min[a], box.min[a]);
+			max[a] = std::max(max[a], box.max[a]);
+		}
+		return *this;
+	}
+
+	[[nodiscard]] constexpr Point3 centroid() const noexcept { return real(0.5) * (min + max); }
+	[[nodiscard]] constexpr Vec3 extent() const noexcept { return max - min; }
+
+	[[nodiscard]] constexpr real surfaceArea() const noexcept {
+		if (isEmpty())
+			return 0;
+		const auto d = extent();
+		return 2 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+	}
+
+	[[nodiscard]] constexpr int longestAxis() const noexcept {
+		const auto d = extent();
+		if (d.x() > d.y())
+			return d.x() > d.z() ? 0 : 2;
+		return d.y() > d.z() ? 1 : 2;
+	}
+
+	// Slab test. inv_dir is the componentwise reciprocal of the ray direction, computed once per ray.
+	[[nodiscard]] bool hit(const Point3& origin, const Vec3& inv_dir, Interval ray_t) const noexcept {
+		for (int a = 0; a < 3; ++a) {
+			auto t0 = (min[a] - origin[a]) * inv_dir[a];
+			auto t1 = (max[a] - origin[a]) * inv_dir[a];
+			if (inv_dir[a] < 0)
+				std::swap(t0, t1);
+			// Widen the far slab by its rounding error so a ray grazing the box is never missed.
+			t1 *= 1 + 2 * error_gamma(3);
+
+			// Written so that a NaN slab (origin on the plane, axis-parallel ray) leaves the interval untouched.
+			ray_t.min = t0 > ray_t.min ? t0 : ray_t.min;
+			ray_t.max = t1 < ray_t.max ? t1 : ray_t.max;
+			if (ray_t.max < ray_t.min)
+				return false;
+		}
+		return true;
+	}
+};
+
+[[nodiscard]] inline constexpr AABB surrounding_box(AABB a, const AABB& b) noexcept {
+	return a.expand(b);
+}
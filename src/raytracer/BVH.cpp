@@ -0,0 +1,162 @@
+#include "BVH.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace {
+
+constexpr int bin_count = 16;
+constexpr double traversal_cost = 1.0;	// Relative to one primitive intersection
+constexpr int max_leaf_count = 0xFFFF;
+
+struct BVHBuilder {
+	std::span<const AABB> bounds;
+	std::vector<Point3> centroids;
+	std::vector<BVHNode>& nodes;
+	std::vector<uint32_t>& order;
+	int max_leaf_size;
+
+	uint32_t makeLeaf(uint32_t node_index, uint32_t begin, uint32_t end) {
+		nodes[node_index].offset = begin;
+		nodes[node_index].count = static_cast<uint16_t>(end - begin);
+		return node_index;
+	}
+
+	uint32_t build(uint32_t begin, uint32_t end, int depth) {
+		const auto node_index = static_cast<uint32_t>(nodes.size());
+		nodes.emplace_back();
+
+		AABB node_bounds, centroid_bounds;
+		for (auto i = begin; i < end; ++i) {
+			node_bounds.expand(bounds[order[i]]);
+			centroid_bounds.expand(centroids[order[i]]);
+		}
+		nodes[node_index].bounds = node_bounds;
+
+		const auto count = end - begin;
+		const bool small_enough = count <= static_cast<uint32_t>(max_leaf_size);
+		if (count == 1 || depth >= bvh_max_depth - 1)
+			return makeLeaf(node_index, begin, end);
+
+		const int axis = centroid_bounds.longestAxis();
+		const double axis_min = centroid_bounds.min[axis];
+		const double axis_extent = centroid_bounds.max[axis] - axis_min;
+		if (axis_extent <= 0.0 && small_enough)
+			return makeLeaf(node_index, begin, end);
+
+		// Past half the depth budget only median splits are made, which bounds the depth by log2(N).
+		uint32_t mid = begin;
+		if (axis_extent > 0.0 && depth < bvh_max_depth / 2) {
+			// Bin the centroids along the axis and sweep the bins for the cheapest SAH split.
+			struct Bin { AABB bounds; uint32_t count = 0; };
+			std::array<Bin, bin_count> bins{};
+			const double scale = bin_count / axis_extent;
+			auto binOf = [&](uint32_t prim) {
+				return std::min(bin_count - 1, static_cast<int>((centroids[prim][axis] - axis_min) * scale));
+			};
+			for (auto i = begin; i < end; ++i) {
+				auto& bin = bins[binOf(order[i])];
+				bin.bounds.expand(bounds[order[i]]);
+				++bin.count;
+			}
+
+			std::array<double, bin_count - 1> cost{};
+			AABB left;
+			uint32_t left_count = 0;
+			for (int b = 0; b < bin_count - 1; ++b) {
+				left.expand(bins[b].bounds);
+				left_count += bins[b].count;
+				cost[b] = left_count * left.surfaceArea();
+			}
+			AABB right;
+			uint32_t right_count = 0;
+			for (int b = bin_count - 1; b > 0; --b) {
+				right.expand(bins[b].bounds);
+				right_count += bins[b].count;
+				cost[b - 1] += right_count * right.surfaceArea();
+			}
+
+			const auto best = static_cast<int>(std::min_element(cost.begin(), cost.end()) - cost.begin());
+			const double split_cost = traversal_cost + cost[best] / node_bounds.surfaceArea();
+			const double leaf_cost = static_cast<double>(count);
+			if (split_cost >= leaf_cost && small_enough)
+				return makeLeaf(node_index, begin, end);
+
+			mid = static_cast<uint32_t>(std::partition(order.begin() + begin, order.begin() + end,
+				[&](uint32_t prim) { return binOf(prim) <= best; }) - order.begin());
+		}
+
+		if (mid == begin || mid == end) {
+			// Coincident centroids or a degenerate partition: fall back to an object median split.
+			mid = begin + count / 2;
+			std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+				[&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+		}
+
+		nodes[node_index].axis = static_cast<uint8_t>(axis);
+		build(begin, mid, depth + 1);	// Lands at node_index + 1
+		nodes[node_index].offset = build(mid, end, depth + 1);
+		return node_index;
+	}
+};
+
+}
+
+void buildBVH(std::span<const AABB> primitive_bounds, std::vector<BVHNode>& nodes,
+			  std::vector<uint32_t>& order, int max_leaf_size)
+{
+	nodes.clear();
+	order.resize(primitive_bounds.size());
+	std::iota(order.begin(), order.end(), 0u);
+	if (primitive_bounds.empty())
+		return;
+
+	BVHBuilder builder{ primitive_bounds, {}, nodes, order, std::clamp(max_leaf_size, 1, max_leaf_count) };
+	builder.centroids.reserve(primitive_bounds.size());
+	for (const auto& box : primitive_bounds)
+		builder.centroids.push_back(box.centroid());
+
+	nodes.reserve(2 * primitive_bounds.size());
+	builder.build(0, static_cast<uint32_t>(primitive_bounds.size()), 0);
+	nodes.shrink_to_fit();
+}
+
+BVH::BVH(const HittableList& list, int max_leaf_size)
+	: BVH(list.objects, max_leaf_size)
+{
+}
+
+BVH::BVH(std::vector<std::shared_ptr<Hittable>> objects, int max_leaf_size)
+{
+	std::vector<AABB> bounds;
+	bounds.reserve(objects.size());
+	for (const auto& object : objects)
+		bounds.push_back(object->boundingBox());
+
+	std::vector<uint32_t> order;
+	buildBVH(bounds, node_array, order, max_leaf_size);
+
+	// Store the primitives in leaf order so a leaf touches one contiguous run.
+	primitives.reserve(objects.size());
+	for (auto index : order)
+		primitives.push_back(std::move(objects[index]));
+}
+
+bool BVH::hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept
+{
+	PHOTON_STAT(hit_calls++);
+	// Primitives only write rec on a hit closer than ray_t.max, so it can be passed straight through.
+	return traverseBVH(node_array, r, ray_t, [&](uint32_t slot, Interval& t) {
+		if (!primitives[slot]->hit(r, t, rec))
+			return false;
+		t.max = rec.t;
+		return true;
+	});
+}
+
+AABB BVH::boundingBox() const noexcept
+{
+	return node_array.empty() ? AABB() : node_array.front().bounds;
+}
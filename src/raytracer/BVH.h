@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Hittable.h"
+#include "HittableList.h"
+
+#include <span>
+#include <vector>
+
+// One node of a flattened BVH. Nodes are stored depth-first, so the first child of an
+// interior node always directly follows it and only the second child needs an index.
+struct BVHNode {
+	AABB bounds;
+	uint32_t offset{0};	// Leaf: first primitive slot. Interior: index of the second child.
+	uint16_t count{0};	// Number of primitives, 0 for interior nodes
+	uint8_t axis{0};	// Split axis of interior nodes, used to order the traversal
+
+	[[nodiscard]] constexpr bool isLeaf() const noexcept { return count > 0; }
+};
+
+// Builds a BVH over the given primitive bounds using binned SAH splits.
+// On return, order[slot] is the index of the primitive referenced by leaf slot `slot`.
+void buildBVH(std::span<const AABB> primitive_bounds, std::vector<BVHNode>& nodes,
+			  std::vector<uint32_t>& order, int max_leaf_size = 4);
+
+inline constexpr int bvh_max_depth = 64;
+
+// Front-to-back traversal of a flattened BVH. For every primitive slot in a leaf whose box
+// the ray enters, calls hit_slot(slot, ray_t); on a hit the callback shrinks ray_t.max to
+// the hit distance and returns true, which culls everything behind it.
+template <typename HitSlot>
+bool traverseBVH(std::span<const BVHNode> nodes, const Ray& r, Interval& ray_t, HitSlot&& hit_slot) noexcept
+{
+	if (nodes.empty())
+		return false;
+
+	const auto& dir = r.direction();
+	const Vec3 inv_dir(real(1) / dir.x(), real(1) / dir.y(), real(1) / dir.z());
+	const bool dir_is_neg[3] = { inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0 };
+
+	uint32_t stack[bvh_max_depth];
+	int stack_size = 0;
+	uint32_t current = 0;
+	bool hit_anything = false;
+
+	while (true) {
+		const auto& node = nodes[current];
+		if (node.bounds.hit(r.origin(), inv_dir, ray_t)) {
+			if (node.isLeaf()) {
+				for (uint32_t i = 0; i < node.count; ++i) {
+					if (hit_slot(node.offset + i, ray_t))
+						hit_anything = true;
+				}
+			}
+			else {
+				// Visit the child on the near side of the split plane first.
+				if (dir_is_neg[node.axis]) {
+					stack[stack_size++] = current + 1;
+					current = node.offset;
+				}
+				else {
+					stack[stack_size++] = node.offset;
+					current = current + 1;
+				}
+				continue;
+			}
+		}
+
+		if (stack_size == 0)
+			break;
+		current = stack[--stack_size];
+	}
+
+	return hit_anything;
+}
+
+// Bounding volume hierarchy over arbitrary hittables, O(log N) per ray instead of the
+// linear scan of HittableList.
+class BVH : public Hittable {
+public:
+	explicit BVH(const HittableList& list, int max_leaf_size = 4);
+	explicit BVH(std::vector<std::shared_ptr<Hittable>> objects, int max_leaf_size = 4);
+
+	bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept override;
+	[[nodiscard]] AABB boundingBox() const noexcept override;
+
+	[[nodiscard]] std::span<const BVHNode> nodes() const noexcept { return node_array; }
+
+private:
+	std::vector<std::shared_ptr<Hittable>> primitives;	// In leaf slot order
+	std::vector<BVHNode> node_array;
+};
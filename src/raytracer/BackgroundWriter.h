@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// What a BackgroundWriter does with items while it is still busy with an earlier one.
+enum class WriterPolicy {
+	Queue,		// Every item is written in turn; push() waits while capacity items wait, and the first failure stays
+	Latest,		// Each item supersedes the ones before: it replaces the one waiting, and only the last write's outcome counts
+};
+
+// Writes items on a thread of its own, so the thread producing them never waits on the disk.
+template <typename T>
+class BackgroundWriter {
+public:
+	// Writes one item; false with error saying why it could not.
+	using WriteFn = std::function<bool(const T& item, std::string& error)>;
+
+	BackgroundWriter(WriteFn write, WriterPolicy policy, size_t capacity = 1)
+		: write(std::move(write))
+		, policy(policy)
+		, capacity(std::max<size_t>(capacity, 1))
+		, thread(&BackgroundWriter::writeLoop, this)
+	{
+	}
+
+	// Writes what is still waiting.
+	~BackgroundWriter()
+	{
+		{
+			std::lock_guard lock(mutex);
+			closing = true;
+		}
+		changed.notify_all();
+		thread.join();
+	}
+
+	BackgroundWriter(const BackgroundWriter&) = delete;
+	BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+
+	// Hands item over. Returns the seconds it waited for room, which only a full Queue makes it do.
+	double push(T item)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		std::unique_lock lock(mutex);
+		if (policy == WriterPolicy::Latest)
+			queue.clear();
+		else
+			changed.wait(lock, [&] { return queue.size() < capacity; });
+		queue.push_back(std::move(item));
+		lock.unlock();
+		changed.notify_all();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Waits until everything pushed is written. Returns false if a write failed; error says why.
+	[[nodiscard]] bool flush(std::string& error)
+	{
+		std::unique_lock lock(mutex);
+		changed.wait(lock, [&] { return queue.empty() && !writing; });
+		if (failure.empty())
+			return true;
+		error = failure;
+		return false;
+	}
+
+	[[nodiscard]] int written() const noexcept { return written_count.load(std::memory_order_acquire); }
+	// Seconds the writer thread spent writing so far.
+	[[nodiscard]] double writeSeconds() const noexcept { return write_seconds.load(std::memory_order_acquire); }
+
+private:
+	void writeLoop()
+	{
+		std::unique_lock lock(mutex);
+		while (true) {
+			changed.wait(lock, [&] { return !queue.empty() || closing; });
+			if (queue.empty())
+				return;
+
+			const T item = std::move(queue.front());
+			queue.pop_front();
+			writing = true;
+			lock.unlock();
+			changed.notify_all();
+
+			const auto start = std::chrono::steady_clock::now();
+			std::string error;
+			const bool ok = write(item, error);
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			lock.lock();
+			writing = false;
+			if (policy == WriterPolicy::Latest)
+				failure = ok ? std::string() : error;
+			else if (!ok && failure.empty())
+				failure = error;
+			if (ok)
+				written_count.fetch_add(1, std::memory_order_acq_rel);
+			write_seconds.store(writeSeconds() + elapsed.count(), std::memory_order_release);
+			changed.notify_all();
+		}
+	}
+
+	const WriteFn write;
+	const WriterPolicy policy;
+	const size_t capacity;			// Items waiting at most, for a Queue
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<T> queue;
+	bool writing = false;
+	bool closing = false;
+	std::string failure;			// See WriterPolicy; empty if all went well
+	std::atomic<int> written_count{0};
+	std::atomic<double> write_seconds{0.0};
+	std::thread thread;
+};
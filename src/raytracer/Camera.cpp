@@ -1,12 +1,70 @@
 #include "Camera.h"
-#include "Materials/Material.h"
+#include "Wavefront.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+void store_linear(std::vector<float>& rgb, const Color& color, int i, int j, int image_width) noexcept
+{
+	float* pixel = &rgb[3 * (static_cast<size_t>(j) * image_width + i)];
+	pixel[0] = static_cast<float>(color.x());
+	pixel[1] = static_cast<float>(color.y());
+	pixel[2] = static_cast<float>(color.z());
+}
+
+// Features of a camera ray that hit rec, or nothing if rec is null.
+SurfaceFeatures surfaceFeatures(const Ray& r, const HitRecord* rec, const MaterialTable& materials) noexcept
+{
+	SurfaceFeatures features;
+	if (!rec) {
+		features.albedo = Camera::skyColor(r);
+		features.normal = -unit_vector(r.direction());
+		return features;
+	}
+	features.albedo = materials.albedo(rec->material);
+	features.normal = rec->normal;
+	features.depth = rec->t * r.direction().length();
+	return features;
+}
+
+}
+
+void FeatureBuffers::resize(int new_width, int new_height)
+{
+	width = new_width;
+	height = new_height;
+	const auto pixels = static_cast<size_t>(width) * height;
+	albedo.assign(pixels * 3, 0.0f);
+	normal.assign(pixels * 3, 0.0f);
+	depth.assign(pixels, std::numeric_limits<float>::infinity());
+}
+
+void FeatureBuffers::add(int i, int j, const SurfaceFeatures& features) noexcept
+{
+	const auto pixel = static_cast<size_t>(j) * width + i;
+	for (int c = 0; c < 3; ++c) {
+		albedo[3 * pixel + c] += static_cast<float>(features.albedo[c]);
+		normal[3 * pixel + c] += static_cast<float>(features.normal[c]);
+	}
+	depth[pixel] = std::min(depth[pixel], static_cast<float>(features.depth));
+}
+
+void FeatureBuffers::average(int samples) noexcept
+{
+	const float scale = 1.0f / std::max(samples, 1);
+	for (auto& value : albedo)
+		value *= scale;
+	for (auto& value : normal)
+		value *= scale;
+}
 
 Camera::Camera(int image_width, double aspect_ratio, int samples_per_pixel, int max_depth, 
 	           double vfov, Point3 lookfrom, Point3 lookat, Vec3 vup, double defocus_angle, double focus_dist) noexcept
 	: aspect_ratio(aspect_ratio)
 	, image_width(image_width)
 	, samples_per_pixel(samples_per_pixel)
-	, inv_pixel_samples(1.0 / samples_per_pixel)
 	, center(lookfrom)
 	, max_depth(max_depth)
 	, vfov(vfov)
@@ -16,8 +74,26 @@ Camera::Camera(int image_width, double aspect_ratio, int samples_per_pixel, int
 	, defocus_angle(defocus_angle)
 	, focus_dist(focus_dist)
 {
-	// Here do the same as initialize basically but without calling that fdunction
+	updateFrame();
+}
+
+void Camera::setView(const Point3& new_lookfrom, const Point3& new_lookat, double new_vfov) noexcept
+{
+	lookfrom = new_lookfrom;
+	lookat = new_lookat;
+	vfov = new_vfov;
+	updateFrame();
+}
+
+void Camera::setView(const Point3& new_lookfrom, const Point3& new_lookat, double new_vfov, double new_focus_dist) noexcept
+{
+	focus_dist = new_focus_dist;
+	setView(new_lookfrom, new_lookat, new_vfov);
+}
 
+void Camera::updateFrame() noexcept
+{
+	center = lookfrom;
 	image_height = static_cast<int>(image_width / aspect_ratio);
 	image_height = image_height < 1 ? 1 : image_height;
 
@@ -50,66 +126,466 @@ Camera::Camera(int image_width, double aspect_ratio, int samples_per_pixel, int
 	defocus_disk_v = v * defocus_radius;
 }
 
-std::vector<uint8_t> Camera::render(const Hittable& world) noexcept
+std::vector<uint8_t> Camera::render(const Scene& scene) noexcept
+{
+	TileScheduler scheduler(thread_count);
+	return render(scene, scheduler);
+}
+
+std::vector<uint8_t> Camera::render(const Scene& scene, TileScheduler& scheduler) noexcept
+{
+	const auto rgb = renderLinear(scene, scheduler);
+	std::vector<uint8_t> rgba(static_cast<size_t>(image_width) * image_height * 4);
+	toneMap(rgb, rgba, image_width, image_height, display, scheduler);
+	return rgba;
+}
+
+std::vector<float> Camera::renderLinear(const Scene& scene) noexcept
+{
+	TileScheduler scheduler(thread_count);
+	return renderLinear(scene, scheduler);
+}
+
+std::vector<float> Camera::renderLinear(const Scene& scene, TileScheduler& scheduler) noexcept
+{
+	if (adaptive_sampling) {
+		const auto prototype = createSampler();
+		std::vector<std::unique_ptr<Sampler>> samplers;
+		for (int i = 0; i < scheduler.threadCount(); ++i)
+			samplers.push_back(prototype->clone());
+
+		// Counted per worker and merged at the end, so the threads never share a counter.
+		render_stats = RenderStats();
+		std::vector<RenderStats> worker_stats(scheduler.threadCount());
+		return renderAdaptive(scene, scheduler, samplers, worker_stats);
+	}
+
+	return renderFixed(scene, scheduler, nullptr);
+}
+
+std::vector<float> Camera::renderLinear(const Scene& scene, TileScheduler& scheduler, FeatureBuffers& features) noexcept
+{
+	if (adaptive_sampling || execution_mode == ExecutionMode::Wavefront) {
+		auto rgb = renderLinear(scene, scheduler);
+		renderFeatures(scene, scheduler, features);
+		return rgb;
+	}
+
+	features.resize(image_width, image_height);
+	auto rgb = renderFixed(scene, scheduler, &features);
+	features.average(samples_per_pixel);
+	return rgb;
+}
+
+void Camera::renderFeatures(const Scene& scene, TileScheduler& scheduler, FeatureBuffers& features) noexcept
+{
+	features.resize(image_width, image_height);
+	const auto prototype = createSampler();
+	std::vector<std::unique_ptr<Sampler>> samplers;
+	for (int i = 0; i < scheduler.threadCount(); ++i)
+		samplers.push_back(prototype->clone());
+
+	const auto tiles = makeTiles(image_width, image_height, tile_size);
+	scheduler.run(tiles, [&](const Tile& tile, int worker) {
+		for (int j = tile.y0; j < tile.y1; ++j) {
+			for (int i = tile.x0; i < tile.x1; ++i) {
+				for (int sample = 0; sample < samples_per_pixel; ++sample) {
+					const Ray ray = cameraRay(i, j, sample, *samplers[worker]);
+					HitRecord rec;
+					const bool hit = scene.world->hit(ray, Interval(0, infinity), rec);
+					features.add(i, j, surfaceFeatures(ray, hit ? &rec : nullptr, scene.materials));
+				}
+			}
+		}
+	});
+	features.average(samples_per_pixel);
+}
+
+std::vector<float> Camera::renderFixed(const Scene& scene, TileScheduler& scheduler, FeatureBuffers* features) noexcept
+{
+	std::vector<float> rgb(static_cast<size_t>(image_width) * image_height * 3);
+	const auto tiles = makeTiles(image_width, image_height, tile_size);
+	std::vector<uint64_t> tile_rays(tiles.size());
+	renderTiles(scene, tiles, scheduler, rgb, tile_rays, features);
+
+	samples_traced = static_cast<uint64_t>(image_width) * image_height * samples_per_pixel;
+	rays_traced = 0;
+	for (auto n : tile_rays)
+		rays_traced += n;
+	return rgb;
+}
+
+void Camera::renderTiles(const Scene& scene, std::span<const Tile> tiles, TileScheduler& scheduler, std::vector<float>& rgb,
+						 std::span<uint64_t> tile_rays, FeatureBuffers* features) noexcept
+{
+	const auto prototype = createSampler();
+	std::vector<std::unique_ptr<Sampler>> samplers;
+	for (int i = 0; i < scheduler.threadCount(); ++i)
+		samplers.push_back(prototype->clone());
+
+	// Counted per worker and merged at the end, so the threads never share a counter.
+	render_stats = RenderStats();
+	std::vector<RenderStats> worker_stats(scheduler.threadCount());
+
+	if (execution_mode == ExecutionMode::Wavefront) {
+		std::vector<WavefrontTracer> tracers(scheduler.threadCount(), WavefrontTracer(*this));
+		scheduler.run(tiles, [&](const Tile& tile, int worker) {
+			const double inv_pixel_samples = 1.0 / samples_per_pixel;
+			collectRenderStats(worker_stats[worker], [&] {
+				const auto& sums = tracers[worker].traceTile(scene, tile, *samplers[worker], tile_rays[&tile - tiles.data()]);
+				for (int j = tile.y0; j < tile.y1; ++j) {
+					for (int i = tile.x0; i < tile.x1; ++i)
+						store_linear(rgb, sums[(j - tile.y0) * tile.width() + (i - tile.x0)] * inv_pixel_samples, i, j, image_width);
+				}
+			});
+		});
+	}
+	else {
+		scheduler.run(tiles, [&](const Tile& tile, int worker) {
+			collectRenderStats(worker_stats[worker], [&] {
+				tile_rays[&tile - tiles.data()] = renderTile(scene, tile, rgb, *samplers[worker], features);
+			});
+		});
+	}
+	for (const auto& stats : worker_stats)
+		render_stats.merge(stats);
+}
+
+std::vector<float> Camera::renderAdaptive(const Scene& scene, TileScheduler& scheduler,
+											std::span<const std::unique_ptr<Sampler>> samplers,
+											std::span<RenderStats> worker_stats)
 {
-	std::vector<uint8_t> rgba(image_width * image_height * 4);
+	// Running mean and variance (Welford) of each pixel's luminance, next to its color sum.
+	struct PixelEstimate {
+		Color sum;
+		double mean = 0.0;
+		double m2 = 0.0;
+		double error = 0.0;	// 95% confidence half-width in display units
+		int count = 0;
+		bool done = false;
+	};
+
+	const auto pixel_count = static_cast<size_t>(image_width) * image_height;
+	const int max_samples = std::max(adaptive_max_samples > 0 ? adaptive_max_samples : 4 * samples_per_pixel, 1);
+	const int min_samples = std::clamp(adaptive_min_samples, 2, std::max(2, std::min(samples_per_pixel, max_samples)));
+	const uint64_t budget = static_cast<uint64_t>(samples_per_pixel) * pixel_count;
+
+	std::vector<PixelEstimate> estimates(pixel_count);
+	const auto tiles = makeTiles(image_width, image_height, tile_size);
+	std::vector<uint64_t> tile_samples(tiles.size());
+	std::vector<uint64_t> tile_rays(tiles.size());
+	std::vector<uint8_t> tile_active(tiles.size(), 1);
+	std::vector<uint8_t> converged(pixel_count);
+
+	// Rounds of min_samples more samples for every unconverged pixel. The size of a round is fixed
+	// between rounds, so the image does not depend on thread timing.
+	uint64_t used = 0;
+	while (true) {
+		uint64_t active = 0;
+		for (const auto& e : estimates)
+			active += e.done ? 0 : 1;
+		if (active == 0)
+			break;
+		const auto batch = static_cast<int>(std::min<uint64_t>(min_samples, (budget - used) / active));
+		if (batch == 0)
+			break;
+
+		scheduler.run(tiles, [&](const Tile& tile, int worker) {
+			const auto tile_index = static_cast<size_t>(&tile - tiles.data());
+			if (!tile_active[tile_index])
+				return;
+
+			uint64_t taken = 0;
+			uint64_t rays = 0;
+			collectRenderStats(worker_stats[worker], [&] {
+				for (int j = tile.y0; j < tile.y1; ++j) {
+					for (int i = tile.x0; i < tile.x1; ++i) {
+						auto& e = estimates[static_cast<size_t>(j) * image_width + i];
+						if (e.done)
+							continue;
+
+						for (int k = 0; k < batch && e.count < max_samples; ++k) {
+							const auto color = samplePixel(scene, i, j, e.count, *samplers[worker], rays);
+							const double lum = 0.2126 * color.x() + 0.7152 * color.y() + 0.0722 * color.z();
+							e.sum += color;
+							++e.count;
+							const double delta = lum - e.mean;
+							e.mean += delta / e.count;
+							e.m2 += delta * (lum - e.mean);
+							++taken;
+						}
+
+						// Judge the error after gamma 2, where d sqrt(x) = dx / (2 sqrt(x)), so dark pixels
+						// are held to the same visible noise as bright ones. One sample tells nothing.
+						if (e.count < 2) {
+							e.error = infinity;
+							continue;
+						}
+						const double variance = e.m2 / (e.count - 1);
+						const double half_width = 1.96 * std::sqrt(variance / e.count);
+						e.error = half_width / (2.0 * std::sqrt(std::max(e.mean, 1e-4)));
+					}
+				}
+			});
+			tile_samples[tile_index] += taken;
+			tile_rays[tile_index] += rays;
+		});
+
+		used = 0;
+		for (auto n : tile_samples)
+			used += n;
+
+		// A handful of samples easily underestimates the variance, so a pixel only stops once its whole
+		// 3x3 neighbourhood is below the threshold.
+		for (int j = 0; j < image_height; ++j) {
+			for (int i = 0; i < image_width; ++i) {
+				const auto& e = estimates[static_cast<size_t>(j) * image_width + i];
+				double neighbourhood_error = 0.0;
+				for (int y = std::max(j - 1, 0); y <= std::min(j + 1, image_height - 1); ++y) {
+					for (int x = std::max(i - 1, 0); x <= std::min(i + 1, image_width - 1); ++x)
+						neighbourhood_error = std::max(neighbourhood_error, estimates[static_cast<size_t>(y) * image_width + x].error);
+				}
+				converged[static_cast<size_t>(j) * image_width + i] =
+					e.count >= max_samples || neighbourhood_error < adaptive_threshold;
+			}
+		}
+		for (size_t t = 0; t < tiles.size(); ++t) {
+			bool any_active = false;
+			for (int j = tiles[t].y0; j < tiles[t].y1; ++j) {
+				for (int i = tiles[t].x0; i < tiles[t].x1; ++i) {
+					auto& e = estimates[static_cast<size_t>(j) * image_width + i];
+					e.done = e.done || converged[static_cast<size_t>(j) * image_width + i];
+					any_active |= !e.done;
+				}
+			}
+			tile_active[t] = any_active;
+		}
+	}
+	samples_traced = used;
+	rays_traced = 0;
+	for (auto n : tile_rays)
+		rays_traced += n;
+	for (const auto& stats : worker_stats)
+		render_stats.merge(stats);
 
+	std::vector<float> rgb(pixel_count * 3);
 	for (int j = 0; j < image_height; ++j) {
 		for (int i = 0; i < image_width; ++i) {
+			const auto& e = estimates[static_cast<size_t>(j) * image_width + i];
+			if (sample_heatmap) {
+				const double t = static_cast<double>(e.count) / max_samples;
+				store_linear(rgb, Color(t, 0.1, 1.0 - t), i, j, image_width);
+			}
+			else {
+				store_linear(rgb, e.sum / std::max(e.count, 1), i, j, image_width);
+			}
+		}
+	}
+	return rgb;
+}
+
+uint64_t Camera::renderTile(const Scene& scene, const Tile& tile, std::vector<float>& rgb, Sampler& sampler,
+							FeatureBuffers* features) const noexcept
+{
+	// Settings are public and may change after construction, so this is not cached.
+	const double inv_pixel_samples = 1.0 / samples_per_pixel;
+
+	uint64_t rays = 0;
+	for (int j = tile.y0; j < tile.y1; ++j) {
+		for (int i = tile.x0; i < tile.x1; ++i) {
 			Color pixel_color(0, 0, 0);
 			for (int sample = 0; sample < samples_per_pixel; sample++) {
-				Ray r = getRay(i, j);
-				pixel_color += rayColor(r, max_depth, world);
+				if (!features) {
+					pixel_color += samplePixel(scene, i, j, sample, sampler, rays);
+					continue;
+				}
+				SurfaceFeatures sample_features;
+				pixel_color += samplePixel(scene, i, j, sample, sampler, rays, sample_features);
+				features->add(i, j, sample_features);
 			}
-			write_color(rgba, pixel_color * inv_pixel_samples, i, j, image_width);
+			store_linear(rgb, pixel_color * inv_pixel_samples, i, j, image_width);
 		}
 	}
+	return rays;
+}
 
-	return rgba;
+Color Camera::samplePixel(const Scene& scene, int i, int j, int sample, Sampler& sampler, uint64_t& rays) const noexcept
+{
+	return rayColor(cameraRay(i, j, sample, sampler), scene, sampler, rays, nullptr);
+}
+
+Color Camera::samplePixel(const Scene& scene, int i, int j, int sample, Sampler& sampler, uint64_t& rays,
+						  SurfaceFeatures& features) const noexcept
+{
+	return rayColor(cameraRay(i, j, sample, sampler), scene, sampler, rays, &features);
+}
+
+Ray Camera::cameraRay(int i, int j, int sample, Sampler& sampler) const noexcept
+{
+	// Seeding per sample rather than per tile or thread keeps every pixel reproducible on its own.
+	// The sampler feeds the camera and materials, random_double() covers everything else.
+	seed_random(static_cast<uint32_t>(j * image_width + i), static_cast<uint32_t>(sample), frame, seed);
+	sampler.startPixelSample(i, j, sample);
+	PHOTON_STAT(camera_rays++);
+	return getRay(i, j, sampler);
+}
+
+std::unique_ptr<Sampler> Camera::createSampler() const
+{
+	// The seed folds in the frame so animations get fresh noise.
+	return makeSampler(sampler_type, samples_per_pixel, mix_bits((uint64_t(frame) << 32) | seed));
 }
 
-Color Camera::rayColor(const Ray& r, int depth, const Hittable& world) const noexcept
+Color Camera::rayColor(const Ray& r, const Scene& scene, Sampler& sampler, uint64_t& rays,
+					   SurfaceFeatures* features) const noexcept
 {
-	if (depth <= 0) 
-		return Color(0, 0, 0);
+	// Iterative path tracing: carry the product of the attenuations along instead of recursing.
+	const Hittable& world = *scene.world;
+	Color radiance(0, 0, 0);
+	Color throughput(1.0, 1.0, 1.0);
+	Ray ray = r;
+	real scatter_pdf = 0;	// Of the bounce that led to ray
+
+	for (int depth = 0; depth < max_depth; ++depth) {
+		HitRecord rec;
+		++rays;
+		if (depth > 0)
+			PHOTON_STAT(bounce_rays++);
+		const bool hit = world.hit(ray, Interval(0, infinity), rec);
+		if (depth == 0 && features)
+			*features = surfaceFeatures(ray, hit ? &rec : nullptr, scene.materials);
+		if (!hit) {
+			PHOTON_STAT(escaped_paths++);
+			PHOTON_STAT(recordPathEnd(depth));
+			return radiance + throughput * backgroundColor(scene, ray);
+		}
 
-	HitRecord rec;
+		if (const Color emitted = scene.materials.emitted(rec); emitted.length_squared() > 0)
+			radiance += throughput * emitted * emitterWeight(scene, ray, rec, emitted, scatter_pdf);
+		Ray shadow;
+		Color direct;
+		if (sampleDirectLight(scene, ray, rec, sampler, shadow, direct)) {
+			++rays;
+			PHOTON_STAT(shadow_rays++);
+			HitRecord blocker;
+			if (!world.hit(shadow, Interval(0, 1), blocker))
+				radiance += throughput * direct;
+		}
 
-	if(world.hit(r, Interval(0.001, infinity), rec)) {
 		Ray scattered;
 		Color attenuation;
-		if (rec.mat->scatter(r, rec, attenuation, scattered))
-			return attenuation * rayColor(scattered, depth - 1, world);
-		return Color(0, 0, 0);
+		if (!scene.materials.scatter(ray, rec, attenuation, scattered, sampler)) {
+			PHOTON_STAT(absorbed_paths++);
+			PHOTON_STAT(recordPathEnd(depth + 1));
+			return radiance;
+		}
+		scatter_pdf = scatterDensity(scene, ray, rec, scattered);
+		throughput *= attenuation;
+		if (!survivesRoulette(depth, throughput, sampler)) {
+			PHOTON_STAT(roulette_paths++);
+			PHOTON_STAT(recordPathEnd(depth + 1));
+			return radiance;
+		}
+
+		ray = scattered;
 	}
 
+	PHOTON_STAT(truncated_paths++);
+	PHOTON_STAT(recordPathEnd(max_depth));
+	return radiance;
+}
+
+bool Camera::sampleDirectLight(const Scene& scene, const Ray& r, const HitRecord& rec, Sampler& sampler,
+							   Ray& shadow, Color& radiance) const noexcept
+{
+	if (!light_sampling || scene.lights.empty() || !scene.materials.samplesLights(rec.material))
+		return false;
+
+	const auto u_light = real(sampler.get1D());
+	const auto u_point = sampler.get2D();
+	LightSample light;
+	if (!scene.lights.sample(rec.p, u_light, u_point, light))
+		return false;
+	shadow = rec.spawnRayTo(light.p, light.normal, light.p_error);
+	real bsdf_pdf;
+	const Color f = scene.materials.evaluate(r, rec, shadow.direction(), bsdf_pdf);
+	if (!(bsdf_pdf > 0))
+		return false;
+
+	// Power heuristic: each strategy counts where it is likelier than the other.
+	const auto weight = light.pdf * light.pdf / (light.pdf * light.pdf + bsdf_pdf * bsdf_pdf);
+	radiance = f * light.radiance * (weight / light.pdf);
+	return true;
+}
+
+real Camera::scatterDensity(const Scene& scene, const Ray& r_in, const HitRecord& rec, const Ray& scattered) const noexcept
+{
+	if (!light_sampling || scene.lights.empty() || !scene.materials.samplesLights(rec.material))
+		return 0;
+	real pdf;
+	(void)scene.materials.evaluate(r_in, rec, scattered.direction(), pdf);
+	return pdf;
+}
+
+real Camera::emitterWeight(const Scene& scene, const Ray& r, const HitRecord& rec, const Color& emitted,
+						   real scatter_pdf) const noexcept
+{
+	if (!(scatter_pdf > 0))
+		return 1;
+	const auto light_pdf = scene.lights.pdf(r, rec, emitted);
+	return scatter_pdf * scatter_pdf / (scatter_pdf * scatter_pdf + light_pdf * light_pdf);
+}
+
+bool Camera::survivesRoulette(int depth, Color& throughput, Sampler& sampler) const noexcept
+{
+	// End dim paths early with probability 1 - p and boost the survivors by 1 / p, which keeps the
+	// estimate unbiased.
+	if (!russian_roulette || depth + 1 < roulette_min_depth)
+		return true;
+
+	const double p = std::min<double>(roulette_max_survival, std::max({ throughput.x(), throughput.y(), throughput.z() }));
+	if (sampler.get1D() >= p)
+		return false;
+	throughput /= p;
+	return true;
+}
+
+Color Camera::skyColor(const Ray& r) noexcept
+{
 	Vec3 unitDirection = unit_vector(r.direction());
-	auto t = 0.5 * (unitDirection.y() + 1.0);
-	return (1.0 - t) * Color(1.0, 1.0, 1.0) + t * Color(0.5, 0.7, 1.0);
+	auto t = real(0.5) * (unitDirection.y() + 1);
+	return (1 - t) * Color(1.0, 1.0, 1.0) + t * Color(0.5, 0.7, 1.0);
+}
+
+Color Camera::backgroundColor(const Scene& scene, const Ray& r) noexcept
+{
+	return scene.sky ? skyColor(r) : Color(0, 0, 0);
 }
 
-Ray Camera::getRay(int i, int j) const noexcept
+Ray Camera::getRay(int i, int j, Sampler& sampler) const noexcept
 {
 	// Construct a camera ray originating from the origin and directed at randomly sampled
 	// point around the pixel location i, j.
-	auto offset = sample_square();
+	auto offset = sample_square(sampler);
 	auto pixel_sample = pixel00_loc + (i + offset.x()) * pixel_delta_u + (j + offset.y()) * pixel_delta_v;
 
-	auto ray_origin = (defocus_angle <= 0.0) ? center : defocus_disk_sample();
+	auto ray_origin = (defocus_angle <= 0.0) ? center : defocus_disk_sample(sampler);
 	auto ray_direction = pixel_sample - ray_origin;
 
 	return Ray(ray_origin, ray_direction);
 }
 
-Vec3 Camera::sample_square() const noexcept
+Vec3 Camera::sample_square(Sampler& sampler) const noexcept
 {
 	// Returns the vector to a random point in the [-.5,-.5]-[+.5,+.5] unit square.
-	return Vec3(random_double() - 0.5, random_double() - 0.5, 0);
+	const auto u = sampler.get2D();
+	return Vec3(u.x - 0.5, u.y - 0.5, 0);
 }
 
-Point3 Camera::defocus_disk_sample() const noexcept
+Point3 Camera::defocus_disk_sample(Sampler& sampler) const noexcept
 {
 	// Returns a random point in the camera defocus disk.
-	auto p = random_in_unit_disk();
+	const auto u = sampler.get2D();
+	auto p = sample_uniform_disk_concentric(u.x, u.y);
 	return center + (p[0] * defocus_disk_u) + (p[1] * defocus_disk_v);
 }
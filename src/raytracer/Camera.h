@@ -1,28 +1,158 @@
 #pragma once
 
-#include "Hittable.h"
+#include "Scene.h"
 #include "Color.h"
+#include "RenderStats.h"
+#include "Sampler.h"
+#include "TileScheduler.h"
+#include "Tonemap.h"
 
 #include <vector>
 
+// What the camera ray of one sample hits first, to guide a denoiser.
+struct SurfaceFeatures {
+	Color albedo;			// Of the surface's material, the sky color if nothing was hit
+	Vec3 normal;			// Shading normal facing the ray, the reversed ray direction if nothing was hit
+	real depth = infinity;	// Distance along the ray, infinity if nothing was hit
+};
+
+// First-hit auxiliary images (AOVs) of a render, one value per pixel, row by row.
+struct FeatureBuffers {
+	int width = 0;
+	int height = 0;
+	std::vector<float> albedo;	// RGB, mean over the pixel's samples
+	std::vector<float> normal;	// XYZ, mean over the pixel's samples, shorter than 1 where they disagree
+	std::vector<float> depth;	// Nearest over the pixel's samples
+
+	// Clears the buffers to width x height pixels of nothing added yet.
+	void resize(int width, int height);
+	// Adds the features of one sample to pixel (i, j). Albedo and normal are summed, call
+	// average() once all samples are in.
+	void add(int i, int j, const SurfaceFeatures& features) noexcept;
+	// Turns the sums of albedo and normal into means over `samples` samples per pixel.
+	void average(int samples) noexcept;
+};
+
+// How Camera::render() executes the paths of a tile.
+enum class ExecutionMode {
+	PathByPath,	// Each sample traced to the end before the next one starts
+	Wavefront,	// All paths of a tile advanced one bounce at a time, shaded in per-material batches
+};
+
 class Camera {
 public:
 	Camera(int image_width, double aspect_ratio, int samples_per_pixel, int max_depth, double vfov,
 		   Point3 lookfrom, Point3 lookat, Vec3 vup, double defocus_angle, double focus_dist) noexcept;
 
-	std::vector<uint8_t> render(const Hittable& world) noexcept;
+	// Moves and zooms the camera, keeping every other setting. Assigning lookfrom, lookat or vfov
+	// directly has no effect after construction.
+	void setView(const Point3& lookfrom, const Point3& lookat, double vfov) noexcept;
+	// setView() that also moves the plane of focus.
+	void setView(const Point3& lookfrom, const Point3& lookat, double vfov, double focus_dist) noexcept;
+
+	// Renders to RGBA8 through the display settings.
+	std::vector<uint8_t> render(const Scene& scene) noexcept;
+	// Renders on an existing pool, so repeated renders do not respawn threads.
+	std::vector<uint8_t> render(const Scene& scene, TileScheduler& scheduler) noexcept;
+	// The image before gamma and quantization: linear RGB, 3 floats per pixel, row by row.
+	std::vector<float> renderLinear(const Scene& scene) noexcept;
+	std::vector<float> renderLinear(const Scene& scene, TileScheduler& scheduler) noexcept;
+	// renderLinear() that also fills features for a denoiser. Path by path they come from the first
+	// hits of the rendered paths; the wavefront and adaptive renders take an extra pass of camera
+	// rays for them.
+	std::vector<float> renderLinear(const Scene& scene, TileScheduler& scheduler, FeatureBuffers& features) noexcept;
+	// Only the features, from camera rays of the same samples a render would take.
+	void renderFeatures(const Scene& scene, TileScheduler& scheduler, FeatureBuffers& features) noexcept;
+	// Renders only the given tiles into rgb, which holds the whole linear image, and stores the rays
+	// each tile traced in tile_rays. A tile comes out the same whichever call renders it, so an image
+	// can be assembled from tiles rendered elsewhere. Ignores adaptive sampling. Path by path, also
+	// adds the features of every sample to features if given.
+	void renderTiles(const Scene& scene, std::span<const Tile> tiles, TileScheduler& scheduler, std::vector<float>& rgb,
+					 std::span<uint64_t> tile_rays, FeatureBuffers* features = nullptr) noexcept;
+
+	// Traces sample `sample` of pixel (i, j). The result depends only on these arguments and the
+	// camera settings, which lets progressive and tiled renders reproduce a batch render.
+	// Adds the number of rays intersected with the scene to `rays`.
+	[[nodiscard]] Color samplePixel(const Scene& scene, int i, int j, int sample, Sampler& sampler, uint64_t& rays) const noexcept;
+	// samplePixel() that also reports what the camera ray hit first.
+	[[nodiscard]] Color samplePixel(const Scene& scene, int i, int j, int sample, Sampler& sampler, uint64_t& rays,
+									SurfaceFeatures& features) const noexcept;
+	// Starts sample `sample` of pixel (i, j) and returns its camera ray, the first step of samplePixel().
+	[[nodiscard]] Ray cameraRay(int i, int j, int sample, Sampler& sampler) const noexcept;
+	// Sampler for this camera's settings and seed; render threads each use their own clone.
+	[[nodiscard]] std::unique_ptr<Sampler> createSampler() const;
+
+	// Russian roulette after bounce `depth`: false ends the path, otherwise the survivor's
+	// throughput is reweighted by 1 / p. Draws one sample only once the roulette applies.
+	[[nodiscard]] bool survivesRoulette(int depth, Color& throughput, Sampler& sampler) const noexcept;
+	// Next-event estimation at rec, the hit of r: picks a point on one of the scene's lights and
+	// returns true with the shadow ray towards it and the radiance it brings, weighed against
+	// finding the light by scattering, if it can contribute. The radiance still needs the path
+	// throughput and counts if nothing blocks the shadow ray for t in (0, 1). Draws three
+	// samples wherever the scene has lights and the material samples them, hit or miss.
+	[[nodiscard]] bool sampleDirectLight(const Scene& scene, const Ray& r, const HitRecord& rec, Sampler& sampler,
+										 Ray& shadow, Color& radiance) const noexcept;
+	// The density with which the material at rec scattered r_in into scattered, for weighing the
+	// emitter scattered hits; 0 where lights were not sampled, which gives the emitter full weight.
+	[[nodiscard]] real scatterDensity(const Scene& scene, const Ray& r_in, const HitRecord& rec,
+									  const Ray& scattered) const noexcept;
+	// The weight of radiance emitted at rec, the hit of r, after a bounce of density scatter_pdf.
+	[[nodiscard]] real emitterWeight(const Scene& scene, const Ray& r, const HitRecord& rec, const Color& emitted,
+									 real scatter_pdf) const noexcept;
+	// Radiance arriving along a ray that leaves the scene.
+	[[nodiscard]] static Color skyColor(const Ray& r) noexcept;
+	// skyColor(), or black if the scene has no sky.
+	[[nodiscard]] static Color backgroundColor(const Scene& scene, const Ray& r) noexcept;
+
+	[[nodiscard]] int imageHeight() const noexcept { return image_height; }
+	// Camera samples traced by the last render(), for comparing adaptive against fixed sampling.
+	[[nodiscard]] uint64_t samplesTraced() const noexcept { return samples_traced; }
+	// Camera, extension and shadow rays intersected with the scene by the last render().
+	[[nodiscard]] uint64_t raysTraced() const noexcept { return rays_traced; }
+	// Counters of the last render(), all zero unless built with PHOTON_ENABLE_STATS.
+	[[nodiscard]] const RenderStats& renderStats() const noexcept { return render_stats; }
 
 private:
-	[[nodiscard]] Color rayColor(const Ray& r, int depth, const Hittable& world) const noexcept;
-	[[nodiscard]] Ray getRay(int i, int j) const noexcept;
-	[[nodiscard]] Vec3 sample_square() const noexcept;
-	[[nodiscard]] Point3 defocus_disk_sample() const noexcept;
+	// Derives the pixel grid and lens vectors from the public settings.
+	void updateFrame() noexcept;
+	[[nodiscard]] std::vector<float> renderAdaptive(const Scene& scene, TileScheduler& scheduler,
+													std::span<const std::unique_ptr<Sampler>> samplers,
+													std::span<RenderStats> worker_stats);
+	// Renders every tile with samples_per_pixel samples, adding the features to features if given.
+	[[nodiscard]] std::vector<float> renderFixed(const Scene& scene, TileScheduler& scheduler, FeatureBuffers* features) noexcept;
+	// Returns the number of rays traced.
+	uint64_t renderTile(const Scene& scene, const Tile& tile, std::vector<float>& rgb, Sampler& sampler,
+						FeatureBuffers* features) const noexcept;
+	// Fills features at the first hit, if given.
+	[[nodiscard]] Color rayColor(const Ray& r, const Scene& scene, Sampler& sampler, uint64_t& rays,
+								 SurfaceFeatures* features) const noexcept;
+	[[nodiscard]] Ray getRay(int i, int j, Sampler& sampler) const noexcept;
+	[[nodiscard]] Vec3 sample_square(Sampler& sampler) const noexcept;
+	[[nodiscard]] Point3 defocus_disk_sample(Sampler& sampler) const noexcept;
 
 public:
 	double aspect_ratio = 16.0 / 9.0;	// Ratio of image width over height
 	int image_width = 1280;				// Rendered image width in pixel count
 	int samples_per_pixel = 10;			// Number of samples per pixel for antialiasing
 	int max_depth = 10;					// Maximum ray bounce depth
+	bool russian_roulette = true;		// Randomly end low-throughput paths (unbiased)
+	int roulette_min_depth = 3;			// Bounces before Russian roulette may end a path
+	double roulette_max_survival = 0.95;	// Upper bound on the survival probability, so bright paths still end
+	int thread_count = 0;				// Render threads, 0 = one per hardware thread
+	int tile_size = 32;					// Edge length of the square tiles handed to the threads
+	uint32_t seed = 0;					// Base seed, the image is deterministic for a fixed seed
+	uint32_t frame = 0;					// Animation frame, decorrelates the noise between frames
+	SamplerType sampler_type = SamplerType::Sobol;	// Source of the pixel, lens and scattering samples
+	ExecutionMode execution_mode = ExecutionMode::PathByPath;	// Ignored by adaptive sampling
+	bool light_sampling = true;			// Next-event estimation with MIS; false finds lights by scattering only
+	DisplaySettings display;			// Exposure and tone curve of render(); renderLinear() is unaffected
+
+	// Adaptive sampling: samples_per_pixel becomes the average budget, spent where pixels are noisy.
+	bool   adaptive_sampling = false;	// Stop sampling a pixel once its estimate has converged
+	int    adaptive_min_samples = 8;	// Samples every pixel gets before the first convergence test
+	int    adaptive_max_samples = 0;	// Per-pixel cap, 0 = 4 * samples_per_pixel
+	double adaptive_threshold = 0.02;	// 95% confidence half-width at which a pixel counts as converged, in display units
+	bool   sample_heatmap = false;		// Output each pixel's sample count (blue = few, red = max) instead of the image
 
 	double vfov = 90.0;					// Vertical field of view in degrees
 	Point3 lookfrom = Point3(0, 0, 0);	// Camera position
@@ -34,7 +164,9 @@ public:
 
 private:
 	int    image_height;	// Rendered image height
-	double inv_pixel_samples;
+	uint64_t samples_traced = 0;
+	uint64_t rays_traced = 0;
+	RenderStats render_stats;
 	Point3 center;			// Camera center
 	Point3 pixel00_loc;		// Location of pixel 0, 0
 	Vec3   pixel_delta_u;	// Offset to pixel to the right
@@ -0,0 +1,273 @@
+#include "Checkpoint.h"
+#include "BackgroundWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+namespace {
+
+// A header, the sums, then the sample counts.
+constexpr char checkpoint_magic[8] = { 'P', 'H', 'O', 'T', 'O', 'N', 'C', 'K' };
+constexpr uint32_t checkpoint_version = 1;
+constexpr uint32_t byte_order_tag = 0x01020304;
+
+struct CheckpointHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t real_size;
+	int32_t width;
+	int32_t height;
+	int32_t sampler_samples;
+	uint64_t scene_hash;
+	uint64_t camera_hash;
+};
+
+static_assert(std::is_trivially_copyable_v<CheckpointHeader>);
+
+template <typename T>
+[[nodiscard]] uint64_t hashValue(uint64_t hash, const T& value) noexcept
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	return hashBytes(std::as_bytes(std::span(&value, 1)), hash);
+}
+
+[[nodiscard]] uint64_t hashVector(uint64_t hash, const Vec3& v) noexcept
+{
+	for (int i = 0; i < 3; ++i)
+		hash = hashValue<double>(hash, v[i]);
+	return hash;
+}
+
+}
+
+std::vector<float> RenderCheckpoint::average() const
+{
+	std::vector<float> rgb(sums.size());
+	for (size_t p = 0; p < samples.size(); ++p) {
+		const double inv_samples = 1.0 / std::max(samples[p], 1u);
+		for (int c = 0; c < 3; ++c)
+			rgb[3 * p + c] = static_cast<float>(sums[3 * p + c] * inv_samples);
+	}
+	return rgb;
+}
+
+uint32_t RenderCheckpoint::completeSamples() const noexcept
+{
+	return samples.empty() ? 0 : *std::min_element(samples.begin(), samples.end());
+}
+
+uint64_t hashBytes(std::span<const std::byte> bytes, uint64_t hash) noexcept
+{
+	for (const auto byte : bytes) {
+		hash ^= static_cast<uint8_t>(byte);
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+uint64_t cameraHash(const Camera& camera) noexcept
+{
+	uint64_t hash = hashValue<int32_t>(0xcbf29ce484222325ull, camera.image_width);
+	hash = hashValue<int32_t>(hash, camera.imageHeight());
+	hash = hashValue<double>(hash, camera.aspect_ratio);
+	hash = hashValue<int32_t>(hash, camera.max_depth);
+	hash = hashValue<double>(hash, camera.vfov);
+	hash = hashVector(hash, camera.lookfrom);
+	hash = hashVector(hash, camera.lookat);
+	hash = hashVector(hash, camera.vup);
+	hash = hashValue<double>(hash, camera.defocus_angle);
+	hash = hashValue<double>(hash, camera.focus_dist);
+	hash = hashValue<uint8_t>(hash, camera.russian_roulette);
+	hash = hashValue<int32_t>(hash, camera.roulette_min_depth);
+	hash = hashValue<double>(hash, camera.roulette_max_survival);
+	hash = hashValue<uint32_t>(hash, camera.seed);
+	hash = hashValue<uint32_t>(hash, camera.frame);
+	hash = hashValue<uint32_t>(hash, static_cast<uint32_t>(camera.sampler_type));
+	return hashValue<uint8_t>(hash, camera.light_sampling);
+}
+
+bool saveCheckpoint(const std::string& path, const RenderCheckpoint& checkpoint, std::string& error)
+{
+	namespace fs = std::filesystem;
+
+	CheckpointHeader header{};
+	std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+	header.version = checkpoint_version;
+	header.byte_order = byte_order_tag;
+	header.real_size = sizeof(real);
+	header.width = checkpoint.width;
+	header.height = checkpoint.height;
+	header.sampler_samples = checkpoint.sampler_samples;
+	header.scene_hash = checkpoint.scene_hash;
+	header.camera_hash = checkpoint.camera_hash;
+
+	const std::string temp_path = path + ".tmp";
+	std::ofstream file(temp_path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(checkpoint.sums.data()),
+			   static_cast<std::streamsize>(checkpoint.sums.size() * sizeof(double)));
+	file.write(reinterpret_cast<const char*>(checkpoint.samples.data()),
+			   static_cast<std::streamsize>(checkpoint.samples.size() * sizeof(uint32_t)));
+	file.close();
+	std::error_code rename_error;
+	if (file)
+		fs::rename(temp_path, path, rename_error);
+	if (!file || rename_error) {
+		fs::remove(temp_path, rename_error);
+		error = "Could not write the checkpoint " + path;
+		return false;
+	}
+	return true;
+}
+
+bool loadCheckpoint(const std::string& path, RenderCheckpoint& checkpoint, std::string& error)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		error = "Cannot open the checkpoint " + path;
+		return false;
+	}
+	CheckpointHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || std::memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) != 0) {
+		error = path + " is not a checkpoint";
+		return false;
+	}
+	if (header.version != checkpoint_version || header.byte_order != byte_order_tag || header.real_size != sizeof(real)) {
+		error = path + " was written by an incompatible build";
+		return false;
+	}
+	if (header.width <= 0 || header.height <= 0 || header.sampler_samples <= 0) {
+		error = path + " is corrupt";
+		return false;
+	}
+
+	const auto pixel_count = static_cast<size_t>(header.width) * header.height;
+	checkpoint.scene_hash = header.scene_hash;
+	checkpoint.camera_hash = header.camera_hash;
+	checkpoint.width = header.width;
+	checkpoint.height = header.height;
+	checkpoint.sampler_samples = header.sampler_samples;
+	checkpoint.sums.resize(pixel_count * 3);
+	checkpoint.samples.resize(pixel_count);
+	file.read(reinterpret_cast<char*>(checkpoint.sums.data()), static_cast<std::streamsize>(checkpoint.sums.size() * sizeof(double)));
+	file.read(reinterpret_cast<char*>(checkpoint.samples.data()),
+			  static_cast<std::streamsize>(checkpoint.samples.size() * sizeof(uint32_t)));
+	if (!file || file.peek() != std::ifstream::traits_type::eof()) {
+		checkpoint = RenderCheckpoint();
+		error = path + " is truncated or corrupt";
+		return false;
+	}
+	return true;
+}
+
+bool renderCheckpointed(const Camera& camera, const Scene& scene, uint64_t scene_hash, TileScheduler& scheduler,
+						const CheckpointSettings& settings, RenderCheckpoint& checkpoint, CheckpointReport& report,
+						std::string& error)
+{
+	const int width = camera.image_width;
+	const int height = camera.imageHeight();
+	const auto pixel_count = static_cast<size_t>(width) * height;
+	const auto camera_hash = cameraHash(camera);
+	if (checkpoint.empty()) {
+		checkpoint = RenderCheckpoint{ scene_hash, camera_hash, width, height, std::max(camera.samples_per_pixel, 1),
+									   std::vector<double>(pixel_count * 3), std::vector<uint32_t>(pixel_count) };
+	}
+	else if (checkpoint.width != width || checkpoint.height != height) {
+		error = "The checkpoint is of a " + std::to_string(checkpoint.width) + "x" + std::to_string(checkpoint.height)
+			+ " image, not " + std::to_string(width) + "x" + std::to_string(height);
+		return false;
+	}
+	else if (checkpoint.scene_hash != scene_hash) {
+		error = "The checkpoint was rendered from another scene";
+		return false;
+	}
+	else if (checkpoint.camera_hash != camera_hash) {
+		error = "The checkpoint was rendered with other camera settings";
+		return false;
+	}
+
+	// The sampler keeps the sample count it started with, so added samples continue its pattern
+	// instead of starting another one over the samples already taken.
+	Camera sampling = camera;
+	sampling.samples_per_pixel = checkpoint.sampler_samples;
+	const auto prototype = sampling.createSampler();
+	std::vector<std::unique_ptr<Sampler>> samplers;
+	for (int i = 0; i < scheduler.threadCount(); ++i)
+		samplers.push_back(prototype->clone());
+
+	const auto cancelled = [&] { return settings.cancel && settings.cancel->load(std::memory_order_relaxed); };
+	const auto tiles = makeTiles(width, height, camera.tile_size);
+	const uint64_t target = static_cast<uint64_t>(std::max(camera.samples_per_pixel, 0));
+	std::vector<uint64_t> worker_samples(scheduler.threadCount());
+	std::vector<uint64_t> worker_rays(scheduler.threadCount());
+	std::vector<RenderStats> worker_stats(scheduler.threadCount());
+
+	// Passes bring every pixel up to pass_end samples; pixels a cancelled pass already took further
+	// just skip ahead. A pass is sized to take about a quarter of the interval, so checkpoints are
+	// never much later than due, and the pass barrier is the only point the workers all wait at.
+	// A newer checkpoint makes any older one still waiting to be saved obsolete.
+	BackgroundWriter<RenderCheckpoint> writer([&](const RenderCheckpoint& saved, std::string& save_error) {
+		return saveCheckpoint(settings.path, saved, save_error);
+	}, WriterPolicy::Latest);
+	auto last_save = std::chrono::steady_clock::now();
+	double seconds_per_sample = 0.0;	// Of one sample of one pixel, on the whole pool
+	uint64_t pass_end = checkpoint.completeSamples();
+	while (pass_end < target && !cancelled()) {
+		uint64_t batch = 1;
+		if (seconds_per_sample > 0.0)
+			batch = static_cast<uint64_t>(std::max(settings.interval / 4 / (seconds_per_sample * pixel_count), 1.0));
+		pass_end = std::min(target, pass_end + batch);
+
+		const auto pass_start = std::chrono::steady_clock::now();
+		std::fill(worker_samples.begin(), worker_samples.end(), 0);
+		scheduler.run(tiles, [&](const Tile& tile, int worker) {
+			if (cancelled())
+				return;
+			collectRenderStats(worker_stats[worker], [&] {
+				for (int j = tile.y0; j < tile.y1; ++j) {
+					for (int i = tile.x0; i < tile.x1; ++i) {
+						const auto p = static_cast<size_t>(j) * width + i;
+						double* sum = &checkpoint.sums[3 * p];
+						for (uint32_t& sample = checkpoint.samples[p]; sample < pass_end; ++sample) {
+							const auto color = camera.samplePixel(scene, i, j, static_cast<int>(sample), *samplers[worker],
+																  worker_rays[worker]);
+							sum[0] += color.x();
+							sum[1] += color.y();
+							sum[2] += color.z();
+							++worker_samples[worker];
+						}
+					}
+				}
+			});
+		});
+
+		uint64_t pass_samples = 0;
+		for (auto n : worker_samples)
+			pass_samples += n;
+		report.samples += pass_samples;
+		const auto now = std::chrono::steady_clock::now();
+		if (pass_samples > 0)
+			seconds_per_sample = std::chrono::duration<double>(now - pass_start).count() / pass_samples;
+		if (pass_end < target && std::chrono::duration<double>(now - last_save).count() >= settings.interval) {
+			writer.push(checkpoint);
+			last_save = now;
+		}
+	}
+	writer.push(checkpoint);
+	const bool saved = writer.flush(error);
+
+	report.cancelled = cancelled() && checkpoint.completeSamples() < target;
+	report.checkpoints_written = writer.written();
+	report.write_seconds = writer.writeSeconds();
+	for (auto n : worker_rays)
+		report.rays += n;
+	for (const auto& stats : worker_stats)
+		report.stats.merge(stats);
+	return saved;
+}
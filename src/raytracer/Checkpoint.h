@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Camera.h"
+#include "Scene.h"
+#include "TileScheduler.h"
+
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+// Checkpointed renders. The samples of a long render are summed per pixel and written to disk
+// every so often, so a render that is killed loses at most the samples since the last
+// checkpoint. A checkpoint can be rendered on from where it stopped, or given more samples per
+// pixel after it is complete. Pixels are seeded by their position and sample index only, so the
+// continued image is bit-identical to one rendered without interruption.
+//
+// A checkpoint file is only read back by the build that wrote it: it stores sums in the native
+// byte order and records the size of real, whose precision changes the samples.
+
+// Everything needed to continue a render.
+struct RenderCheckpoint {
+	uint64_t scene_hash = 0;		// Of the scene the samples come from, as computed by the caller
+	uint64_t camera_hash = 0;		// cameraHash() of the camera that rendered them
+	int width = 0;
+	int height = 0;
+	int sampler_samples = 0;		// samples_per_pixel the sampler was created with; later samples extend its pattern
+	std::vector<double> sums;		// Linear RGB sums, 3 per pixel, row by row
+	std::vector<uint32_t> samples;	// Samples in each pixel's sums
+
+	[[nodiscard]] bool empty() const noexcept { return samples.empty(); }
+	// The sums over their sample counts, 3 floats per pixel; black where there are no samples yet.
+	[[nodiscard]] std::vector<float> average() const;
+	// The fewest samples of any pixel.
+	[[nodiscard]] uint32_t completeSamples() const noexcept;
+};
+
+// 64-bit FNV-1a of bytes, continuing from hash; for building scene hashes.
+[[nodiscard]] uint64_t hashBytes(std::span<const std::byte> bytes, uint64_t hash = 0xcbf29ce484222325ull) noexcept;
+// Of every camera setting that changes the samples. The sample count, tiling, thread count and
+// execution mode are left out: they change how many samples there are or who traces them, not
+// what any one sample comes out as.
+[[nodiscard]] uint64_t cameraHash(const Camera& camera) noexcept;
+
+// Written under a temporary name and renamed, so the file at path is always a whole checkpoint.
+[[nodiscard]] bool saveCheckpoint(const std::string& path, const RenderCheckpoint& checkpoint, std::string& error);
+[[nodiscard]] bool loadCheckpoint(const std::string& path, RenderCheckpoint& checkpoint, std::string& error);
+
+struct CheckpointSettings {
+	std::string path;				// Where checkpoints go
+	double interval = 300.0;		// Seconds between checkpoints
+	// Set from elsewhere, e.g. a signal handler, to stop at the next tile; what was rendered until
+	// then is saved before renderCheckpointed() returns.
+	const std::atomic<bool>* cancel = nullptr;
+};
+
+// How a checkpointed render went.
+struct CheckpointReport {
+	uint64_t samples = 0;			// Traced by this call, not counting those already in the checkpoint
+	uint64_t rays = 0;
+	int checkpoints_written = 0;
+	double write_seconds = 0.0;		// Spent saving, on the writer thread
+	bool cancelled = false;
+	RenderStats stats;				// All zero unless built with PHOTON_ENABLE_STATS
+};
+
+// Renders until every pixel of checkpoint has camera.samples_per_pixel samples, continuing from
+// the samples already in it, and saves it to settings.path every settings.interval seconds and
+// at the end. An empty checkpoint starts a new render of camera's image. Sampling is path by
+// path and fixed whatever the camera says. Returns false if the checkpoint belongs to another
+// scene, camera or image size, or could not be saved; error says why. Being cancelled is not an
+// error: report.cancelled is set and the checkpoint holds what was rendered.
+[[nodiscard]] bool renderCheckpointed(const Camera& camera, const Scene& scene, uint64_t scene_hash,
+									  TileScheduler& scheduler, const CheckpointSettings& settings,
+									  RenderCheckpoint& checkpoint, CheckpointReport& report, std::string& error);
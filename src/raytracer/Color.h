@@ -0,0 +1,8 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+#include "Vec3.h"
+
+using Color = Vec3;
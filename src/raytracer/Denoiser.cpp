@@ -0,0 +1,233 @@
+#include "Denoiser.h"
+#include "FloatLanes.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr int band_rows = 8;			// Rows per work item
+constexpr int noise_radius = 2;			// Of the window the noise of a pixel is estimated over
+constexpr float min_albedo = 0.01f;		// Keeps the division by albedo from amplifying noise on black surfaces
+constexpr float min_noise = 1e-4f;		// Keeps the color weight finite where a window is flat
+constexpr float kernel[5] = { 1.0f / 16, 1.0f / 4, 3.0f / 8, 1.0f / 4, 1.0f / 16 };
+
+// e^x for x <= 0, to about 2e-5 relative, and 0 below e^-80.
+template <typename L>
+inline typename L::Reg expNegative(typename L::Reg x) noexcept
+{
+	x = L::mul(L::max(x, L::set1(-80.0f)), L::set1(1.44269504f));	// Now 2^x
+	const auto whole = L::truncate(x);								// Leaves a fraction in (-1, 0]
+	const auto f = L::sub(x, whole);
+	auto p = L::set1(0.00133336f);
+	for (const float c : { 0.00961813f, 0.0555041f, 0.240227f, 0.693147f, 1.0f })
+		p = L::add(L::mul(p, f), L::set1(c));
+	return L::mul(p, L::exp2Whole(whole));
+}
+
+struct ColorPlanes {
+	std::vector<float> r, g, b;
+
+	explicit ColorPlanes(size_t pixels) : r(pixels), g(pixels), b(pixels) {}
+};
+
+// The features split into planes, one float per pixel each.
+struct GuidePlanes {
+	std::vector<float> nx, ny, nz;
+	std::vector<float> ar, ag, ab;
+	std::vector<float> depth;
+	std::vector<float> noise;	// Variance of the illumination's luminance around each pixel
+};
+
+// One row of every plane.
+struct PlaneRow {
+	const float* r;
+	const float* g;
+	const float* b;
+	const float* nx;
+	const float* ny;
+	const float* nz;
+	const float* ar;
+	const float* ag;
+	const float* ab;
+	const float* depth;
+
+	PlaneRow(const ColorPlanes& color, const GuidePlanes& guide, size_t row) noexcept
+		: r(color.r.data() + row), g(color.g.data() + row), b(color.b.data() + row),
+		  nx(guide.nx.data() + row), ny(guide.ny.data() + row), nz(guide.nz.data() + row),
+		  ar(guide.ar.data() + row), ag(guide.ag.data() + row), ab(guide.ab.data() + row),
+		  depth(guide.depth.data() + row) {}
+};
+
+// Running sums of one output row, and the color weight of each of its pixels.
+struct RowSums {
+	float* r;
+	float* g;
+	float* b;
+	float* weight;
+	float* inv_color;
+};
+
+struct TapWeights {
+	float kernel;
+	float inv_normal;
+	float inv_albedo;
+	float inv_depth;	// Already divided by the tap's distance in pixels
+};
+
+// Adds the neighbour dx pixels to the right in row q to the sums of the L::width pixels from x on in row p.
+template <typename L>
+inline void addTap(const PlaneRow& p, const PlaneRow& q, const RowSums& sums, const TapWeights& tap, int x, int dx) noexcept
+{
+	using Reg = typename L::Reg;
+	const int n = x + dx;
+	const auto squared = [](Reg a, Reg b) { const Reg d = L::sub(a, b); return L::mul(d, d); };
+
+	const Reg qr = L::load(q.r + n), qg = L::load(q.g + n), qb = L::load(q.b + n);
+	const Reg color = L::add(squared(L::load(p.r + x), qr), L::add(squared(L::load(p.g + x), qg), squared(L::load(p.b + x), qb)));
+	const Reg normal = L::add(squared(L::load(p.nx + x), L::load(q.nx + n)),
+							  L::add(squared(L::load(p.ny + x), L::load(q.ny + n)), squared(L::load(p.nz + x), L::load(q.nz + n))));
+	const Reg albedo = L::add(squared(L::load(p.ar + x), L::load(q.ar + n)),
+							  L::add(squared(L::load(p.ag + x), L::load(q.ag + n)), squared(L::load(p.ab + x), L::load(q.ab + n))));
+	// Relative to the nearer depth. Equal depths include two sky pixels, whose depth is infinite.
+	const Reg zp = L::load(p.depth + x), zq = L::load(q.depth + n);
+	const Reg depth = L::div(L::zeroWhereEqual(zp, zq, L::abs(L::sub(zp, zq))), L::min(zp, zq));
+
+	const Reg exponent = L::add(L::add(L::mul(color, L::load(sums.inv_color + x)), L::mul(normal, L::set1(tap.inv_normal))),
+								L::add(L::mul(albedo, L::set1(tap.inv_albedo)), L::mul(depth, L::set1(tap.inv_depth))));
+	const Reg weight = L::mul(L::set1(tap.kernel), expNegative<L>(L::sub(L::set1(0.0f), exponent)));
+	L::store(sums.r + x, L::add(L::load(sums.r + x), L::mul(weight, qr)));
+	L::store(sums.g + x, L::add(L::load(sums.g + x), L::mul(weight, qg)));
+	L::store(sums.b + x, L::add(L::load(sums.b + x), L::mul(weight, qb)));
+	L::store(sums.weight + x, L::add(L::load(sums.weight + x), weight));
+}
+
+struct Level {
+	int step;				// Between taps, in pixels
+	float color_scale;		// Divides the noise estimate, which shrinks as the levels smooth the image
+	float inv_normal;
+	float inv_albedo;
+	float inv_depth;
+};
+
+// One a-trous level for rows [y0, y1). scratch holds 5 * width floats.
+void filterRows(const ColorPlanes& in, ColorPlanes& out, const GuidePlanes& guide, int width, int height,
+				int y0, int y1, const Level& level, std::vector<float>& scratch)
+{
+	const RowSums sums{ scratch.data(), scratch.data() + width, scratch.data() + 2 * width,
+						scratch.data() + 3 * width, scratch.data() + 4 * width };
+
+	for (int y = y0; y < y1; ++y) {
+		const auto row = static_cast<size_t>(y) * width;
+		std::fill(scratch.begin(), scratch.begin() + 4 * static_cast<size_t>(width), 0.0f);
+		for (int x = 0; x < width; ++x)
+			sums.inv_color[x] = level.color_scale / (guide.noise[row + x] + min_noise);
+		const PlaneRow p(in, guide, row);
+
+		for (int ky = -2; ky <= 2; ++ky) {
+			const int qy = y + ky * level.step;
+			if (qy < 0 || qy >= height)
+				continue;
+			const PlaneRow q(in, guide, static_cast<size_t>(qy) * width);
+			for (int kx = -2; kx <= 2; ++kx) {
+				const int dx = kx * level.step;
+				const int distance = level.step * std::max({ std::abs(kx), std::abs(ky), 1 });
+				const TapWeights tap{ kernel[ky + 2] * kernel[kx + 2], level.inv_normal, level.inv_albedo,
+									  level.inv_depth / distance };
+				// Taps past the left and right edges are left out.
+				int x = std::max(0, -dx);
+				const int x_end = std::min(width, width - dx);
+				for (; x + FloatLanes::width <= x_end; x += FloatLanes::width)
+					addTap<FloatLanes>(p, q, sums, tap, x, dx);
+				for (; x < x_end; ++x)
+					addTap<ScalarLanes>(p, q, sums, tap, x, dx);
+			}
+		}
+
+		// The center tap always counts fully, so the weight sum is never zero.
+		for (int x = 0; x < width; ++x) {
+			const float inv_weight = 1.0f / sums.weight[x];
+			out.r[row + x] = sums.r[x] * inv_weight;
+			out.g[row + x] = sums.g[x] * inv_weight;
+			out.b[row + x] = sums.b[x] * inv_weight;
+		}
+	}
+}
+
+// Variance of the luminance in the window around each pixel, as an estimate of its noise: the
+// renders give no per-pixel variance, and flat regions are where noise shows.
+std::vector<float> estimateNoise(const ColorPlanes& color, int width, int height)
+{
+	const auto pixels = static_cast<size_t>(width) * height;
+	std::vector<float> luminance(pixels);
+	for (size_t p = 0; p < pixels; ++p)
+		luminance[p] = 0.2126f * color.r[p] + 0.7152f * color.g[p] + 0.0722f * color.b[p];
+
+	std::vector<float> noise(pixels);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			double sum = 0.0, sum_squares = 0.0;
+			int count = 0;
+			for (int wy = std::max(0, y - noise_radius); wy <= std::min(height - 1, y + noise_radius); ++wy) {
+				for (int wx = std::max(0, x - noise_radius); wx <= std::min(width - 1, x + noise_radius); ++wx) {
+					const double l = luminance[static_cast<size_t>(wy) * width + wx];
+					sum += l;
+					sum_squares += l * l;
+					++count;
+				}
+			}
+			const double mean = sum / count;
+			noise[static_cast<size_t>(y) * width + x] = static_cast<float>(std::max(sum_squares / count - mean * mean, 0.0));
+		}
+	}
+	return noise;
+}
+
+}
+
+std::vector<float> denoise(std::span<const float> rgb, const FeatureBuffers& features,
+						   const DenoiseSettings& settings, TileScheduler& scheduler)
+{
+	const int width = features.width;
+	const int height = features.height;
+	const auto pixels = static_cast<size_t>(width) * height;
+
+	GuidePlanes guide;
+	for (auto* plane : { &guide.nx, &guide.ny, &guide.nz, &guide.ar, &guide.ag, &guide.ab })
+		plane->resize(pixels);
+	guide.depth.assign(features.depth.begin(), features.depth.end());
+	ColorPlanes current(pixels), next(pixels);
+	for (size_t p = 0; p < pixels; ++p) {
+		guide.nx[p] = features.normal[3 * p];
+		guide.ny[p] = features.normal[3 * p + 1];
+		guide.nz[p] = features.normal[3 * p + 2];
+		guide.ar[p] = std::max(features.albedo[3 * p], min_albedo);
+		guide.ag[p] = std::max(features.albedo[3 * p + 1], min_albedo);
+		guide.ab[p] = std::max(features.albedo[3 * p + 2], min_albedo);
+		current.r[p] = rgb[3 * p] / guide.ar[p];
+		current.g[p] = rgb[3 * p + 1] / guide.ag[p];
+		current.b[p] = rgb[3 * p + 2] / guide.ab[p];
+	}
+	guide.noise = estimateNoise(current, width, height);
+
+	std::vector<Tile> bands;
+	for (int y = 0; y < height; y += band_rows)
+		bands.push_back(Tile{ 0, y, width, std::min(y + band_rows, height) });
+	std::vector<std::vector<float>> scratch(scheduler.threadCount(), std::vector<float>(5 * static_cast<size_t>(width)));
+
+	for (int k = 0; k < settings.iterations; ++k) {
+		const Level level{ 1 << k, static_cast<float>(1 << (2 * k)) / settings.sigma_color, 1.0f / settings.sigma_normal,
+						   1.0f / settings.sigma_albedo, 1.0f / settings.sigma_depth };
+		scheduler.run(bands, [&](const Tile& band, int worker) {
+			filterRows(current, next, guide, width, height, band.y0, band.y1, level, scratch[worker]);
+		});
+		std::swap(current, next);
+	}
+
+	std::vector<float> filtered(pixels * 3);
+	for (size_t p = 0; p < pixels; ++p) {
+		filtered[3 * p] = current.r[p] * guide.ar[p];
+		filtered[3 * p + 1] = current.g[p] * guide.ag[p];
+		filtered[3 * p + 2] = current.b[p] * guide.ab[p];
+	}
+	return filtered;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Camera.h"
+#include "TileScheduler.h"
+
+#include <span>
+#include <vector>
+
+// Edge-stopping falloffs of the denoiser. A neighbour's weight drops as exp(-difference / sigma)
+// for each guide, so a larger sigma lets the filter blur across stronger edges of that guide.
+struct DenoiseSettings {
+	int iterations = 5;			// Filter levels; level k takes taps 2^k pixels apart, 5 levels reach 62 pixels out
+	float sigma_color = 8.0f;	// Squared illumination difference over the noise around the pixel, which is taken
+								// to shrink 4x per level
+	float sigma_normal = 0.1f;	// Squared normal difference
+	float sigma_depth = 0.05f;	// Depth difference relative to the nearer depth, per pixel of distance
+	float sigma_albedo = 0.05f;	// Squared albedo difference
+};
+
+// Edge-avoiding a-trous wavelet filter ("Edge-Avoiding A-Trous Wavelet Transform for fast Global
+// Illumination Filtering", Dammertz et al. 2010) guided by the first-hit features of a render.
+// The image is divided by the albedo first, so only the illumination is smoothed and texture and
+// material edges come back sharp when it is multiplied in again. Every level is a 5x5 B3-spline
+// kernel whose taps lie 2^level pixels apart, weighted down wherever illumination, normal, depth
+// or albedo differ from the center pixel. Illumination differences count relative to the variance
+// in a small window around the pixel, so the filter smooths noisy renders hard and leaves
+// converged ones mostly alone. Bands of rows go to the scheduler's threads, and each row is
+// filtered with SSE2 or AVX2 over buffers split into planes.
+//
+// rgb is a linear image, 3 floats per pixel row by row, of the size of features. Returns the
+// filtered image in the same layout.
+[[nodiscard]] std::vector<float> denoise(std::span<const float> rgb, const FeatureBuffers& features,
+										 const DenoiseSettings& settings, TileScheduler& scheduler);
@@ -0,0 +1,561 @@
+#include "Distributed.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <type_traits>
+
+namespace {
+
+// Every message is a MessageHeader followed by its payload, all in host byte order; a worker
+// with another byte order is rejected in its Hello.
+enum class MessageType : uint32_t {
+	Hello,		// Worker: protocol version, byte order, size of real, thread count
+	Job,		// Coordinator: camera settings and the RenderJob
+	Tiles,		// Coordinator: a batch of tiles to render
+	Result,		// Worker: one rendered tile
+	Stats,		// Worker: RenderStats of the last batch
+	Error,		// Either side: why it gives up on the connection
+	Done,		// Coordinator: the image is complete, the worker may exit
+};
+
+struct MessageHeader {
+	MessageType type;
+	uint32_t reserved;
+	uint64_t size;
+};
+
+constexpr uint32_t protocol_version = 2;
+constexpr uint32_t byte_order_tag = 0x01020304;
+constexpr uint64_t max_message_size = uint64_t(1) << 32;
+
+static_assert(std::is_trivially_copyable_v<RenderStats>);
+
+// Builds one message, header included, so it goes out in a single send.
+class MessageWriter {
+public:
+	explicit MessageWriter(MessageType type) : bytes(sizeof(MessageHeader))
+	{
+		const MessageHeader header{ type, 0, 0 };
+		std::memcpy(bytes.data(), &header, sizeof(header));
+	}
+
+	template <typename T>
+	void put(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		const auto* first = reinterpret_cast<const std::byte*>(&value);
+		bytes.insert(bytes.end(), first, first + sizeof(T));
+	}
+
+	void putBytes(std::span<const std::byte> data)
+	{
+		put<uint64_t>(data.size());
+		bytes.insert(bytes.end(), data.begin(), data.end());
+	}
+
+	void putString(const std::string& text) { putBytes(std::as_bytes(std::span(text))); }
+
+	[[nodiscard]] bool send(Socket& socket)
+	{
+		const uint64_t size = bytes.size() - sizeof(MessageHeader);
+		std::memcpy(bytes.data() + offsetof(MessageHeader, size), &size, sizeof(size));
+		return socket.sendAll(bytes);
+	}
+
+private:
+	std::vector<std::byte> bytes;
+};
+
+// Reads a payload front to back. Reading past its end yields zeros and clears ok.
+class MessageReader {
+public:
+	explicit MessageReader(std::span<const std::byte> payload) noexcept : rest(payload) {}
+
+	template <typename T>
+	[[nodiscard]] T get() noexcept
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		T value{};
+		if (rest.size() < sizeof(T)) {
+			ok = false;
+			return value;
+		}
+		std::memcpy(&value, rest.data(), sizeof(T));
+		rest = rest.subspan(sizeof(T));
+		return value;
+	}
+
+	[[nodiscard]] std::span<const std::byte> getBytes() noexcept
+	{
+		const auto size = get<uint64_t>();
+		if (rest.size() < size) {
+			ok = false;
+			return {};
+		}
+		const auto data = rest.first(static_cast<size_t>(size));
+		rest = rest.subspan(static_cast<size_t>(size));
+		return data;
+	}
+
+	[[nodiscard]] std::string getString()
+	{
+		const auto data = getBytes();
+		return std::string(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	[[nodiscard]] bool finished() const noexcept { return ok && rest.empty(); }
+
+	bool ok = true;
+
+private:
+	std::span<const std::byte> rest;
+};
+
+[[nodiscard]] bool receiveMessage(Socket& socket, MessageType& type, std::vector<std::byte>& payload)
+{
+	MessageHeader header;
+	if (!socket.receiveAll(std::as_writable_bytes(std::span(&header, 1))) || header.size > max_message_size)
+		return false;
+	type = header.type;
+	payload.resize(static_cast<size_t>(header.size));
+	return socket.receiveAll(payload);
+}
+
+// Collects the messages of a connection from the pieces poll() finds readable, so a peer that
+// stalls in the middle of one holds up nobody else.
+class MessageInbox {
+public:
+	// Reads what the socket has towards the current message; complete says whether it is all in.
+	// Returns false once the connection is broken or sends an oversized message.
+	[[nodiscard]] bool read(Socket& socket, bool& complete)
+	{
+		if (done) {
+			filled = 0;
+			payload.clear();
+			done = false;
+		}
+
+		std::span<std::byte> rest;
+		if (filled < sizeof(MessageHeader))
+			rest = std::as_writable_bytes(std::span(&header, 1)).subspan(filled);
+		else
+			rest = std::span(payload).subspan(filled - sizeof(MessageHeader));
+		size_t received = 0;
+		if (!rest.empty() && !socket.receiveSome(rest, received))
+			return false;
+		filled += received;
+		last_progress = std::chrono::steady_clock::now();
+
+		if (filled == sizeof(MessageHeader) && payload.empty()) {
+			if (header.size > max_message_size)
+				return false;
+			payload.resize(static_cast<size_t>(header.size));
+		}
+		done = filled == sizeof(MessageHeader) + payload.size();
+		complete = done;
+		return true;
+	}
+
+	// Part of a message is in and the rest still missing.
+	[[nodiscard]] bool partial() const noexcept { return filled > 0 && !done; }
+	[[nodiscard]] std::chrono::steady_clock::time_point lastProgress() const noexcept { return last_progress; }
+
+	// The complete message.
+	[[nodiscard]] MessageType type() const noexcept { return header.type; }
+	[[nodiscard]] std::span<const std::byte> message() const noexcept { return payload; }
+
+private:
+	MessageHeader header{};
+	std::vector<std::byte> payload;
+	size_t filled = 0;			// Bytes of header and payload read so far
+	bool done = false;
+	std::chrono::steady_clock::time_point last_progress;
+};
+
+void sendError(Socket& socket, const std::string& message)
+{
+	MessageWriter writer(MessageType::Error);
+	writer.putString(message);
+	(void)writer.send(socket);
+}
+
+void putVector(MessageWriter& writer, const Vec3& v)
+{
+	for (int i = 0; i < 3; ++i)
+		writer.put<double>(v[i]);
+}
+
+[[nodiscard]] Vec3 getVector(MessageReader& reader) noexcept
+{
+	const auto x = reader.get<double>();
+	const auto y = reader.get<double>();
+	const auto z = reader.get<double>();
+	return Vec3(x, y, z);
+}
+
+// Everything about the camera that changes pixels; the thread count stays each process's own.
+void putCamera(MessageWriter& writer, const Camera& camera)
+{
+	writer.put<int32_t>(camera.image_width);
+	writer.put<double>(camera.aspect_ratio);
+	writer.put<int32_t>(camera.samples_per_pixel);
+	writer.put<int32_t>(camera.max_depth);
+	writer.put<double>(camera.vfov);
+	putVector(writer, camera.lookfrom);
+	putVector(writer, camera.lookat);
+	putVector(writer, camera.vup);
+	writer.put<double>(camera.defocus_angle);
+	writer.put<double>(camera.focus_dist);
+	writer.put<uint8_t>(camera.russian_roulette);
+	writer.put<int32_t>(camera.roulette_min_depth);
+	writer.put<double>(camera.roulette_max_survival);
+	writer.put<int32_t>(camera.tile_size);
+	writer.put<uint32_t>(camera.seed);
+	writer.put<uint32_t>(camera.frame);
+	writer.put<uint32_t>(static_cast<uint32_t>(camera.sampler_type));
+	writer.put<uint32_t>(static_cast<uint32_t>(camera.execution_mode));
+	writer.put<uint8_t>(camera.light_sampling);
+}
+
+[[nodiscard]] Camera getCamera(MessageReader& reader) noexcept
+{
+	const auto image_width = reader.get<int32_t>();
+	const auto aspect_ratio = reader.get<double>();
+	const auto samples_per_pixel = reader.get<int32_t>();
+	const auto max_depth = reader.get<int32_t>();
+	const auto vfov = reader.get<double>();
+	const auto lookfrom = getVector(reader);
+	const auto lookat = getVector(reader);
+	const auto vup = getVector(reader);
+	const auto defocus_angle = reader.get<double>();
+	const auto focus_dist = reader.get<double>();
+	Camera camera(image_width, aspect_ratio, samples_per_pixel, max_depth, vfov, lookfrom, lookat, vup, defocus_angle, focus_dist);
+	camera.russian_roulette = reader.get<uint8_t>() != 0;
+	camera.roulette_min_depth = reader.get<int32_t>();
+	camera.roulette_max_survival = reader.get<double>();
+	camera.tile_size = reader.get<int32_t>();
+	camera.seed = reader.get<uint32_t>();
+	camera.frame = reader.get<uint32_t>();
+	camera.sampler_type = static_cast<SamplerType>(reader.get<uint32_t>());
+	camera.execution_mode = static_cast<ExecutionMode>(reader.get<uint32_t>());
+	camera.light_sampling = reader.get<uint8_t>() != 0;
+	return camera;
+}
+
+struct WorkerConnection {
+	Socket socket;
+	MessageInbox inbox;
+	int threads = 0;				// 0 until its Hello was accepted
+	std::chrono::steady_clock::time_point connected;
+	std::vector<uint32_t> outstanding;	// Tiles sent and not yet returned
+	std::deque<std::chrono::steady_clock::time_point> batches;	// When each batch whose Stats have not come back went out
+	std::chrono::steady_clock::time_point last_result;			// When the last tile came back
+};
+
+}
+
+bool renderDistributed(Camera& camera, const RenderJob& job, const Scene& scene, Socket& listener,
+					   TileScheduler& scheduler, const DistributedSettings& settings,
+					   std::vector<float>& rgb, DistributedReport& report, std::string& error)
+{
+	if (camera.adaptive_sampling) {
+		error = "adaptive sampling cannot be distributed";
+		return false;
+	}
+
+	const int width = camera.image_width;
+	const auto tiles = makeTiles(width, camera.imageHeight(), camera.tile_size);
+	rgb.assign(static_cast<size_t>(width) * camera.imageHeight() * 3, 0.0f);
+	report = DistributedReport();
+
+	MessageWriter job_message(MessageType::Job);
+	putCamera(job_message, camera);
+	job_message.putString(job.scene);
+	job_message.put<uint32_t>(job.seed);
+	job_message.put<uint32_t>(job.instance_count);
+	job_message.put<uint32_t>(job.light_count);
+	job_message.putBytes(job.scene_image);
+	job_message.putString(job.scene_directory);
+
+	std::deque<uint32_t> pending;
+	for (uint32_t i = 0; i < tiles.size(); ++i)
+		pending.push_back(i);
+	size_t remaining = tiles.size();
+
+	std::vector<std::unique_ptr<WorkerConnection>> workers;
+
+	// Hands the worker batches until it has batches_ahead of them queued.
+	auto dispatch = [&](WorkerConnection& worker) {
+		const size_t capacity = static_cast<size_t>(std::max(settings.batches_ahead, 1)) * worker.threads;
+		while (worker.outstanding.size() < capacity && !pending.empty()) {
+			const size_t count = std::min({ static_cast<size_t>(worker.threads), pending.size(), capacity - worker.outstanding.size() });
+			MessageWriter batch(MessageType::Tiles);
+			batch.put<uint32_t>(static_cast<uint32_t>(count));
+			for (size_t k = 0; k < count; ++k) {
+				const uint32_t index = pending.front();
+				pending.pop_front();
+				worker.outstanding.push_back(index);
+				const auto& tile = tiles[index];
+				batch.put<uint32_t>(index);
+				for (int value : { tile.x0, tile.y0, tile.x1, tile.y1 })
+					batch.put<int32_t>(value);
+			}
+			worker.batches.push_back(std::chrono::steady_clock::now());
+			if (!batch.send(worker.socket))
+				return false;
+		}
+		return true;
+	};
+
+	// Reads from a worker and handles its next message once it is in; false drops the worker.
+	auto receive = [&](WorkerConnection& worker) {
+		bool complete;
+		if (!worker.inbox.read(worker.socket, complete))
+			return false;
+		if (!complete)
+			return true;
+		const MessageType type = worker.inbox.type();
+		MessageReader reader(worker.inbox.message());
+
+		if (worker.threads == 0) {
+			const auto version = reader.get<uint32_t>();
+			const auto byte_order = reader.get<uint32_t>();
+			const auto real_size = reader.get<uint32_t>();
+			const auto threads = reader.get<uint32_t>();
+			if (type != MessageType::Hello || !reader.finished() || version != protocol_version
+				|| byte_order != byte_order_tag || real_size != sizeof(real)) {
+				report.worker_errors.push_back("turned away a worker of an incompatible build");
+				sendError(worker.socket, "incompatible coordinator build");
+				return false;
+			}
+			worker.threads = static_cast<int>(std::clamp<uint32_t>(threads, 1, 1024));
+			++report.workers_joined;
+			return job_message.send(worker.socket);
+		}
+
+		if (type == MessageType::Result) {
+			const auto index = reader.get<uint32_t>();
+			const auto rays = reader.get<uint64_t>();
+			const auto pixels = reader.getBytes();
+			const auto it = std::find(worker.outstanding.begin(), worker.outstanding.end(), index);
+			if (!reader.finished() || it == worker.outstanding.end()
+				|| pixels.size() != static_cast<size_t>(tiles[index].pixelCount()) * 3 * sizeof(float))
+				return false;
+			worker.outstanding.erase(it);
+			worker.last_result = std::chrono::steady_clock::now();
+
+			const auto& tile = tiles[index];
+			const size_t row_bytes = static_cast<size_t>(tile.width()) * 3 * sizeof(float);
+			for (int j = tile.y0; j < tile.y1; ++j)
+				std::memcpy(&rgb[3 * (static_cast<size_t>(j) * width + tile.x0)], &pixels[(j - tile.y0) * row_bytes], row_bytes);
+			--remaining;
+			report.rays += rays;
+			return true;
+		}
+		if (type == MessageType::Stats) {
+			const auto stats = reader.get<RenderStats>();
+			if (!reader.finished())
+				return false;
+			report.stats.merge(stats);
+			if (worker.batches.empty())
+				return false;
+			worker.batches.pop_front();
+			return true;
+		}
+		if (type == MessageType::Error)
+			report.worker_errors.push_back(reader.getString());
+		return false;
+	};
+
+	// Its unfinished tiles go to the front of the queue, so the gap it leaves closes first.
+	auto drop = [&](size_t w) {
+		auto& worker = *workers[w];
+		if (worker.threads > 0 && remaining > 0)
+			++report.workers_lost;
+		report.tiles_reissued += worker.outstanding.size();
+		pending.insert(pending.begin(), worker.outstanding.begin(), worker.outstanding.end());
+		workers.erase(workers.begin() + static_cast<std::ptrdiff_t>(w));
+	};
+
+	using Clock = std::chrono::steady_clock;
+	auto last_worker = Clock::now();
+	std::vector<Socket*> sockets;
+	std::vector<uint8_t> readable;
+	// Once the image is complete, only the counters of the last batches are still awaited.
+	auto awaiting = [&] {
+		return remaining > 0 || std::any_of(workers.begin(), workers.end(), [](const auto& worker) { return !worker->batches.empty(); });
+	};
+	while (awaiting()) {
+		// Only workers that joined count: a connection that never says Hello does not hold off the takeover.
+		if (std::any_of(workers.begin(), workers.end(), [](const auto& worker) { return worker->threads > 0; })) {
+			last_worker = Clock::now();
+		}
+		else if (std::chrono::duration<double>(Clock::now() - last_worker).count() > settings.idle_timeout) {
+			std::vector<Tile> rest;
+			for (const auto index : pending)
+				rest.push_back(tiles[index]);
+			std::vector<uint64_t> rest_rays(rest.size());
+			camera.renderTiles(scene, rest, scheduler, rgb, rest_rays);
+			for (const auto rays : rest_rays)
+				report.rays += rays;
+			report.stats.merge(camera.renderStats());
+			report.tiles_local = rest.size();
+			break;
+		}
+
+		sockets.assign(1, &listener);
+		for (const auto& worker : workers)
+			sockets.push_back(&worker->socket);
+		readable.assign(sockets.size(), 0);
+		if (!Socket::poll(sockets, readable, 100)) {
+			error = "waiting for the workers failed";
+			return false;
+		}
+
+		// Backwards, so dropping a worker does not shift the ones still to visit. A worker that is
+		// hung, stopped or cut off without its connection closing is found by its silence: its
+		// tiles go back to the queue once the oldest batch it has brings nothing back in time.
+		const auto now = Clock::now();
+		const auto seconds_since = [&](Clock::time_point then) { return std::chrono::duration<double>(now - then).count(); };
+		for (size_t w = workers.size(); w-- > 0;) {
+			auto& worker = *workers[w];
+			if (readable[w + 1]) {
+				if (!receive(worker))
+					drop(w);
+			}
+			else if (worker.inbox.partial() && seconds_since(worker.inbox.lastProgress()) > settings.message_timeout) {
+				report.worker_errors.push_back("dropped a worker that stalled in the middle of a message");
+				drop(w);
+			}
+			else if (worker.threads == 0 && seconds_since(worker.connected) > settings.message_timeout) {
+				report.worker_errors.push_back("dropped a connection that did not introduce itself as a worker");
+				drop(w);
+			}
+			else if (!worker.batches.empty()
+					 && seconds_since(std::max(worker.batches.front(), worker.last_result)) > settings.batch_timeout) {
+				report.worker_errors.push_back("dropped a worker that returned no tile in time");
+				drop(w);
+			}
+		}
+		if (readable[0]) {
+			auto socket = listener.accept();
+			if (socket.isOpen()) {
+				workers.push_back(std::make_unique<WorkerConnection>());
+				workers.back()->socket = std::move(socket);
+				workers.back()->connected = Clock::now();
+			}
+		}
+		for (size_t w = workers.size(); w-- > 0;) {
+			if (workers[w]->threads > 0 && !dispatch(*workers[w]))
+				drop(w);
+		}
+	}
+
+	for (auto& worker : workers)
+		(void)MessageWriter(MessageType::Done).send(worker->socket);
+	return true;
+}
+
+bool serveRenderJob(Socket& connection, const SceneFactory& make_scene, TileScheduler& scheduler, std::string& error)
+{
+	MessageWriter hello(MessageType::Hello);
+	hello.put<uint32_t>(protocol_version);
+	hello.put<uint32_t>(byte_order_tag);
+	hello.put<uint32_t>(sizeof(real));
+	hello.put<uint32_t>(static_cast<uint32_t>(scheduler.threadCount()));
+	if (!hello.send(connection)) {
+		error = "lost the connection to the coordinator";
+		return false;
+	}
+
+	MessageType type;
+	std::vector<std::byte> payload;
+	if (!receiveMessage(connection, type, payload)) {
+		error = "lost the connection to the coordinator";
+		return false;
+	}
+	MessageReader job_reader(payload);
+	if (type == MessageType::Error) {
+		error = "coordinator: " + job_reader.getString();
+		return false;
+	}
+	Camera camera = getCamera(job_reader);
+	RenderJob job;
+	job.scene = job_reader.getString();
+	job.seed = job_reader.get<uint32_t>();
+	job.instance_count = job_reader.get<uint32_t>();
+	job.light_count = job_reader.get<uint32_t>();
+	const auto image = job_reader.getBytes();
+	job.scene_image.assign(image.begin(), image.end());
+	job.scene_directory = job_reader.getString();
+	if (type != MessageType::Job || !job_reader.finished()) {
+		error = "malformed job from the coordinator";
+		sendError(connection, error);
+		return false;
+	}
+
+	std::shared_ptr<Scene> scene;
+	if (!make_scene(job, scene, error)) {
+		sendError(connection, error);
+		return false;
+	}
+
+	std::vector<float> rgb(static_cast<size_t>(camera.image_width) * camera.imageHeight() * 3);
+	std::vector<uint32_t> indices;
+	std::vector<Tile> tiles;
+	std::vector<uint64_t> tile_rays;
+	std::vector<float> pixels;
+	while (receiveMessage(connection, type, payload)) {
+		if (type == MessageType::Done)
+			return true;
+
+		MessageReader reader(payload);
+		const auto count = reader.get<uint32_t>();
+		indices.clear();
+		tiles.clear();
+		for (uint32_t k = 0; k < count && reader.ok; ++k) {
+			indices.push_back(reader.get<uint32_t>());
+			Tile tile;
+			tile.x0 = reader.get<int32_t>();
+			tile.y0 = reader.get<int32_t>();
+			tile.x1 = reader.get<int32_t>();
+			tile.y1 = reader.get<int32_t>();
+			tiles.push_back(tile);
+		}
+		const bool inside = std::all_of(tiles.begin(), tiles.end(), [&](const Tile& tile) {
+			return tile.x0 >= 0 && tile.y0 >= 0 && tile.x0 < tile.x1 && tile.y0 < tile.y1
+				&& tile.x1 <= camera.image_width && tile.y1 <= camera.imageHeight();
+		});
+		if (type != MessageType::Tiles || !reader.finished() || !inside) {
+			error = "malformed tiles from the coordinator";
+			sendError(connection, error);
+			return false;
+		}
+
+		tile_rays.assign(tiles.size(), 0);
+		camera.renderTiles(*scene, tiles, scheduler, rgb, tile_rays);
+		for (size_t k = 0; k < tiles.size(); ++k) {
+			const auto& tile = tiles[k];
+			pixels.clear();
+			for (int j = tile.y0; j < tile.y1; ++j) {
+				const float* row = &rgb[3 * (static_cast<size_t>(j) * camera.image_width + tile.x0)];
+				pixels.insert(pixels.end(), row, row + 3 * tile.width());
+			}
+			MessageWriter result(MessageType::Result);
+			result.put<uint32_t>(indices[k]);
+			result.put<uint64_t>(tile_rays[k]);
+			result.putBytes(std::as_bytes(std::span(pixels)));
+			if (!result.send(connection))
+				break;
+		}
+		MessageWriter stats(MessageType::Stats);
+		stats.put(camera.renderStats());
+		if (!stats.send(connection))
+			break;
+	}
+	error = "lost the connection to the coordinator";
+	return false;
+}
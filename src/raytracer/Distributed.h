@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Camera.h"
+#include "Scene.h"
+#include "Socket.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Distributed tile rendering. A coordinator splits the image into the camera's tiles and hands
+// them to worker processes that connect to it over TCP, a few batches ahead so no worker waits on
+// the network. Every worker gets the camera and scene once, when it joins. The tiles of a worker
+// that disconnects, or goes silent on its oldest batch for batch_timeout, are handed out again,
+// so a hung process or a host that lost power without closing its connections holds nothing up
+// for good. If no worker is left for a while, the
+// coordinator renders the remaining tiles itself. Pixels are seeded by their position and sample
+// index only, so the merged image is bit-identical to a local render of the same camera.
+//
+// Coordinator and workers must come from the same build: a worker of another version or
+// precision is turned away when it joins.
+
+// The scene of a job. Built-in scenes travel by name, scene files as their compiled image.
+struct RenderJob {
+	std::string scene;					// Built-in scene name, or the path of the scene file
+	uint32_t seed = 0;					// Seed of the randomly generated built-in scenes
+	uint32_t instance_count = 0;		// Copies in the instances scene
+	uint32_t light_count = 0;			// Small lights in the lights scene
+	std::vector<std::byte> scene_image;	// Compiled scene file, empty for built-in scenes
+	std::string scene_directory;		// Where the mesh paths of scene_image start
+};
+
+struct DistributedSettings {
+	int batches_ahead = 2;			// Tile batches queued per worker; a batch has a tile per worker thread
+	double idle_timeout = 10.0;		// Seconds without any connected worker before the coordinator takes over
+	double message_timeout = 10.0;	// Seconds a worker may pause in the middle of a message, or take to say Hello, before it counts as lost
+	double batch_timeout = 300.0;	// Seconds a worker may work on its oldest batch without returning a tile before it counts as lost
+};
+
+// How a distributed render went.
+struct DistributedReport {
+	int workers_joined = 0;
+	int workers_lost = 0;			// Disconnected before the render was done
+	uint64_t tiles_reissued = 0;	// Tiles handed out again after their worker was lost
+	uint64_t tiles_local = 0;		// Tiles the coordinator rendered itself
+	uint64_t rays = 0;
+	RenderStats stats;				// Counters sent back by the workers, all zero unless built with PHOTON_ENABLE_STATS
+	std::vector<std::string> worker_errors;	// Why workers were turned away or gave up
+};
+
+// Renders camera's image with the workers that connect to listener and returns it as linear RGB,
+// like Camera::renderLinear(). scene and scheduler are only used if the coordinator has to finish
+// the image itself. Adaptive sampling is not supported. On failure, error says why.
+[[nodiscard]] bool renderDistributed(Camera& camera, const RenderJob& job, const Scene& scene, Socket& listener,
+									 TileScheduler& scheduler, const DistributedSettings& settings,
+									 std::vector<float>& rgb, DistributedReport& report, std::string& error);
+
+// Builds the scene of a job on a worker.
+using SceneFactory = std::function<bool(const RenderJob& job, std::shared_ptr<Scene>& scene, std::string& error)>;
+
+// Works for the coordinator at the other end of connection until it says the image is done.
+// Returns false if the job could not be set up or the connection broke; error says why.
+[[nodiscard]] bool serveRenderJob(Socket& connection, const SceneFactory& make_scene, TileScheduler& scheduler,
+								  std::string& error);
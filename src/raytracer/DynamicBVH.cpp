@@ -0,0 +1,381 @@
+#include "DynamicBVH.h"
+#include "Instance.h"
+#include "RenderStats.h"
+#include "Sphere.h"
+
+#include <algorithm>
+
+namespace {
+
+AABB sphereBounds(const Point3& center, real radius) noexcept
+{
+	const Vec3 rvec(radius, radius, radius);
+	return AABB(center - rvec, center + rvec);
+}
+
+bool sameBounds(const AABB& a, const AABB& b) noexcept
+{
+	for (int axis = 0; axis < 3; ++axis) {
+		if (a.min[axis] != b.min[axis] || a.max[axis] != b.max[axis])
+			return false;
+	}
+	return true;
+}
+
+// Levels of a flattened tree, 1 for a single leaf.
+int treeDepth(std::span<const BVHNode> nodes)
+{
+	// Depth-first order puts every node after its parent.
+	std::vector<uint8_t> depth(nodes.size(), 1);
+	int deepest = nodes.empty() ? 0 : 1;
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		if (nodes[i].isLeaf()) {
+			deepest = std::max<int>(deepest, depth[i]);
+			continue;
+		}
+		depth[i + 1] = static_cast<uint8_t>(depth[i] + 1);
+		depth[nodes[i].offset] = static_cast<uint8_t>(depth[i] + 1);
+	}
+	return deepest;
+}
+
+// Merges pairs of sibling leaves into their parent, the ones that raise the SAH cost least first,
+// until the tree has at most max_nodes nodes. Returns false if it cannot get there.
+bool collapseToFit(std::vector<BVHNode>& nodes, size_t max_nodes)
+{
+	while (nodes.size() > max_nodes) {
+		size_t best = nodes.size();
+		double best_increase = infinity;
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			const auto& n = nodes[i];
+			if (n.isLeaf() || !nodes[i + 1].isLeaf() || !nodes[n.offset].isLeaf())
+				continue;
+			const auto& a = nodes[i + 1];
+			const auto& b = nodes[n.offset];
+			const uint32_t count = a.count + b.count;
+			if (count > 0xFFFF)
+				continue;
+			const double increase = n.bounds.surfaceArea() * (count - 1.0)
+				- a.bounds.surfaceArea() * a.count - b.bounds.surfaceArea() * b.count;
+			if (increase < best_increase) {
+				best = i;
+				best_increase = increase;
+			}
+		}
+		if (best == nodes.size())
+			return false;
+
+		// Both children are leaves, so they sit right behind the parent.
+		auto& merged = nodes[best];
+		merged.count = static_cast<uint16_t>(nodes[best + 1].count + nodes[best + 2].count);
+		merged.offset = nodes[best + 1].offset;
+		nodes.erase(nodes.begin() + best + 1, nodes.begin() + best + 3);
+		for (auto& n : nodes) {
+			if (!n.isLeaf() && n.offset > best)
+				n.offset -= 2;
+		}
+	}
+	return true;
+}
+
+}
+
+DynamicBVH::DynamicBVH(int max_leaf_size, real rebuild_ratio)
+	: max_leaf_size(max_leaf_size)
+	, rebuild_ratio(rebuild_ratio)
+{
+}
+
+DynamicBVH::Handle DynamicBVH::add(const Object& object, const AABB& box)
+{
+	const auto handle = static_cast<Handle>(handle_slot.size());
+	handle_slot.push_back(static_cast<uint32_t>(objects.size()));
+	objects.push_back(object);
+	objects.back().handle = handle;
+	boxes.push_back(box);
+	needs_rebuild = true;
+	return handle;
+}
+
+DynamicBVH::Handle DynamicBVH::addSphere(const Point3& center, real radius, uint32_t material)
+{
+	Object object;
+	object.center = center;
+	object.radius = std::max(real(0), radius);
+	object.material = material;
+	return add(object, sphereBounds(object.center, object.radius));
+}
+
+DynamicBVH::Handle DynamicBVH::addInstance(std::shared_ptr<const Hittable> geometry, const Transform& object_to_world)
+{
+	Object object;
+	object.world_to_object = object_to_world.inverse();
+	const auto box = object_to_world.applyToBox(geometry->boundingBox());
+
+	// Instances of the same geometry share one entry.
+	const auto found = std::find(geometries.begin(), geometries.end(), geometry);
+	object.geometry = static_cast<uint32_t>(found - geometries.begin());
+	if (found == geometries.end())
+		geometries.push_back(std::move(geometry));
+	return add(object, box);
+}
+
+void DynamicBVH::setSphere(Handle object, const Point3& center, real radius)
+{
+	const auto slot = handle_slot[object];
+	auto& sphere = objects[slot];
+	sphere.center = center;
+	sphere.radius = std::max(real(0), radius);
+	touch(slot, sphereBounds(sphere.center, sphere.radius));
+}
+
+void DynamicBVH::setTransform(Handle object, const Transform& object_to_world)
+{
+	const auto slot = handle_slot[object];
+	auto& instance = objects[slot];
+	instance.world_to_object = object_to_world.inverse();
+	touch(slot, object_to_world.applyToBox(geometries[instance.geometry]->boundingBox()));
+}
+
+void DynamicBVH::touch(uint32_t slot, const AABB& box)
+{
+	boxes[slot] = box;
+	// Before the first build, or with a full rebuild pending, there are no leaves to refit.
+	if (needs_rebuild)
+		return;
+	const auto leaf = slot_leaf[slot];
+	if (!leaf_changed[leaf]) {
+		leaf_changed[leaf] = 1;
+		changed_leaves.push_back(leaf);
+	}
+}
+
+AABB DynamicBVH::childBounds(uint32_t node) const noexcept
+{
+	const auto& n = node_array[node];
+	if (!n.isLeaf())
+		return surrounding_box(node_array[node + 1].bounds, node_array[n.offset].bounds);
+
+	AABB bounds;
+	for (uint32_t i = 0; i < n.count; ++i)
+		bounds.expand(boxes[n.offset + i]);
+	return bounds;
+}
+
+DynamicBVH::UpdateReport DynamicBVH::update()
+{
+	UpdateReport report;
+	if (needs_rebuild) {
+		rebuildAll(report);
+		return report;
+	}
+
+	// Refit from each changed leaf upwards until a node keeps its bounds. The topmost interior node
+	// on the way that grew too much since it was built gets rebuilt.
+	std::vector<uint32_t> degraded;
+	for (const auto leaf : changed_leaves) {
+		leaf_changed[leaf] = 0;
+		uint32_t topmost = no_node;
+		for (auto node = leaf; node != no_node; node = parents[node]) {
+			const auto bounds = childBounds(node);
+			++report.refit_nodes;
+			if (sameBounds(bounds, node_array[node].bounds))
+				break;
+			node_array[node].bounds = bounds;
+			if (!node_array[node].isLeaf() && bounds.surfaceArea() > rebuild_ratio * built_area[node])
+				topmost = node;
+		}
+		if (topmost != no_node)
+			degraded.push_back(topmost);
+	}
+	changed_leaves.clear();
+
+	std::sort(degraded.begin(), degraded.end());
+	degraded.erase(std::unique(degraded.begin(), degraded.end()), degraded.end());
+
+	// Node ranges replaced so far; degraded nodes inside them are gone.
+	std::vector<std::pair<uint32_t, uint32_t>> replaced;
+	for (const auto node : degraded) {
+		const bool gone = std::any_of(replaced.begin(), replaced.end(),
+			[&](const auto& range) { return node >= range.first && node < range.second; });
+		if (gone)
+			continue;
+		bool inside_degraded = false;
+		for (auto ancestor = parents[node]; ancestor != no_node && !inside_degraded; ancestor = parents[ancestor])
+			inside_degraded = std::binary_search(degraded.begin(), degraded.end(), ancestor);
+		if (inside_degraded)
+			continue;
+
+		const auto range = rebuildSubtree(node, report);
+		if (report.full_rebuild)
+			break;
+		replaced.push_back(range);
+	}
+
+	// Rebuilt subtrees that came out smaller leave unused nodes behind; once they make up half the
+	// array, a full rebuild packs it again.
+	if (!report.full_rebuild && unused_nodes > node_array.size() / 2)
+		rebuildAll(report);
+	return report;
+}
+
+std::pair<uint32_t, uint32_t> DynamicBVH::rebuildSubtree(uint32_t node, UpdateReport& report)
+{
+	std::vector<BVHNode> subtree;
+	std::vector<uint32_t> order;
+	for (; node != 0; node = parents[node]) {
+		// The subtree covers a contiguous run of nodes and one of slots, both ending at its rightmost leaf.
+		auto first = node;
+		while (!node_array[first].isLeaf())
+			++first;
+		auto last = node;
+		while (!node_array[last].isLeaf())
+			last = node_array[last].offset;
+		const auto slot_begin = node_array[first].offset;
+		const auto slot_end = node_array[last].offset + node_array[last].count;
+		const auto node_end = last + 1;
+
+		buildBVH(std::span<const AABB>(boxes).subspan(slot_begin, slot_end - slot_begin), subtree, order, max_leaf_size);
+		int depth = 0;
+		for (auto ancestor = parents[node]; ancestor != no_node; ancestor = parents[ancestor])
+			++depth;
+		if (!collapseToFit(subtree, node_end - node) || depth + treeDepth(subtree) > bvh_max_depth)
+			continue;
+
+		// Lay the new subtree over the old one; the nodes it leaves over become unreachable. Some of
+		// the range may be unused already, left over by an earlier rebuild inside it.
+		uint32_t unused_before = 0;
+		for (auto i = node + 1; i < node_end; ++i)
+			unused_before += parents[i] == no_node;
+		const auto new_size = static_cast<uint32_t>(subtree.size());
+		for (uint32_t i = 0; i < new_size; ++i) {
+			auto n = subtree[i];
+			n.offset += n.isLeaf() ? slot_begin : node;
+			node_array[node + i] = n;
+		}
+		for (auto unused = node + new_size; unused < node_end; ++unused)
+			parents[unused] = no_node;
+		unused_nodes = unused_nodes - unused_before + (node_end - node - new_size);
+		reorderSlots(slot_begin, order);
+		linkNodes(node, node + new_size);
+		++report.rebuilt_subtrees;
+		report.rebuilt_objects += slot_end - slot_begin;
+		return { node, node_end };
+	}
+
+	rebuildAll(report);
+	return { 0, static_cast<uint32_t>(node_array.size()) };
+}
+
+void DynamicBVH::rebuildAll(UpdateReport& report)
+{
+	std::vector<uint32_t> order;
+	buildBVH(boxes, node_array, order, max_leaf_size);
+	reorderSlots(0, order);
+
+	parents.assign(node_array.size(), no_node);
+	built_area.assign(node_array.size(), 0);
+	slot_leaf.assign(objects.size(), 0);
+	leaf_changed.assign(node_array.size(), 0);
+	changed_leaves.clear();
+	linkNodes(0, static_cast<uint32_t>(node_array.size()));
+	unused_nodes = 0;
+	needs_rebuild = false;
+
+	++report.rebuilt_subtrees;
+	report.rebuilt_objects += static_cast<uint32_t>(objects.size());
+	report.full_rebuild = true;
+}
+
+void DynamicBVH::reorderSlots(uint32_t begin, std::span<const uint32_t> order)
+{
+	std::vector<Object> reordered_objects;
+	std::vector<AABB> reordered_boxes;
+	reordered_objects.reserve(order.size());
+	reordered_boxes.reserve(order.size());
+	for (const auto index : order) {
+		reordered_objects.push_back(objects[begin + index]);
+		reordered_boxes.push_back(boxes[begin + index]);
+	}
+	std::copy(reordered_objects.begin(), reordered_objects.end(), objects.begin() + begin);
+	std::copy(reordered_boxes.begin(), reordered_boxes.end(), boxes.begin() + begin);
+	for (auto slot = begin; slot < begin + order.size(); ++slot)
+		handle_slot[objects[slot].handle] = slot;
+}
+
+void DynamicBVH::linkNodes(uint32_t begin, uint32_t end)
+{
+	for (auto node = begin; node < end; ++node) {
+		const auto& n = node_array[node];
+		built_area[node] = n.bounds.surfaceArea();
+		if (n.isLeaf()) {
+			for (uint32_t i = 0; i < n.count; ++i)
+				slot_leaf[n.offset + i] = node;
+		}
+		else {
+			parents[node + 1] = node;
+			parents[n.offset] = node;
+		}
+	}
+}
+
+bool DynamicBVH::hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept
+{
+	PHOTON_STAT(hit_calls++);
+	// Spheres fill rec in world space right away, instances in their object space, which is taken
+	// to world space once the nearest object is known.
+	uint32_t nearest = 0;
+	const bool found = traverseBVH(node_array, r, ray_t, [&](uint32_t slot, Interval& t) {
+		const auto& object = objects[slot];
+		if (object.geometry == sphere_geometry) {
+			PHOTON_STAT(primitive_tests++);
+			real root;
+			if (!Sphere::intersect(object.center, object.radius, r, t, root))
+				return false;
+			Sphere::fillHitRecord(object.center, object.radius, object.material, r, root, rec);
+		}
+		else if (!geometries[object.geometry]->hit(toObjectSpace(object.world_to_object, r), t, rec)) {
+			return false;
+		}
+		nearest = slot;
+		t.max = rec.t;
+		return true;
+	});
+	if (!found)
+		return false;
+
+	if (objects[nearest].geometry != sphere_geometry)
+		toWorldSpace(objects[nearest].world_to_object, rec);
+	return true;
+}
+
+AABB DynamicBVH::boundingBox() const noexcept
+{
+	return node_array.empty() ? AABB() : node_array.front().bounds;
+}
+
+double DynamicBVH::sahCost() const noexcept
+{
+	if (node_array.empty() || node_array.front().bounds.surfaceArea() <= 0)
+		return 0.0;
+
+	// An interior node costs one traversal step, valued like one primitive test as in buildBVH().
+	double cost = 0.0;
+	uint32_t stack[bvh_max_depth];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size > 0) {
+		const auto node = stack[--stack_size];
+		const auto& n = node_array[node];
+		const double area = n.bounds.surfaceArea();
+		if (n.isLeaf()) {
+			cost += area * n.count;
+		}
+		else {
+			cost += area;
+			stack[stack_size++] = n.offset;
+			stack[stack_size++] = node + 1;
+		}
+	}
+	return cost / node_array.front().bounds.surfaceArea();
+}
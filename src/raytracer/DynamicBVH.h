@@ -0,0 +1,105 @@
+#pragma once
+
+#include "BVH.h"
+#include "Hittable.h"
+#include "Transform.h"
+
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Geometry that moves between frames: spheres and instances of shared geometry, each addressed by
+// the handle it was added with. Moving an object only records the change; update() then refits the
+// BVH bottom-up, from the leaves of the changed objects through the ancestors whose bounds actually
+// changed, in O(changed objects * depth) instead of a rebuild of the whole scene.
+//
+// Refitting keeps the topology, which gets worse as objects drift away from the neighbours they
+// were built with. A subtree whose surface area grew past rebuild_ratio times its area at build
+// time is therefore rebuilt over the same objects, in place: if the new subtree needs more nodes
+// than the old one, the leaf pairs whose merging costs least are merged until it fits, and if that
+// is not possible its parent is rebuilt instead, up to the whole tree. The whole tree is also
+// rebuilt once half of its nodes were left unused by subtrees that came out smaller.
+//
+// No ray may be traced between a change and the next update(), nor while either runs.
+class DynamicBVH : public Hittable {
+public:
+	using Handle = uint32_t;
+
+	// What one update() did.
+	struct UpdateReport {
+		uint32_t refit_nodes = 0;		// Nodes whose bounds were recomputed
+		uint32_t rebuilt_subtrees = 0;
+		uint32_t rebuilt_objects = 0;	// Objects under the rebuilt subtrees
+		bool full_rebuild = false;
+	};
+
+	explicit DynamicBVH(int max_leaf_size = 2, real rebuild_ratio = 2);
+
+	// New objects take part after the next update(), which then rebuilds the whole tree.
+	Handle addSphere(const Point3& center, real radius, uint32_t material);
+	Handle addInstance(std::shared_ptr<const Hittable> geometry, const Transform& object_to_world);
+
+	// Moves and resizes a sphere.
+	void setSphere(Handle object, const Point3& center, real radius);
+	// Places an instance anew.
+	void setTransform(Handle object, const Transform& object_to_world);
+
+	// Brings the tree up to date with the changes since the last call.
+	UpdateReport update();
+
+	bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept override;
+	[[nodiscard]] AABB boundingBox() const noexcept override;
+
+	[[nodiscard]] size_t objectCount() const noexcept { return objects.size(); }
+	[[nodiscard]] std::span<const BVHNode> nodes() const noexcept { return node_array; }
+	// Expected cost of a ray that hits the root, in primitive intersections, by the surface area
+	// heuristic; refitting drives it up, rebuilding brings it back down.
+	[[nodiscard]] double sahCost() const noexcept;
+
+private:
+	static constexpr uint32_t sphere_geometry = ~0u;
+	static constexpr uint32_t no_node = ~0u;
+
+	struct Object {
+		Transform world_to_object;	// Instances only
+		Point3 center;				// Spheres only
+		real radius = 0;
+		uint32_t geometry = sphere_geometry;	// Index into geometries, sphere_geometry for a sphere
+		uint32_t material = 0;		// Spheres only, instances bring their own
+		Handle handle = 0;
+	};
+
+	Handle add(const Object& object, const AABB& box);
+	// Records that the object in slot got new bounds.
+	void touch(uint32_t slot, const AABB& box);
+	[[nodiscard]] AABB childBounds(uint32_t node) const noexcept;
+	void rebuildAll(UpdateReport& report);
+	// Puts the objects in the slots from begin on into the order given by a build over them.
+	void reorderSlots(uint32_t begin, std::span<const uint32_t> order);
+	// Rebuilds the subtree at node or, if the result does not fit there, one of its ancestors.
+	// Returns the range of nodes it replaced, starting at 0 for the whole tree.
+	std::pair<uint32_t, uint32_t> rebuildSubtree(uint32_t node, UpdateReport& report);
+	// Sets the parents, leaf links and build time areas of the nodes in [begin, end).
+	void linkNodes(uint32_t begin, uint32_t end);
+
+	int max_leaf_size;
+	real rebuild_ratio;
+	std::vector<std::shared_ptr<const Hittable>> geometries;
+
+	// Indexed by leaf slot.
+	std::vector<Object> objects;
+	std::vector<AABB> boxes;
+	std::vector<uint32_t> slot_leaf;	// Leaf node holding each slot
+
+	std::vector<uint32_t> handle_slot;	// Indexed by handle
+
+	std::vector<BVHNode> node_array;
+	std::vector<uint32_t> parents;		// no_node for the root and for nodes left unused by a rebuild
+	std::vector<real> built_area;		// Surface area of each node when it was built
+	size_t unused_nodes = 0;
+
+	std::vector<uint32_t> changed_leaves;
+	std::vector<uint8_t> leaf_changed;	// Whether each node is in changed_leaves
+	bool needs_rebuild = false;
+};
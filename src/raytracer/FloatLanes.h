@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PHOTON_FLOAT_LANES_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHOTON_FLOAT_LANES_SSE2
+#endif
+
+// Thin wrappers over one SIMD register of floats, for the image passes that work on float planes
+// whatever the precision of real. Kernels are templates over the lane type: FloatLanes for the
+// bulk of a row, ScalarLanes for the pixels left over at its end. Masks are registers with all
+// bits set in the selected lanes.
+
+// One float per lane, for the ends of rows and machines without SSE2.
+struct ScalarLanes {
+	using Reg = float;
+	static constexpr int width = 1;
+	static Reg set1(float v) noexcept { return v; }
+	static Reg load(const float* p) noexcept { return *p; }
+	static void store(float* p, Reg a) noexcept { *p = a; }
+	static Reg add(Reg a, Reg b) noexcept { return a + b; }
+	static Reg sub(Reg a, Reg b) noexcept { return a - b; }
+	static Reg mul(Reg a, Reg b) noexcept { return a * b; }
+	static Reg div(Reg a, Reg b) noexcept { return a / b; }
+	static Reg sqrt(Reg a) noexcept { return std::sqrt(a); }
+	// Like minps and maxps, the second operand where either is NaN.
+	static Reg min(Reg a, Reg b) noexcept { return a < b ? a : b; }
+	static Reg max(Reg a, Reg b) noexcept { return a > b ? a : b; }
+	static Reg abs(Reg a) noexcept { return a < 0 ? -a : a; }
+	static Reg zeroWhereEqual(Reg a, Reg b, Reg value) noexcept { return a == b ? 0.0f : value; }
+	// if_true where a < b, if_false elsewhere.
+	static Reg selectLess(Reg a, Reg b, Reg if_true, Reg if_false) noexcept { return a < b ? if_true : if_false; }
+	static Reg truncate(Reg a) noexcept { return static_cast<float>(static_cast<int32_t>(a)); }
+	// 2^a for a whole number a in [-126, 127].
+	static Reg exp2Whole(Reg a) noexcept
+	{
+		const int32_t bits = (static_cast<int32_t>(a) + 127) << 23;
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+};
+
+#if defined(PHOTON_FLOAT_LANES_AVX2)
+
+struct FloatLanes {
+	using Reg = __m256;
+	static constexpr int width = 8;
+	static Reg set1(float v) noexcept { return _mm256_set1_ps(v); }
+	static Reg load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+	static void store(float* p, Reg a) noexcept { _mm256_storeu_ps(p, a); }
+	static Reg add(Reg a, Reg b) noexcept { return _mm256_add_ps(a, b); }
+	static Reg sub(Reg a, Reg b) noexcept { return _mm256_sub_ps(a, b); }
+	static Reg mul(Reg a, Reg b) noexcept { return _mm256_mul_ps(a, b); }
+	static Reg div(Reg a, Reg b) noexcept { return _mm256_div_ps(a, b); }
+	static Reg sqrt(Reg a) noexcept { return _mm256_sqrt_ps(a); }
+	static Reg min(Reg a, Reg b) noexcept { return _mm256_min_ps(a, b); }
+	static Reg max(Reg a, Reg b) noexcept { return _mm256_max_ps(a, b); }
+	static Reg abs(Reg a) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static Reg zeroWhereEqual(Reg a, Reg b, Reg value) noexcept { return _mm256_andnot_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ), value); }
+	static Reg selectLess(Reg a, Reg b, Reg if_true, Reg if_false) noexcept { return _mm256_blendv_ps(if_false, if_true, _mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+	static Reg truncate(Reg a) noexcept { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+	static Reg exp2Whole(Reg a) noexcept
+	{
+		const __m256i bits = _mm256_add_epi32(_mm256_cvttps_epi32(a), _mm256_set1_epi32(127));
+		return _mm256_castsi256_ps(_mm256_slli_epi32(bits, 23));
+	}
+};
+
+#elif defined(PHOTON_FLOAT_LANES_SSE2)
+
+struct FloatLanes {
+	using Reg = __m128;
+	static constexpr int width = 4;
+	static Reg set1(float v) noexcept { return _mm_set1_ps(v); }
+	static Reg load(const float* p) noexcept { return _mm_loadu_ps(p); }
+	static void store(float* p, Reg a) noexcept { _mm_storeu_ps(p, a); }
+	static Reg add(Reg a, Reg b) noexcept { return _mm_add_ps(a, b); }
+	static Reg sub(Reg a, Reg b) noexcept { return _mm_sub_ps(a, b); }
+	static Reg mul(Reg a, Reg b) noexcept { return _mm_mul_ps(a, b); }
+	static Reg div(Reg a, Reg b) noexcept { return _mm_div_ps(a, b); }
+	static Reg sqrt(Reg a) noexcept { return _mm_sqrt_ps(a); }
+	static Reg min(Reg a, Reg b) noexcept { return _mm_min_ps(a, b); }
+	static Reg max(Reg a, Reg b) noexcept { return _mm_max_ps(a, b); }
+	static Reg abs(Reg a) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static Reg zeroWhereEqual(Reg a, Reg b, Reg value) noexcept { return _mm_andnot_ps(_mm_cmpeq_ps(a, b), value); }
+	static Reg selectLess(Reg a, Reg b, Reg if_true, Reg if_false) noexcept
+	{
+		const Reg mask = _mm_cmplt_ps(a, b);
+		return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false));
+	}
+	static Reg truncate(Reg a) noexcept { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+	static Reg exp2Whole(Reg a) noexcept
+	{
+		const __m128i bits = _mm_add_epi32(_mm_cvttps_epi32(a), _mm_set1_epi32(127));
+		return _mm_castsi128_ps(_mm_slli_epi32(bits, 23));
+	}
+};
+
+#else
+
+using FloatLanes = ScalarLanes;
+
+#endif
@@ -1,27 +1,57 @@
 #pragma once
 
 #include "Ray.h"
+#include "AABB.h"
 #include "Interval.h"
 #include "Vec3.h"
 
-class Material;
+// p, known to within p_error per coordinate on a surface with the given normal, pushed off the
+// surface along the normal to the side of `towards` until the error bound cannot put it back on the
+// other side (PBRT, section 3.9.5).
+[[nodiscard]] inline Point3 offsetRayOrigin(const Point3& p, real p_error, const Vec3& normal, const Vec3& towards) noexcept {
+	const auto d = p_error * (std::fabs(normal.x()) + std::fabs(normal.y()) + std::fabs(normal.z()));
+	const Vec3 offset = d * normal;
+	return dot(towards, normal) > 0 ? p + offset : p - offset;
+}
 
 class HitRecord {
 public:
 	Point3 p;
 	Vec3 normal;
-	std::shared_ptr<Material> mat;
-	double t{0.0};
+	uint32_t material{0};	// Index into the scene's MaterialTable
+	real t{0};
+	real p_error{0};		// Bound on the rounding error of each coordinate of p
 	bool front_face{false};
 
 	void set_face_normal(const Ray& r, const Vec3& outward_normal) noexcept {
 		front_face = dot(r.direction(), outward_normal) < 0;
 		normal = front_face ? outward_normal : -outward_normal;
 	}
+
+	// Ray leaving the surface towards `direction`. Its origin is pushed off the surface along the
+	// normal by the error bound of p, so it cannot hit the surface it starts on again and no fixed
+	// t-min is needed; a constant epsilon is too small for float far from the origin and too large
+	// for double close to it.
+	[[nodiscard]] Ray spawnRay(const Vec3& direction) const noexcept {
+		return Ray(offsetRayOrigin(p, p_error, normal, direction), direction);
+	}
+
+	// Ray from the surface to `target`, a point within target_error on a surface with normal
+	// target_normal, such as a sampled point on a light. Both ends are pushed off their surfaces,
+	// and the ray reaches the far one at t = 1, so any hit with t in (0, 1) lies between them. The
+	// far end also stays clear of the rounding of the distance a hit computes along the ray, a
+	// few ulps of t = 1, or the target's own surface would be found just short of it.
+	[[nodiscard]] Ray spawnRayTo(const Point3& target, const Vec3& target_normal, real target_error) const noexcept {
+		const Point3 origin = offsetRayOrigin(p, p_error, normal, target - p);
+		const auto end_error = target_error + error_gamma(4) * (target - origin).length();
+		const Point3 end = offsetRayOrigin(target, end_error, target_normal, origin - target);
+		return Ray(origin, end - origin);
+	}
 };
 
 class Hittable {
 public:
 	virtual ~Hittable() = default;
 	virtual bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept = 0;
+	[[nodiscard]] virtual AABB boundingBox() const noexcept = 0;
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Hittable.h"
 #include "Interval.h"
 #include "Ray.h"
+#include "RenderStats.h"
 
 #include <vector>
 
@@ -15,14 +16,21 @@ public:
 		add(object);
 	}
 
-	void clear() noexcept { objects.clear(); }
+	void clear() noexcept {
+		objects.clear();
+		bbox = AABB();
+	}
 
-	void add(std::shared_ptr<Hittable> object) noexcept { objects.push_back(object); }
+	void add(std::shared_ptr<Hittable> object) noexcept {
+		bbox.expand(object->boundingBox());
+		objects.push_back(object);
+	}
 
 	bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept override {
+		PHOTON_STAT(hit_calls++);
 		HitRecord tempRec;
 		bool hitAnything = false;
-		double closestSoFar = ray_t.max;
+		real closestSoFar = ray_t.max;
 		for (const auto& object : objects) {
 			if (object->hit(r, Interval(ray_t.min, closestSoFar), tempRec)) {
 				hitAnything = true;
@@ -32,4 +40,9 @@ public:
 		}
 		return hitAnything;
 	}
+
+	[[nodiscard]] AABB boundingBox() const noexcept override { return bbox; }
+
+private:
+	AABB bbox;
 };
\ No newline at end of file
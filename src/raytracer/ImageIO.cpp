@@ -0,0 +1,197 @@
+#include "ImageIO.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr std::array<uint32_t, 256> crc_table = [] {
+	std::array<uint32_t, 256> table{};
+	for (uint32_t n = 0; n < 256; ++n) {
+		uint32_t c = n;
+		for (int k = 0; k < 8; ++k)
+			c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		table[n] = c;
+	}
+	return table;
+}();
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) noexcept
+{
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+		crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+void appendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+	out.push_back(static_cast<uint8_t>(value >> 24));
+	out.push_back(static_cast<uint8_t>(value >> 16));
+	out.push_back(static_cast<uint8_t>(value >> 8));
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+void appendLittleEndian(std::vector<uint8_t>& out, uint64_t value, int bytes)
+{
+	for (int k = 0; k < bytes; ++k)
+		out.push_back(static_cast<uint8_t>(value >> (8 * k)));
+}
+
+void appendFloat(std::vector<uint8_t>& out, float value)
+{
+	appendLittleEndian(out, std::bit_cast<uint32_t>(value), 4);
+}
+
+// One OpenEXR header attribute: name, type name, byte size of the value, then the value.
+void appendAttribute(std::vector<uint8_t>& out, const char* name, const char* type, const std::vector<uint8_t>& value)
+{
+	out.insert(out.end(), name, name + std::strlen(name) + 1);
+	out.insert(out.end(), type, type + std::strlen(type) + 1);
+	appendLittleEndian(out, value.size(), 4);
+	out.insert(out.end(), value.begin(), value.end());
+}
+
+void writeChunk(std::ofstream& file, const char (&type)[5], const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> chunk;
+	chunk.reserve(data.size() + 12);
+	appendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	appendBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+	file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+}
+
+bool writePPM(const std::string& path, const std::vector<uint8_t>& rgba, int width, int height)
+{
+	std::ofstream file(path, std::ios::binary);
+	file << "P6\n" << width << ' ' << height << "\n255\n";
+
+	std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+	for (int j = 0; j < height; ++j) {
+		for (int i = 0; i < width; ++i)
+			std::memcpy(&row[3 * i], &rgba[4 * (static_cast<size_t>(j) * width + i)], 3);
+		file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+	}
+	return static_cast<bool>(file);
+}
+
+bool writePNG(const std::string& path, const std::vector<uint8_t>& rgba, int width, int height)
+{
+	std::ofstream file(path, std::ios::binary);
+	constexpr uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+	std::vector<uint8_t> header;
+	appendBigEndian(header, static_cast<uint32_t>(width));
+	appendBigEndian(header, static_cast<uint32_t>(height));
+	header.insert(header.end(), { 8, 6, 0, 0, 0 });	// 8 bit RGBA, deflate, no filter, no interlace
+	writeChunk(file, "IHDR", header);
+
+	// Scanlines, each prefixed with filter type 0.
+	const size_t row_bytes = static_cast<size_t>(width) * 4;
+	std::vector<uint8_t> raw;
+	raw.reserve((row_bytes + 1) * height);
+	for (int j = 0; j < height; ++j) {
+		raw.push_back(0);
+		const auto row = rgba.begin() + static_cast<std::ptrdiff_t>(j * row_bytes);
+		raw.insert(raw.end(), row, row + static_cast<std::ptrdiff_t>(row_bytes));
+	}
+
+	// zlib stream of stored deflate blocks (at most 65535 bytes each) and an Adler-32 trailer.
+	std::vector<uint8_t> zlib = { 0x78, 0x01 };
+	for (size_t offset = 0; offset < raw.size() || offset == 0;) {
+		const auto size = static_cast<uint16_t>(std::min<size_t>(raw.size() - offset, 65535));
+		const bool last = offset + size == raw.size();
+		zlib.insert(zlib.end(), { static_cast<uint8_t>(last), static_cast<uint8_t>(size), static_cast<uint8_t>(size >> 8),
+								  static_cast<uint8_t>(~size), static_cast<uint8_t>(~size >> 8) });
+		zlib.insert(zlib.end(), raw.begin() + static_cast<std::ptrdiff_t>(offset), raw.begin() + static_cast<std::ptrdiff_t>(offset + size));
+		offset += size;
+		if (last)
+			break;
+	}
+	uint32_t a = 1, b = 0;
+	for (const uint8_t byte : raw) {
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	appendBigEndian(zlib, (b << 16) | a);
+	writeChunk(file, "IDAT", zlib);
+	writeChunk(file, "IEND", {});
+	return static_cast<bool>(file);
+}
+
+bool writePFM(const std::string& path, const std::vector<float>& rgb, int width, int height)
+{
+	// A negative scale marks little-endian data; rows are stored bottom to top.
+	std::ofstream file(path, std::ios::binary);
+	file << "PF\n" << width << ' ' << height << '\n' << (std::endian::native == std::endian::little ? "-1.0" : "1.0") << '\n';
+
+	const size_t row_floats = static_cast<size_t>(width) * 3;
+	for (int j = height - 1; j >= 0; --j)
+		file.write(reinterpret_cast<const char*>(&rgb[j * row_floats]), static_cast<std::streamsize>(row_floats * sizeof(float)));
+	return static_cast<bool>(file);
+}
+
+bool writeEXR(const std::string& path, const std::vector<float>& rgb, int width, int height)
+{
+	// Channels are stored in alphabetical order, B, G, R, each as 32-bit floats.
+	constexpr char channel_names[] = { 'B', 'G', 'R' };
+	std::vector<uint8_t> channels;
+	for (const char name : channel_names) {
+		channels.insert(channels.end(), { static_cast<uint8_t>(name), 0 });
+		appendLittleEndian(channels, 2, 4);				// FLOAT
+		channels.insert(channels.end(), { 0, 0, 0, 0 });	// Not perceptually linear, reserved
+		appendLittleEndian(channels, 1, 4);				// x and y sampling
+		appendLittleEndian(channels, 1, 4);
+	}
+	channels.push_back(0);
+
+	std::vector<uint8_t> window;
+	for (const int value : { 0, 0, width - 1, height - 1 })
+		appendLittleEndian(window, static_cast<uint32_t>(value), 4);
+	std::vector<uint8_t> one, center;
+	appendFloat(one, 1.0f);
+	appendFloat(center, 0.0f);
+	appendFloat(center, 0.0f);
+
+	// Magic number, then version 2 of a single-part scanline file.
+	std::vector<uint8_t> header = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 };
+	appendAttribute(header, "channels", "chlist", channels);
+	appendAttribute(header, "compression", "compression", { 0 });	// None
+	appendAttribute(header, "dataWindow", "box2i", window);
+	appendAttribute(header, "displayWindow", "box2i", window);
+	appendAttribute(header, "lineOrder", "lineOrder", { 0 });		// Increasing y
+	appendAttribute(header, "pixelAspectRatio", "float", one);
+	appendAttribute(header, "screenWindowCenter", "v2f", center);
+	appendAttribute(header, "screenWindowWidth", "float", one);
+	header.push_back(0);
+
+	// Uncompressed files hold one scanline per block, found through a table of file offsets.
+	const size_t block_bytes = 8 + static_cast<size_t>(width) * 3 * sizeof(float);
+	const size_t first_block = header.size() + static_cast<size_t>(height) * 8;
+	for (int j = 0; j < height; ++j)
+		appendLittleEndian(header, first_block + j * block_bytes, 8);
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+	std::vector<uint8_t> block;
+	block.reserve(block_bytes);
+	for (int j = 0; j < height; ++j) {
+		block.clear();
+		appendLittleEndian(block, static_cast<uint32_t>(j), 4);
+		appendLittleEndian(block, block_bytes - 8, 4);
+		for (int c = 2; c >= 0; --c) {
+			for (int i = 0; i < width; ++i)
+				appendFloat(block, rgb[3 * (static_cast<size_t>(j) * width + i) + c]);
+		}
+		file.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size()));
+	}
+	return static_cast<bool>(file);
+}
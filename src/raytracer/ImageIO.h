@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Image file writers without external dependencies. They return false if the file cannot be written.
+
+// Binary PPM (P6) from RGBA8, alpha dropped.
+[[nodiscard]] bool writePPM(const std::string& path, const std::vector<uint8_t>& rgba, int width, int height);
+// PNG (RGBA8) with uncompressed deflate blocks: larger than a real encoder's output, but lossless
+// and readable everywhere.
+[[nodiscard]] bool writePNG(const std::string& path, const std::vector<uint8_t>& rgba, int width, int height);
+// Portable float map (PF) from linear RGB, 3 floats per pixel, for HDR output.
+[[nodiscard]] bool writePFM(const std::string& path, const std::vector<float>& rgb, int width, int height);
+// OpenEXR from linear RGB, 3 floats per pixel: uncompressed 32-bit float scanlines, which any
+// EXR reader opens.
+[[nodiscard]] bool writeEXR(const std::string& path, const std::vector<float>& rgb, int width, int height);
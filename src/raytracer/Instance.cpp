@@ -0,0 +1,83 @@
+#include "Instance.h"
+#include "RenderStats.h"
+
+Ray toObjectSpace(const Transform& world_to_object, const Ray& r) noexcept
+{
+	return Ray(world_to_object.applyToPoint(r.origin()), world_to_object.applyToVector(r.direction()));
+}
+
+// The inverse is only built here, once for the nearest hit, so an instance stores a single matrix.
+void toWorldSpace(const Transform& world_to_object, HitRecord& rec) noexcept
+{
+	const Transform object_to_world = world_to_object.inverse();
+	const Point3 p = rec.p;
+	rec.p = object_to_world.applyToPoint(p);
+	rec.p_error = object_to_world.pointError(p, rec.p_error);
+	// Sidedness is kept: dot(M d, M^-T n) = dot(d, n), so front_face stays valid.
+	rec.normal = unit_vector(world_to_object.applyTransposeToVector(rec.normal));
+}
+
+Instance::Instance(std::shared_ptr<const Hittable> geometry, const Transform& object_to_world)
+	: geometry(std::move(geometry))
+	, world_to_object(object_to_world.inverse())
+	, bbox(object_to_world.applyToBox(this->geometry->boundingBox()))
+{
+}
+
+bool Instance::hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept
+{
+	PHOTON_STAT(hit_calls++);
+	if (!geometry->hit(toObjectSpace(world_to_object, r), ray_t, rec))
+		return false;
+	toWorldSpace(world_to_object, rec);
+	return true;
+}
+
+InstanceBVH::InstanceBVH(std::vector<std::shared_ptr<const Hittable>> geometries, std::span<const Placement> placements,
+						 int max_leaf_size)
+	: geometries(std::move(geometries))
+{
+	std::vector<AABB> bounds;
+	bounds.reserve(placements.size());
+	for (const auto& placement : placements)
+		bounds.push_back(placement.object_to_world.applyToBox(this->geometries[placement.geometry]->boundingBox()));
+
+	std::vector<uint32_t> order;
+	buildBVH(bounds, nodes, order, max_leaf_size);
+
+	instances.reserve(placements.size());
+	for (const auto index : order)
+		instances.push_back(PlacedInstance{ placements[index].object_to_world.inverse(), placements[index].geometry });
+}
+
+bool InstanceBVH::hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept
+{
+	PHOTON_STAT(hit_calls++);
+	// Geometries only write rec on a hit closer than ray_t.max, so rec ends up with the object
+	// space record of the nearest instance.
+	uint32_t nearest = 0;
+	const bool found = traverseBVH(nodes, r, ray_t, [&](uint32_t slot, Interval& t) {
+		const auto& instance = instances[slot];
+		if (!geometries[instance.geometry]->hit(toObjectSpace(instance.world_to_object, r), t, rec))
+			return false;
+		nearest = slot;
+		t.max = rec.t;
+		return true;
+	});
+	if (!found)
+		return false;
+
+	toWorldSpace(instances[nearest].world_to_object, rec);
+	return true;
+}
+
+AABB InstanceBVH::boundingBox() const noexcept
+{
+	return nodes.empty() ? AABB() : nodes.front().bounds;
+}
+
+size_t InstanceBVH::memoryBytes() const noexcept
+{
+	return instances.size() * sizeof(PlacedInstance) + nodes.size() * sizeof(BVHNode)
+		+ geometries.size() * sizeof(std::shared_ptr<const Hittable>);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "BVH.h"
+#include "Hittable.h"
+#include "Transform.h"
+
+#include <memory>
+#include <vector>
+
+// The ray in the object space of an instance.
+[[nodiscard]] Ray toObjectSpace(const Transform& world_to_object, const Ray& r) noexcept;
+// Takes an object space hit record of an instance to world space.
+void toWorldSpace(const Transform& world_to_object, HitRecord& rec) noexcept;
+
+// Shared geometry placed in the world by an affine transform. The ray is taken into object space
+// instead of the geometry into world space; the direction is not renormalized, so t means the same
+// in both spaces and the geometry's own acceleration structure is used as is.
+class Instance : public Hittable {
+public:
+	Instance(std::shared_ptr<const Hittable> geometry, const Transform& object_to_world);
+
+	bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept override;
+	[[nodiscard]] AABB boundingBox() const noexcept override { return bbox; }
+
+private:
+	std::shared_ptr<const Hittable> geometry;
+	Transform world_to_object;
+	AABB bbox;
+};
+
+// Top level of a two-level acceleration structure: many placements of a few shared geometries,
+// each of which brings its own bottom-level structure (a TriangleMesh, a BVH, ...). A placement is
+// only a world-to-object matrix and a geometry index, stored in BVH leaf order, so memory grows
+// with the number of unique geometries, not with what they add up to in the world.
+class InstanceBVH : public Hittable {
+public:
+	struct Placement {
+		uint32_t geometry;			// Index into the geometries
+		Transform object_to_world;
+	};
+
+	InstanceBVH(std::vector<std::shared_ptr<const Hittable>> geometries, std::span<const Placement> placements,
+				int max_leaf_size = 2);
+
+	bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept override;
+	[[nodiscard]] AABB boundingBox() const noexcept override;
+
+	[[nodiscard]] size_t instanceCount() const noexcept { return instances.size(); }
+	// Bytes held by the placements and the top-level BVH, without the shared geometries.
+	[[nodiscard]] size_t memoryBytes() const noexcept;
+
+private:
+	struct PlacedInstance {
+		Transform world_to_object;
+		uint32_t geometry;
+	};
+
+	std::vector<std::shared_ptr<const Hittable>> geometries;
+	std::vector<PlacedInstance> instances;	// In leaf slot order
+	std::vector<BVHNode> nodes;
+};
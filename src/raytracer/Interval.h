@@ -4,23 +4,23 @@
 
 class Interval {
 public:
-    double min, max;
+    real min, max;
 
     constexpr Interval() noexcept : min(+infinity), max(-infinity) {}
-    constexpr Interval(double min, double max) noexcept : min(min), max(max) {}
+    constexpr Interval(real min, real max) noexcept : min(min), max(max) {}
 
     [[nodiscard]] constexpr bool isEmpty() const noexcept { return min > max; }
-    [[nodiscard]] constexpr double size() const noexcept { return isEmpty() ? 0.0 : max - min; }
+    [[nodiscard]] constexpr real size() const noexcept { return isEmpty() ? real(0) : max - min; }
 
-    [[nodiscard]] constexpr bool contains(double value) const noexcept {
+    [[nodiscard]] constexpr bool contains(real value) const noexcept {
         return min <= value && value <= max;
     }
 
-    [[nodiscard]] constexpr bool surrounds(double value) const noexcept {
+    [[nodiscard]] constexpr bool surrounds(real value) const noexcept {
         return min < value && value < max;
     }
 
-    [[nodiscard]] constexpr double clamp(double value) const noexcept {
+    [[nodiscard]] constexpr real clamp(real value) const noexcept {
         if (value < min) return min;
         if (value > max) return max;
         return value;
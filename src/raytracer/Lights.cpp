@@ -0,0 +1,128 @@
+#include "Lights.h"
+
+#include <algorithm>
+
+namespace {
+
+real luminance(const Color& c) noexcept
+{
+	return real(0.2126) * c.x() + real(0.7152) * c.y() + real(0.0722) * c.z();
+}
+
+}
+
+void LightList::addSphere(const Point3& center, real radius, uint32_t material)
+{
+	lights.push_back(Light{ center, Vec3(), Vec3(), radius, 4 * pi * radius * radius, material, Color() });
+}
+
+void LightList::addTriangle(const Point3& p0, const Point3& p1, const Point3& p2, uint32_t material)
+{
+	const Vec3 e1 = p1 - p0;
+	const Vec3 e2 = p2 - p0;
+	lights.push_back(Light{ p0, e1, e2, 0, cross(e1, e2).length() / 2, material, Color() });
+}
+
+void LightList::addMesh(const MeshBuffers& mesh, uint32_t material)
+{
+	lights.reserve(lights.size() + mesh.indices.size() / 3);
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		addTriangle(mesh.positions[mesh.indices[i]], mesh.positions[mesh.indices[i + 1]], mesh.positions[mesh.indices[i + 2]], material);
+}
+
+void LightList::build(const MaterialTable& materials)
+{
+	std::erase_if(lights, [&](Light& light) {
+		light.radiance = materials.emission(light.material);
+		return !(light.area > 0 && luminance(light.radiance) > 0);
+	});
+	listed.assign(materials.size(), 0);
+	bins.clear();
+	inv_total_power = 0;
+	if (lights.empty())
+		return;
+
+	double total = 0.0;
+	for (auto& light : lights) {
+		total += static_cast<double>(luminance(light.radiance)) * light.area;
+		listed[light.material] = 1;
+	}
+	inv_total_power = static_cast<real>(1.0 / total);
+
+	// Each bin starts with its light's power relative to the mean. Bins below 1 are topped up from
+	// one above, which then gives away the difference, until every bin holds exactly 1.
+	const auto n = lights.size();
+	std::vector<double> scaled(n);
+	std::vector<uint32_t> small, large;
+	for (size_t i = 0; i < n; ++i) {
+		scaled[i] = luminance(lights[i].radiance) * lights[i].area * n / total;
+		(scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+	}
+	bins.resize(n);
+	while (!small.empty() && !large.empty()) {
+		const uint32_t less = small.back();
+		const uint32_t more = large.back();
+		small.pop_back();
+		bins[less] = AliasBin{ static_cast<real>(scaled[less]), more };
+		scaled[more] -= 1.0 - scaled[less];
+		if (scaled[more] < 1.0) {
+			large.pop_back();
+			small.push_back(more);
+		}
+	}
+	// What is left is 1 up to rounding.
+	for (const auto i : small)
+		bins[i] = AliasBin{ 1, i };
+	for (const auto i : large)
+		bins[i] = AliasBin{ 1, i };
+}
+
+bool LightList::sample(const Point3& from, real u_light, Point2 u_point, LightSample& sample) const noexcept
+{
+	const real scaled = u_light * static_cast<real>(bins.size());
+	auto index = std::min(static_cast<size_t>(scaled), bins.size() - 1);
+	if (scaled - static_cast<real>(index) >= bins[index].probability)
+		index = bins[index].alias;
+	const Light& light = lights[index];
+
+	// The error bounds are those of the sphere and triangle hit points for the same sums.
+	Vec3& normal = sample.normal;
+	if (light.radius > 0) {
+		normal = sample_uniform_sphere(real(u_point.x), real(u_point.y));
+		sample.p = light.p0 + light.radius * normal;
+		sample.p_error = error_gamma(1) * std::max({ std::fabs(sample.p.x()), std::fabs(sample.p.y()), std::fabs(sample.p.z()) })
+			+ error_gamma(5) * light.radius;
+	}
+	else {
+		// Uniform on the triangle: the square root spreads the first coordinate by area.
+		const auto s = std::sqrt(real(u_point.x));
+		const Vec3 a = (s * (1 - real(u_point.y))) * light.e1;
+		const Vec3 b = (s * real(u_point.y)) * light.e2;
+		sample.p = light.p0 + a + b;
+		const Vec3 abs_sum = Vec3(std::fabs(light.p0.x()), std::fabs(light.p0.y()), std::fabs(light.p0.z()))
+			+ Vec3(std::fabs(a.x()), std::fabs(a.y()), std::fabs(a.z())) + Vec3(std::fabs(b.x()), std::fabs(b.y()), std::fabs(b.z()));
+		sample.p_error = error_gamma(7) * std::max({ abs_sum.x(), abs_sum.y(), abs_sum.z() });
+		normal = unit_vector(cross(light.e1, light.e2));
+	}
+
+	const Vec3 to_light = sample.p - from;
+	const auto distance_squared = to_light.length_squared();
+	const auto cosine = -dot(normal, to_light) / std::sqrt(distance_squared);
+	if (!(cosine > 0))
+		return false;
+	sample.radiance = light.radiance;
+	sample.pdf = luminance(light.radiance) * inv_total_power * distance_squared / cosine;
+	return true;
+}
+
+real LightList::pdf(const Ray& r, const HitRecord& rec, const Color& emitted) const noexcept
+{
+	if (rec.material >= listed.size() || !listed[rec.material])
+		return 0;
+	// Picking a light by power and a point by area gives it density luminance / total power per
+	// area, whichever light it is; the rest converts area to solid angle.
+	const auto length = r.direction().length();
+	const auto distance = rec.t * length;
+	const auto cosine = std::fabs(dot(rec.normal, r.direction())) / length;
+	return luminance(emitted) * inv_total_power * distance * distance / cosine;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Materials/MaterialTable.h"
+#include "TriangleMesh.h"
+
+#include <vector>
+
+// A point LightList::sample() picked on a light.
+struct LightSample {
+	Point3 p;
+	Vec3 normal;		// Outward normal of the light at p
+	real p_error = 0;	// Bound on the rounding error of each coordinate of p
+	Color radiance;		// Leaving p towards the shading point
+	real pdf = 0;		// Solid-angle density at the shading point, the choice of light included
+};
+
+// The emitting spheres and triangles of a scene, for next-event estimation. A light is picked in
+// proportion to its power, emitted luminance times area, through an alias table, so drawing one
+// costs the same however many there are; the point is then uniform on its surface.
+//
+// Multiple importance sampling weighs every hit on an emitter by the density of having sampled it
+// here, which it finds by the hit's material. A material must therefore be emitted either only by
+// listed surfaces or by none: the hits of an unlisted one count fully, as without light sampling.
+class LightList {
+public:
+	void addSphere(const Point3& center, real radius, uint32_t material);
+	void addTriangle(const Point3& p0, const Point3& p1, const Point3& p2, uint32_t material);
+	// Every triangle of a mesh.
+	void addMesh(const MeshBuffers& mesh, uint32_t material);
+	// Weighs the lights by the emission of their materials and builds the alias table. Call it after
+	// the last add(); lights that emit nothing are dropped.
+	void build(const MaterialTable& materials);
+
+	[[nodiscard]] bool empty() const noexcept { return bins.empty(); }
+	[[nodiscard]] size_t size() const noexcept { return lights.size(); }
+
+	// Picks a light with u_light and a point on it with u_point, to be lit from. False if the point
+	// turns its back to from.
+	[[nodiscard]] bool sample(const Point3& from, real u_light, Point2 u_point, LightSample& sample) const noexcept;
+	// The density with which sample() from the origin of r picks the point where r hit a light's
+	// front side; rec is that hit, emitted its radiance. Zero if the light is not listed.
+	[[nodiscard]] real pdf(const Ray& r, const HitRecord& rec, const Color& emitted) const noexcept;
+
+private:
+	struct Light {
+		Point3 p0;		// Center of a sphere, first vertex of a triangle
+		Vec3 e1, e2;	// Edges of a triangle from p0
+		real radius;	// Of a sphere, 0 for a triangle
+		real area;
+		uint32_t material;
+		Color radiance;
+	};
+
+	// Vose's alias method: bin i is taken with probability `probability`, alias otherwise.
+	struct AliasBin {
+		real probability;
+		uint32_t alias;
+	};
+
+	std::vector<Light> lights;
+	std::vector<AliasBin> bins;
+	std::vector<uint8_t> listed;	// Per material index: emitted by a listed light
+	real inv_total_power = 0;
+};
@@ -0,0 +1,69 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER file_size;
+	if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+		// The mapping object keeps the file open, so its handle can be closed right away.
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			size = data ? static_cast<size_t>(file_size.QuadPart) : 0;
+		}
+	}
+	CloseHandle(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+{
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return;
+
+	// The mapping stays valid after the descriptor is closed.
+	struct stat status;
+	if (::fstat(file, &status) == 0 && status.st_size > 0) {
+		void* mapped = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped != MAP_FAILED) {
+			data = static_cast<const std::byte*>(mapped);
+			size = static_cast<size_t>(status.st_size);
+		}
+	}
+	::close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data)
+		::munmap(const_cast<std::byte*>(data), size);
+}
+
+#endif
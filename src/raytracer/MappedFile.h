@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+// A whole file mapped read-only into memory. The pages are loaded on first touch and shared
+// with the OS file cache, so opening a file that was read recently costs no copy at all.
+class MappedFile {
+public:
+	// Check isOpen() for failure; an empty file cannot be mapped and fails as well.
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	[[nodiscard]] bool isOpen() const noexcept { return data != nullptr; }
+	// Page aligned, empty if the file is not open.
+	[[nodiscard]] std::span<const std::byte> bytes() const noexcept { return { data, size }; }
+
+private:
+	const std::byte* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* mapping = nullptr;	// HANDLE of the file mapping object
+#endif
+};
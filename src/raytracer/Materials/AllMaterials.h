@@ -1,4 +1,2 @@
 #pragma once
-#include "Lambertian.h"
-#include "Metal.h"
-#include "Dielectric.h"
\ No newline at end of file
+#include "MaterialTable.h"
\ No newline at end of file
@@ -1,38 +1,54 @@
+#pragma once
+
 #include "Material.h"
 
-class Dielectric : public Material {
+class Dielectric {
 public:
-	Dielectric(double refraction_index) : refraction_index(refraction_index) {}
+	Dielectric(real refraction_index) : refraction_index(refraction_index) {}
 
-	bool scatter(const Ray& r_in, const HitRecord& rec, Color& attenuation, Ray& scattered) const noexcept override {
-		attenuation = Color(1.0, 1.0, 1.0);
-		double ri = rec.front_face ? (1.0 / refraction_index) : refraction_index;
+	bool scatter(const Ray& r_in, const HitRecord& rec, Color& attenuation, Ray& scattered,
+				 Sampler& sampler) const noexcept {
+		attenuation = Color(1, 1, 1);
+		real ri = rec.front_face ? (1 / refraction_index) : refraction_index;
 
 		Vec3 unit_direction = unit_vector(r_in.direction());
-		double cos_theta = std::fmin(dot(-unit_direction, rec.normal), 1.0);
-		double sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
+		real cos_theta = std::min(dot(-unit_direction, rec.normal), real(1));
+		real sin_theta = std::sqrt(1 - cos_theta * cos_theta);
 
-		bool cannot_refract = ri * sin_theta > 1.0;
+		// Always consume the sample so every path uses the same sampler dimensions.
+		const auto u = real(sampler.get1D());
+		bool cannot_refract = ri * sin_theta > 1;
 		Vec3 direction;
 
-		if (cannot_refract || reflectance(cos_theta, ri) > random_double()) {
+		if (cannot_refract || reflectance(cos_theta, ri) > u) {
 			direction = reflect(unit_direction, rec.normal);
 		}
 		else {
 			direction = refract(unit_direction, rec.normal, ri);
 		}
 
-		scattered = Ray(rec.p, direction);
+		scattered = rec.spawnRay(direction);
 		return true;
 	}
 
+	// Clear glass passes all colors.
+	[[nodiscard]] Color albedoColor() const noexcept { return Color(1, 1, 1); }
+	[[nodiscard]] Color emission() const noexcept { return Color(0, 0, 0); }
+	[[nodiscard]] bool samplesLights() const noexcept { return false; }
+
+	[[nodiscard]] Color evaluate(const Ray&, const HitRecord&, const Vec3&, real& pdf) const noexcept {
+		pdf = 0;
+		return Color(0, 0, 0);
+	}
+
 private:
-	double refraction_index;
+	real refraction_index;
 
-	static double reflectance(double cosine, double refraction_index) {
+	static real reflectance(real cosine, real refraction_index) {
 		// Use Schlick's approximation for reflectance.
 		auto r0 = (1 - refraction_index) / (1 + refraction_index);
 		r0 = r0 * r0;
-		return r0 + (1 - r0) * std::pow((1 - cosine), 5);
+		const auto m = 1 - cosine;
+		return r0 + (1 - r0) * (m * m) * (m * m) * m;
 	}
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Material.h"
+
+// An area light: emits radiance from its front side and scatters nothing.
+class DiffuseLight {
+public:
+	DiffuseLight(const Color& radiance) : radiance(radiance) {}
+
+	bool scatter(const Ray&, const HitRecord&, Color&, Ray&, Sampler&) const noexcept { return false; }
+
+	// Its color, so the denoiser divides the light out of itself.
+	[[nodiscard]] Color albedoColor() const noexcept { return radiance; }
+	[[nodiscard]] Color emission() const noexcept { return radiance; }
+	[[nodiscard]] bool samplesLights() const noexcept { return false; }
+
+	[[nodiscard]] Color evaluate(const Ray&, const HitRecord&, const Vec3&, real& pdf) const noexcept {
+		pdf = 0;
+		return Color(0, 0, 0);
+	}
+
+private:
+	Color radiance;
+};
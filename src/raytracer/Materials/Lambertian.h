@@ -1,21 +1,36 @@
+#pragma once
+
 #include "Material.h"
 
-class Lambertian : public Material {
+class Lambertian {
 public:
 	Lambertian(const Color& albedo) : albedo(albedo) {}
 
-	bool scatter(const Ray& r_in, const HitRecord& rec, Color& attenuation, Ray& scattered) const noexcept override {
-		auto scatter_direction = rec.normal + random_unit_vector();
+	bool scatter(const Ray& r_in, const HitRecord& rec, Color& attenuation, Ray& scattered,
+				 Sampler& sampler) const noexcept {
+		const auto u = sampler.get2D();
+		auto scatter_direction = rec.normal + sample_uniform_sphere(real(u.x), real(u.y));
 
 		// Catch degenerate scatter direction
 		if (scatter_direction.near_zero())
 			scatter_direction = rec.normal;
 
-		scattered = Ray(rec.p, scatter_direction);
+		scattered = rec.spawnRay(scatter_direction);
 		attenuation = albedo;
 		return true;
 	}
 
+	[[nodiscard]] Color albedoColor() const noexcept { return albedo; }
+	[[nodiscard]] Color emission() const noexcept { return Color(0, 0, 0); }
+	[[nodiscard]] bool samplesLights() const noexcept { return true; }
+
+	// scatter() offsets the normal by a point on the unit sphere, which picks directions with
+	// density cos / pi.
+	[[nodiscard]] Color evaluate(const Ray&, const HitRecord& rec, const Vec3& direction, real& pdf) const noexcept {
+		pdf = std::max(real(0), dot(unit_vector(direction), rec.normal)) / pi;
+		return albedo * pdf;
+	}
+
 private:
 	Color albedo;
 };
\ No newline at end of file
@@ -2,11 +2,19 @@
 
 #include "../Hittable.h"
 #include "../Color.h"
+#include "../Sampler.h"
 
-class Material {
-
-public:
-	virtual ~Material() = default;
-
-	virtual bool scatter(const Ray& r_in, const HitRecord& rec, Color& attenuation, Ray& scattered) const noexcept = 0;
-};
\ No newline at end of file
+// A material is a plain value type with a non-virtual
+//   bool scatter(const Ray& r_in, const HitRecord& rec, Color& attenuation, Ray& scattered,
+//                Sampler& sampler) const noexcept;
+// a
+//   Color albedoColor() const noexcept;
+// for the albedo buffer that guides the denoiser, and for next-event estimation
+//   Color emission() const noexcept;		// Radiance leaving the front side, black for non-emitters
+//   bool samplesLights() const noexcept;	// Whether lights are sampled at its hits
+//   Color evaluate(const Ray& r_in, const HitRecord& rec, const Vec3& direction, real& pdf) const noexcept;
+// evaluate() returns the BSDF times the cosine towards direction and sets pdf to the solid-angle
+// density with which scatter() picks it; samplesLights() is false where scatter() only picks
+// mirror directions, which evaluate() cannot hit. The material is listed in the Material variant
+// of MaterialTable.h, which dispatches to it.
+// Random decisions draw from the sampler so that they benefit from stratification.
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Lambertian.h"
+#include "Metal.h"
+#include "Dielectric.h"
+#include "DiffuseLight.h"
+#include "../RenderStats.h"
+
+#include <array>
+#include <variant>
+#include <vector>
+
+using Material = std::variant<Lambertian, Metal, Dielectric, DiffuseLight>;
+
+// Names of the Material alternatives, in variant order, for statistics and logs.
+inline constexpr std::array<const char*, std::variant_size_v<Material>> material_type_names = { "lambertian", "metal", "dielectric", "diffuse_light" };
+static_assert(std::variant_size_v<Material> <= RenderStats::max_material_types);
+
+// The materials of a scene, stored by value in one contiguous array. Hit records refer to them by
+// index, so a hit copies a 32-bit integer instead of a reference-counted pointer, and scattering
+// is a switch over the variant instead of a virtual call.
+class MaterialTable {
+public:
+	// Returns the index for HitRecord::material.
+	uint32_t add(const Material& material) {
+		materials.push_back(material);
+		return static_cast<uint32_t>(materials.size() - 1);
+	}
+
+	void clear() noexcept { materials.clear(); }
+	void reserve(size_t count) { materials.reserve(count); }
+
+	[[nodiscard]] size_t size() const noexcept { return materials.size(); }
+	[[nodiscard]] const Material& operator[](uint32_t index) const noexcept { return materials[index]; }
+
+	bool scatter(const Ray& r_in, const HitRecord& rec, Color& attenuation, Ray& scattered,
+				 Sampler& sampler) const noexcept {
+		PHOTON_STAT(scatter_events[materials[rec.material].index()]++);
+		return std::visit([&](const auto& material) {
+			return material.scatter(r_in, rec, attenuation, scattered, sampler);
+		}, materials[rec.material]);
+	}
+
+	[[nodiscard]] Color albedo(uint32_t index) const noexcept {
+		return std::visit([](const auto& material) { return material.albedoColor(); }, materials[index]);
+	}
+
+	// Radiance of material `index` leaving its front side.
+	[[nodiscard]] Color emission(uint32_t index) const noexcept {
+		return std::visit([](const auto& material) { return material.emission(); }, materials[index]);
+	}
+
+	// Radiance leaving the surface of rec towards the ray that hit it; only front sides emit.
+	[[nodiscard]] Color emitted(const HitRecord& rec) const noexcept {
+		return rec.front_face ? emission(rec.material) : Color(0, 0, 0);
+	}
+
+	[[nodiscard]] bool samplesLights(uint32_t index) const noexcept {
+		return std::visit([](const auto& material) { return material.samplesLights(); }, materials[index]);
+	}
+
+	Color evaluate(const Ray& r_in, const HitRecord& rec, const Vec3& direction, real& pdf) const noexcept {
+		return std::visit([&](const auto& material) {
+			return material.evaluate(r_in, rec, direction, pdf);
+		}, materials[rec.material]);
+	}
+
+private:
+	std::vector<Material> materials;
+};
\ No newline at end of file
@@ -1,18 +1,48 @@
+#pragma once
+
 #include "Material.h"
 
-class Metal : public Material {
+class Metal {
 public:
-	Metal(const Color& albedo, double fuzz) : albedo(albedo), fuzz(fuzz < 1 ? fuzz : 1) {}
+	Metal(const Color& albedo, real fuzz) : albedo(albedo), fuzz(fuzz < 1 ? fuzz : 1) {}
 
-	bool scatter(const Ray& r_in, const HitRecord& rec, Color& attenuation, Ray& scattered) const noexcept override {
+	bool scatter(const Ray& r_in, const HitRecord& rec, Color& attenuation, Ray& scattered,
+				 Sampler& sampler) const noexcept {
 		Vec3 reflected = reflect(r_in.direction(), rec.normal);
-		reflected = unit_vector(reflected + (fuzz * random_unit_vector()));
-		scattered = Ray(rec.p, reflected);
+		const auto u = sampler.get2D();
+		reflected = unit_vector(reflected + (fuzz * sample_uniform_sphere(real(u.x), real(u.y))));
+		scattered = rec.spawnRay(reflected);
 		attenuation = albedo;
 		return (dot(scattered.direction(), rec.normal) > 0);
 	}
 
+	[[nodiscard]] Color albedoColor() const noexcept { return albedo; }
+	[[nodiscard]] Color emission() const noexcept { return Color(0, 0, 0); }
+	[[nodiscard]] bool samplesLights() const noexcept { return fuzz > 0; }
+
+	// scatter() aims at a uniform point on the sphere of radius fuzz around the mirror direction c.
+	// A direction meets that sphere at up to two distances t along it, each adding the sphere's
+	// area density 1 / (4 pi fuzz^2) times t^2 over the cosine between the direction and the
+	// sphere's normal there, which comes to sqrt(discriminant) / fuzz.
+	[[nodiscard]] Color evaluate(const Ray& r_in, const HitRecord& rec, const Vec3& direction, real& pdf) const noexcept {
+		pdf = 0;
+		const Vec3 w = unit_vector(direction);
+		if (fuzz <= 0 || dot(w, rec.normal) <= 0)
+			return Color(0, 0, 0);
+		const Vec3 c = reflect(r_in.direction(), rec.normal);
+		const auto b = dot(w, c);
+		const auto discriminant = b * b - c.length_squared() + fuzz * fuzz;
+		if (discriminant <= 0)
+			return Color(0, 0, 0);
+		const auto root = std::sqrt(discriminant);
+		for (const auto t : { b - root, b + root }) {
+			if (t > 0)
+				pdf += t * t / (4 * pi * fuzz * root);
+		}
+		return albedo * pdf;
+	}
+
 private:
 	Color albedo;
-	double fuzz;
+	real fuzz;
 };
\ No newline at end of file
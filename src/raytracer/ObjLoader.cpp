@@ -0,0 +1,160 @@
+#include "ObjLoader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint32_t no_index = ~0u;
+
+void skipSpaces(std::string_view& text) noexcept
+{
+	while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+		text.remove_prefix(1);
+}
+
+bool parseReal(std::string_view& text, real& value) noexcept
+{
+	skipSpaces(text);
+	if (!text.empty() && text.front() == '+')
+		text.remove_prefix(1);
+	double parsed;
+	const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+	if (error != std::errc())
+		return false;
+	value = static_cast<real>(parsed);
+	text.remove_prefix(static_cast<size_t>(end - text.data()));
+	return true;
+}
+
+bool parseVec3(std::string_view& text, Vec3& v) noexcept
+{
+	return parseReal(text, v[0]) && parseReal(text, v[1]) && parseReal(text, v[2]);
+}
+
+// A 1-based or negative OBJ index to a 0-based one into a list of `count` entries.
+bool parseIndex(std::string_view& text, size_t count, uint32_t& index) noexcept
+{
+	int64_t value;
+	const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	if (error != std::errc())
+		return false;
+	text.remove_prefix(static_cast<size_t>(end - text.data()));
+
+	const int64_t resolved = value < 0 ? static_cast<int64_t>(count) + value : value - 1;
+	if (value == 0 || resolved < 0 || resolved >= static_cast<int64_t>(count))
+		return false;
+	index = static_cast<uint32_t>(resolved);
+	return true;
+}
+
+bool usableNormal(const Vec3& n) noexcept
+{
+	const real l1 = std::fabs(n.x()) + std::fabs(n.y()) + std::fabs(n.z());
+	return l1 > 0 && std::isfinite(l1);
+}
+
+}
+
+bool loadOBJ(const std::string& path, MeshBuffers& mesh, std::string& error)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		error = path + ": cannot open";
+		return false;
+	}
+
+	mesh = MeshBuffers();
+	std::vector<Point3> positions;
+	std::vector<Vec3> normals;
+	// Output vertex of each position used without a normal, and of each position/normal pair.
+	std::vector<uint32_t> position_vertices;
+	std::unordered_map<uint64_t, uint32_t> pair_vertices;
+	bool all_normals = true;
+
+	auto outputVertex = [&](uint32_t position, uint32_t normal) {
+		// A zero-length normal has no direction to shade with, and encoding it for the mesh would
+		// divide by zero; it counts as none.
+		if (normal != no_index && !usableNormal(normals[normal]))
+			normal = no_index;
+		uint32_t* vertex;
+		if (normal == no_index) {
+			all_normals = false;
+			if (position_vertices.size() <= position)
+				position_vertices.resize(positions.size(), no_index);
+			vertex = &position_vertices[position];
+		}
+		else {
+			vertex = &pair_vertices.try_emplace((uint64_t(position) << 32) | normal, no_index).first->second;
+		}
+		if (*vertex == no_index) {
+			*vertex = static_cast<uint32_t>(mesh.positions.size());
+			mesh.positions.push_back(positions[position]);
+			mesh.normals.push_back(normal == no_index ? Vec3(0, 0, 0) : normals[normal]);
+		}
+		return *vertex;
+	};
+
+	std::string line;
+	std::vector<uint32_t> polygon;
+	for (size_t line_number = 1; std::getline(file, line); ++line_number) {
+		std::string_view text = line;
+		if (!text.empty() && text.back() == '\r')
+			text.remove_suffix(1);
+		skipSpaces(text);
+
+		const auto keyword_end = text.find_first_of(" \t");
+		const auto keyword = text.substr(0, keyword_end);
+		text.remove_prefix(keyword.size());
+
+		bool ok = true;
+		if (keyword == "v") {
+			Point3 p;
+			ok = parseVec3(text, p);	// An optional w is ignored
+			positions.push_back(p);
+		}
+		else if (keyword == "vn") {
+			Vec3 n;
+			ok = parseVec3(text, n);
+			normals.push_back(n);
+		}
+		else if (keyword == "f") {
+			polygon.clear();
+			skipSpaces(text);
+			while (ok && !text.empty()) {
+				uint32_t position, normal = no_index;
+				ok = parseIndex(text, positions.size(), position);
+				if (ok && !text.empty() && text.front() == '/') {
+					// Texture coordinates are not kept.
+					text.remove_prefix(1);
+					text.remove_prefix(std::min(text.find_first_of("/ \t"), text.size()));
+					if (ok && !text.empty() && text.front() == '/') {
+						text.remove_prefix(1);
+						ok = parseIndex(text, normals.size(), normal);
+					}
+				}
+				ok = ok && (text.empty() || text.front() == ' ' || text.front() == '\t');
+				if (ok)
+					polygon.push_back(outputVertex(position, normal));
+				skipSpaces(text);
+			}
+			ok = ok && polygon.size() >= 3;
+			for (size_t k = 1; ok && k + 1 < polygon.size(); ++k)
+				mesh.indices.insert(mesh.indices.end(), { polygon[0], polygon[k], polygon[k + 1] });
+		}
+
+		if (!ok) {
+			error = path + ":" + std::to_string(line_number) + ": invalid '" + std::string(keyword) + "' record";
+			mesh = MeshBuffers();
+			return false;
+		}
+	}
+
+	if (!all_normals)
+		mesh.normals.clear();
+	return true;
+}
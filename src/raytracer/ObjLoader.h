@@ -0,0 +1,14 @@
+#pragma once
+
+#include "TriangleMesh.h"
+
+#include <string>
+
+// Reads the triangles of a Wavefront OBJ file: v and vn records, and f records in the v, v/vt,
+// v//vn and v/vt/vn forms with absolute or negative (relative) indices. Polygons are split into
+// triangle fans; texture coordinates, groups and material libraries are skipped. The file is
+// streamed line by line, so besides the output only the OBJ's own vertex lists are held in memory.
+// Vertices are shared wherever faces share a position/normal pair; normals are kept only if every
+// face vertex has one, and a zero-length or non-finite vn counts as none, so such meshes shade with
+// their geometric normals. On failure, error holds "path:line: message".
+[[nodiscard]] bool loadOBJ(const std::string& path, MeshBuffers& mesh, std::string& error);
@@ -0,0 +1,291 @@
+#include "PackedSpheres.h"
+#include "RenderStats.h"
+#include "Sphere.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PHOTON_PACKED_SPHERES_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHOTON_PACKED_SPHERES_SSE2
+#endif
+
+namespace {
+
+struct SphereArrays {
+	const real* cx;
+	const real* cy;
+	const real* cz;
+	const real* radius;
+	size_t padded_count;
+};
+
+// Thin wrappers over one SIMD register of reals, so the kernel below is written once for every
+// instruction set and precision. Masks are registers with all bits set in the selected lanes.
+
+#if defined(PHOTON_PACKED_SPHERES_AVX2) && defined(PHOTON_USE_FLOAT)
+
+struct Lanes {
+	using Reg = __m256;
+	static constexpr int width = 8;
+	static Reg set1(real v) noexcept { return _mm256_set1_ps(v); }
+	static Reg iota() noexcept { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+	static Reg load(const real* p) noexcept { return _mm256_loadu_ps(p); }
+	static void store(real* p, Reg a) noexcept { _mm256_storeu_ps(p, a); }
+	static Reg add(Reg a, Reg b) noexcept { return _mm256_add_ps(a, b); }
+	static Reg sub(Reg a, Reg b) noexcept { return _mm256_sub_ps(a, b); }
+	static Reg mul(Reg a, Reg b) noexcept { return _mm256_mul_ps(a, b); }
+	static Reg div(Reg a, Reg b) noexcept { return _mm256_div_ps(a, b); }
+	static Reg fmadd(Reg a, Reg b, Reg c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+	static Reg fnmadd(Reg a, Reg b, Reg c) noexcept { return _mm256_fnmadd_ps(a, b, c); }
+	static Reg sqrt(Reg a) noexcept { return _mm256_sqrt_ps(a); }
+	static Reg min(Reg a, Reg b) noexcept { return _mm256_min_ps(a, b); }
+	static Reg max(Reg a, Reg b) noexcept { return _mm256_max_ps(a, b); }
+	static Reg signOf(Reg a) noexcept { return _mm256_and_ps(a, _mm256_set1_ps(-0.0f)); }
+	static Reg bitOr(Reg a, Reg b) noexcept { return _mm256_or_ps(a, b); }
+	static Reg bitAnd(Reg a, Reg b) noexcept { return _mm256_and_ps(a, b); }
+	static Reg ge(Reg a, Reg b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static Reg gt(Reg a, Reg b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static Reg lt(Reg a, Reg b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Reg select(Reg mask, Reg if_true, Reg if_false) noexcept { return _mm256_blendv_ps(if_false, if_true, mask); }
+	static bool any(Reg mask) noexcept { return _mm256_movemask_ps(mask) != 0; }
+};
+
+#elif defined(PHOTON_PACKED_SPHERES_AVX2)
+
+struct Lanes {
+	using Reg = __m256d;
+	static constexpr int width = 4;
+	static Reg set1(real v) noexcept { return _mm256_set1_pd(v); }
+	static Reg iota() noexcept { return _mm256_setr_pd(0, 1, 2, 3); }
+	static Reg load(const real* p) noexcept { return _mm256_loadu_pd(p); }
+	static void store(real* p, Reg a) noexcept { _mm256_storeu_pd(p, a); }
+	static Reg add(Reg a, Reg b) noexcept { return _mm256_add_pd(a, b); }
+	static Reg sub(Reg a, Reg b) noexcept { return _mm256_sub_pd(a, b); }
+	static Reg mul(Reg a, Reg b) noexcept { return _mm256_mul_pd(a, b); }
+	static Reg div(Reg a, Reg b) noexcept { return _mm256_div_pd(a, b); }
+	static Reg fmadd(Reg a, Reg b, Reg c) noexcept { return _mm256_fmadd_pd(a, b, c); }
+	static Reg fnmadd(Reg a, Reg b, Reg c) noexcept { return _mm256_fnmadd_pd(a, b, c); }
+	static Reg sqrt(Reg a) noexcept { return _mm256_sqrt_pd(a); }
+	static Reg min(Reg a, Reg b) noexcept { return _mm256_min_pd(a, b); }
+	static Reg max(Reg a, Reg b) noexcept { return _mm256_max_pd(a, b); }
+	static Reg signOf(Reg a) noexcept { return _mm256_and_pd(a, _mm256_set1_pd(-0.0)); }
+	static Reg bitOr(Reg a, Reg b) noexcept { return _mm256_or_pd(a, b); }
+	static Reg bitAnd(Reg a, Reg b) noexcept { return _mm256_and_pd(a, b); }
+	static Reg ge(Reg a, Reg b) noexcept { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+	static Reg gt(Reg a, Reg b) noexcept { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+	static Reg lt(Reg a, Reg b) noexcept { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	static Reg select(Reg mask, Reg if_true, Reg if_false) noexcept { return _mm256_blendv_pd(if_false, if_true, mask); }
+	static bool any(Reg mask) noexcept { return _mm256_movemask_pd(mask) != 0; }
+};
+
+#elif defined(PHOTON_PACKED_SPHERES_SSE2) && defined(PHOTON_USE_FLOAT)
+
+struct Lanes {
+	using Reg = __m128;
+	static constexpr int width = 4;
+	static Reg set1(real v) noexcept { return _mm_set1_ps(v); }
+	static Reg iota() noexcept { return _mm_setr_ps(0, 1, 2, 3); }
+	static Reg load(const real* p) noexcept { return _mm_loadu_ps(p); }
+	static void store(real* p, Reg a) noexcept { _mm_storeu_ps(p, a); }
+	static Reg add(Reg a, Reg b) noexcept { return _mm_add_ps(a, b); }
+	static Reg sub(Reg a, Reg b) noexcept { return _mm_sub_ps(a, b); }
+	static Reg mul(Reg a, Reg b) noexcept { return _mm_mul_ps(a, b); }
+	static Reg div(Reg a, Reg b) noexcept { return _mm_div_ps(a, b); }
+	static Reg fmadd(Reg a, Reg b, Reg c) noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	static Reg fnmadd(Reg a, Reg b, Reg c) noexcept { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+	static Reg sqrt(Reg a) noexcept { return _mm_sqrt_ps(a); }
+	static Reg min(Reg a, Reg b) noexcept { return _mm_min_ps(a, b); }
+	static Reg max(Reg a, Reg b) noexcept { return _mm_max_ps(a, b); }
+	static Reg signOf(Reg a) noexcept { return _mm_and_ps(a, _mm_set1_ps(-0.0f)); }
+	static Reg bitOr(Reg a, Reg b) noexcept { return _mm_or_ps(a, b); }
+	static Reg bitAnd(Reg a, Reg b) noexcept { return _mm_and_ps(a, b); }
+	static Reg ge(Reg a, Reg b) noexcept { return _mm_cmpge_ps(a, b); }
+	static Reg gt(Reg a, Reg b) noexcept { return _mm_cmpgt_ps(a, b); }
+	static Reg lt(Reg a, Reg b) noexcept { return _mm_cmplt_ps(a, b); }
+	static Reg select(Reg mask, Reg if_true, Reg if_false) noexcept { return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false)); }
+	static bool any(Reg mask) noexcept { return _mm_movemask_ps(mask) != 0; }
+};
+
+#elif defined(PHOTON_PACKED_SPHERES_SSE2)
+
+struct Lanes {
+	using Reg = __m128d;
+	static constexpr int width = 2;
+	static Reg set1(real v) noexcept { return _mm_set1_pd(v); }
+	static Reg iota() noexcept { return _mm_setr_pd(0, 1); }
+	static Reg load(const real* p) noexcept { return _mm_loadu_pd(p); }
+	static void store(real* p, Reg a) noexcept { _mm_storeu_pd(p, a); }
+	static Reg add(Reg a, Reg b) noexcept { return _mm_add_pd(a, b); }
+	static Reg sub(Reg a, Reg b) noexcept { return _mm_sub_pd(a, b); }
+	static Reg mul(Reg a, Reg b) noexcept { return _mm_mul_pd(a, b); }
+	static Reg div(Reg a, Reg b) noexcept { return _mm_div_pd(a, b); }
+	static Reg fmadd(Reg a, Reg b, Reg c) noexcept { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+	static Reg fnmadd(Reg a, Reg b, Reg c) noexcept { return _mm_sub_pd(c, _mm_mul_pd(a, b)); }
+	static Reg sqrt(Reg a) noexcept { return _mm_sqrt_pd(a); }
+	static Reg min(Reg a, Reg b) noexcept { return _mm_min_pd(a, b); }
+	static Reg max(Reg a, Reg b) noexcept { return _mm_max_pd(a, b); }
+	static Reg signOf(Reg a) noexcept { return _mm_and_pd(a, _mm_set1_pd(-0.0)); }
+	static Reg bitOr(Reg a, Reg b) noexcept { return _mm_or_pd(a, b); }
+	static Reg bitAnd(Reg a, Reg b) noexcept { return _mm_and_pd(a, b); }
+	static Reg ge(Reg a, Reg b) noexcept { return _mm_cmpge_pd(a, b); }
+	static Reg gt(Reg a, Reg b) noexcept { return _mm_cmpgt_pd(a, b); }
+	static Reg lt(Reg a, Reg b) noexcept { return _mm_cmplt_pd(a, b); }
+	static Reg select(Reg mask, Reg if_true, Reg if_false) noexcept { return _mm_or_pd(_mm_and_pd(mask, if_true), _mm_andnot_pd(mask, if_false)); }
+	static bool any(Reg mask) noexcept { return _mm_movemask_pd(mask) != 0; }
+};
+
+#endif
+
+#if defined(PHOTON_PACKED_SPHERES_AVX2) || defined(PHOTON_PACKED_SPHERES_SSE2)
+
+// Sphere::intersect for Lanes::width spheres at a time. Each lane tracks its own nearest hit; the
+// lanes are reduced at the end. Lane indices are kept as reals, exact up to 2^24 spheres in float.
+bool nearestKernel(const SphereArrays& s, const Ray& r, Interval ray_t, uint32_t& index, real& t) noexcept
+{
+	using L = Lanes;
+	using Reg = L::Reg;
+
+	const auto& o = r.origin();
+	const auto& d = r.direction();
+	const Reg ox = L::set1(o.x()), oy = L::set1(o.y()), oz = L::set1(o.z());
+	const Reg dx = L::set1(d.x()), dy = L::set1(d.y()), dz = L::set1(d.z());
+	const Reg a = L::set1(d.length_squared());
+	const Reg inv_a = L::set1(1 / d.length_squared());
+	const Reg t_min = L::set1(ray_t.min);
+	const Reg zero = L::set1(0);
+	const Reg step = L::set1(L::width);
+
+	Reg best_t = L::set1(ray_t.max);
+	Reg best_i = L::set1(-1);
+	Reg lane_i = L::iota();
+
+	for (size_t i = 0; i < s.padded_count; i += L::width, lane_i = L::add(lane_i, step)) {
+		const Reg ocx = L::sub(L::load(s.cx + i), ox);
+		const Reg ocy = L::sub(L::load(s.cy + i), oy);
+		const Reg ocz = L::sub(L::load(s.cz + i), oz);
+		const Reg rad = L::load(s.radius + i);
+
+		const Reg h = L::fmadd(ocx, dx, L::fmadd(ocy, dy, L::mul(ocz, dz)));
+		const Reg h_over_a = L::mul(h, inv_a);
+		const Reg lx = L::fnmadd(h_over_a, dx, ocx);
+		const Reg ly = L::fnmadd(h_over_a, dy, ocy);
+		const Reg lz = L::fnmadd(h_over_a, dz, ocz);
+		const Reg l2 = L::fmadd(lz, lz, L::fmadd(ly, ly, L::mul(lx, lx)));
+		const Reg disc = L::mul(a, L::sub(L::mul(rad, rad), l2));
+
+		const Reg valid = L::ge(disc, zero);
+		if (!L::any(valid)) [[likely]]
+			continue;
+
+		const Reg oc2 = L::fmadd(ocz, ocz, L::fmadd(ocy, ocy, L::mul(ocx, ocx)));
+		const Reg c = L::fnmadd(rad, rad, oc2);
+		const Reg q = L::add(h, L::bitOr(L::sqrt(L::max(disc, zero)), L::signOf(h)));
+		const Reg t_a = L::mul(q, inv_a);
+		const Reg t_b = L::div(c, q);
+		const Reg t0 = L::min(t_a, t_b);
+		const Reg t1 = L::max(t_a, t_b);
+		const Reg in0 = L::bitAnd(L::gt(t0, t_min), L::lt(t0, best_t));
+		const Reg in1 = L::bitAnd(L::gt(t1, t_min), L::lt(t1, best_t));
+
+		const Reg root = L::select(in0, t0, t1);
+		const Reg take = L::bitAnd(valid, L::bitOr(in0, in1));
+		best_t = L::select(take, root, best_t);
+		best_i = L::select(take, lane_i, best_i);
+	}
+
+	real lane_t[L::width], lane_index[L::width];
+	L::store(lane_t, best_t);
+	L::store(lane_index, best_i);
+
+	bool found = false;
+	for (int lane = 0; lane < L::width; ++lane) {
+		if (lane_index[lane] >= 0 && (!found || lane_t[lane] < t)) {
+			found = true;
+			t = lane_t[lane];
+			index = static_cast<uint32_t>(lane_index[lane]);
+		}
+	}
+	return found;
+}
+
+#else
+
+bool nearestKernel(const SphereArrays& s, const Ray& r, Interval ray_t, uint32_t& index, real& t) noexcept
+{
+	bool found = false;
+	for (size_t i = 0; i < s.padded_count; ++i) {
+		if (Sphere::intersect(Point3(s.cx[i], s.cy[i], s.cz[i]), s.radius[i], r, ray_t, t)) {
+			found = true;
+			ray_t.max = t;
+			index = static_cast<uint32_t>(i);
+		}
+	}
+	return found;
+}
+
+#endif
+
+}
+
+void PackedSpheres::add(const Point3& center, real r, uint32_t material)
+{
+	r = std::max(real(0), r);
+	const Vec3 rvec(r, r, r);
+	bbox.expand(AABB(center - rvec, center + rvec));
+
+	// Drop the padding, append, then pad again.
+	center_x.resize(count);
+	center_y.resize(count);
+	center_z.resize(count);
+	radius.resize(count);
+
+	center_x.push_back(center.x());
+	center_y.push_back(center.y());
+	center_z.push_back(center.z());
+	radius.push_back(r);
+	materials.push_back(material);
+	++count;
+
+	const auto padded = (count + lane_width - 1) / lane_width * lane_width;
+	constexpr auto nan = std::numeric_limits<real>::quiet_NaN();
+	center_x.resize(padded, nan);
+	center_y.resize(padded, nan);
+	center_z.resize(padded, nan);
+	radius.resize(padded, 0);
+}
+
+void PackedSpheres::clear() noexcept
+{
+	center_x.clear();
+	center_y.clear();
+	center_z.clear();
+	radius.clear();
+	materials.clear();
+	count = 0;
+	bbox = AABB();
+}
+
+bool PackedSpheres::nearest(const Ray& r, Interval ray_t, uint32_t& index, real& t) const noexcept
+{
+	const SphereArrays arrays{ center_x.data(), center_y.data(), center_z.data(), radius.data(), center_x.size() };
+	return nearestKernel(arrays, r, ray_t, index, t);
+}
+
+bool PackedSpheres::hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept
+{
+	PHOTON_STAT(hit_calls++);
+	PHOTON_STAT(primitive_tests += count);
+	uint32_t index;
+	real t;
+	if (!nearest(r, ray_t, index, t))
+		return false;
+
+	// Full attributes only for the winner.
+	const Point3 center(center_x[index], center_y[index], center_z[index]);
+	Sphere::fillHitRecord(center, radius[index], materials[index], r, t, rec);
+	return true;
+}
@@ -0,0 +1,350 @@
+#include "ProgressiveRenderer.h"
+#include "Denoiser.h"
+#include "Tonemap.h"
+
+#include <algorithm>
+
+namespace {
+
+// Block sizes of the coarse previews shown after a camera change, coarsest first.
+constexpr int preview_blocks[] = { 8, 4, 2 };
+
+[[nodiscard]] constexpr bool isPowerOfTwo(int n) noexcept
+{
+	return n > 0 && (n & (n - 1)) == 0;
+}
+
+}
+
+ProgressiveRenderer::ProgressiveRenderer(std::shared_ptr<const Scene> scene, const Camera& camera)
+	: scene(std::move(scene))
+	, camera(camera)
+	, image_width(camera.image_width)
+	, image_height(camera.imageHeight())
+	, target_passes(camera.samples_per_pixel)
+	, tiles(makeTiles(camera.image_width, camera.imageHeight(), camera.tile_size))
+	, tile_samples(tiles.size(), 0)
+	, accumulation(static_cast<size_t>(camera.image_width) * camera.imageHeight() * 3, 0.0f)
+	, pending_display(camera.display)
+	, display_settings(camera.display)
+	, display(static_cast<size_t>(camera.image_width) * camera.imageHeight() * 4, 0)
+	, tile_dirty(tiles.size(), 0)
+{
+	feature_sums.resize(image_width, image_height);
+}
+
+ProgressiveRenderer::~ProgressiveRenderer()
+{
+	stop();
+}
+
+void ProgressiveRenderer::start()
+{
+	if (isRunning() || (completedPasses() >= targetPasses() && !camera_changed.load(std::memory_order_acquire)))
+		return;
+	launch();
+}
+
+void ProgressiveRenderer::launch()
+{
+	if (thread.joinable())
+		thread.join();
+
+	if (start_time == std::chrono::steady_clock::time_point{})
+		start_time = std::chrono::steady_clock::now();
+
+	stop_requested.store(false, std::memory_order_release);
+	running.store(true, std::memory_order_release);
+	thread = std::thread(&ProgressiveRenderer::renderLoop, this);
+}
+
+void ProgressiveRenderer::stop()
+{
+	stop_requested.store(true, std::memory_order_release);
+	if (thread.joinable())
+		thread.join();
+}
+
+void ProgressiveRenderer::setCamera(const Camera& new_camera)
+{
+	{
+		// The render thread decides to exit under the same lock, so it either sees the new
+		// camera or has already cleared running.
+		std::lock_guard lock(camera_mutex);
+		pending_camera = new_camera;
+		camera_changed.store(true, std::memory_order_release);
+		if (isRunning())
+			return;
+	}
+	launch();
+}
+
+void ProgressiveRenderer::setDenoise(bool enabled)
+{
+	{
+		std::lock_guard lock(camera_mutex);
+		denoise_enabled.store(enabled, std::memory_order_release);
+		display_changed.store(true, std::memory_order_release);
+		if (isRunning())
+			return;
+	}
+	launch();
+}
+
+void ProgressiveRenderer::setDisplay(const DisplaySettings& settings)
+{
+	{
+		std::lock_guard lock(camera_mutex);
+		pending_display = settings;
+		display_changed.store(true, std::memory_order_release);
+		if (isRunning())
+			return;
+	}
+	launch();
+}
+
+RenderStats ProgressiveRenderer::renderStats() const
+{
+	std::lock_guard lock(stats_mutex);
+	return stats;
+}
+
+bool ProgressiveRenderer::hasUpdates()
+{
+	std::lock_guard lock(display_mutex);
+	return !dirty_tiles.empty();
+}
+
+std::vector<Tile> ProgressiveRenderer::takeUpdates(std::span<uint8_t> rgba)
+{
+	std::lock_guard lock(display_mutex);
+
+	const auto row_bytes = static_cast<size_t>(image_width) * 4;
+	std::vector<Tile> updated;
+	updated.reserve(dirty_tiles.size());
+	for (const auto index : dirty_tiles) {
+		const auto& tile = tiles[index];
+		for (int j = tile.y0; j < tile.y1; ++j) {
+			const auto offset = j * row_bytes + static_cast<size_t>(tile.x0) * 4;
+			std::copy_n(display.begin() + offset, tile.width() * 4, rgba.begin() + offset);
+		}
+		tile_dirty[index] = 0;
+		updated.push_back(tile);
+	}
+	dirty_tiles.clear();
+	return updated;
+}
+
+void ProgressiveRenderer::applyCamera()
+{
+	std::lock_guard lock(camera_mutex);
+	camera = std::move(*pending_camera);
+	pending_camera.reset();
+	camera_changed.store(false, std::memory_order_release);
+
+	// The display keeps the old view until the previews of the new one replace it.
+	target_passes.store(camera.samples_per_pixel, std::memory_order_release);
+	passes.store(0, std::memory_order_release);
+	std::fill(tile_samples.begin(), tile_samples.end(), 0);
+	std::fill(accumulation.begin(), accumulation.end(), 0.0f);
+	feature_sums.resize(image_width, image_height);
+	first_pass_seconds.store(0.0, std::memory_order_release);
+	start_time = std::chrono::steady_clock::now();
+	preview_done = false;
+}
+
+void ProgressiveRenderer::renderLoop()
+{
+	TileScheduler scheduler(camera.thread_count);
+
+	std::vector<std::unique_ptr<Sampler>> samplers;
+	auto createSamplers = [&] {
+		const auto prototype = camera.createSampler();
+		samplers.clear();
+		for (int i = 0; i < scheduler.threadCount(); ++i)
+			samplers.push_back(prototype->clone());
+	};
+	createSamplers();
+
+	std::vector<uint64_t> worker_rays(scheduler.threadCount());
+	std::vector<RenderStats> worker_stats(scheduler.threadCount());
+	// Runs fn on every tile that should be rendered, skipping the rest once the pass is cancelled.
+	auto runPass = [&](auto&& fn) {
+		const auto pass_start = std::chrono::steady_clock::now();
+		std::fill(worker_rays.begin(), worker_rays.end(), 0);
+		std::fill(worker_stats.begin(), worker_stats.end(), RenderStats());
+		scheduler.run(tiles, [&](const Tile& tile, int worker) {
+			if (cancelled())
+				return;
+			collectRenderStats(worker_stats[worker], [&] {
+				worker_rays[worker] += fn(tile, *samplers[worker]);
+			});
+		});
+
+		// A cancelled pass still counts, its finished tiles are kept.
+		const std::chrono::duration<double> pass_seconds = std::chrono::steady_clock::now() - pass_start;
+		render_seconds.store(renderSeconds() + pass_seconds.count(), std::memory_order_release);
+		uint64_t pass_rays = 0;
+		for (auto n : worker_rays)
+			pass_rays += n;
+		rays_traced.fetch_add(pass_rays, std::memory_order_acq_rel);
+		if constexpr (render_stats_enabled) {
+			std::lock_guard lock(stats_mutex);
+			for (const auto& s : worker_stats)
+				stats.merge(s);
+		}
+	};
+
+	while (true) {
+		if (camera_changed.load(std::memory_order_acquire)) {
+			applyCamera();
+			createSamplers();
+		}
+		if (stop_requested.load(std::memory_order_acquire))
+			break;
+
+		if (!preview_done) {
+			for (const int block : preview_blocks) {
+				runPass([&](const Tile& tile, Sampler& sampler) { return renderTilePreview(tile, block, sampler); });
+				if (cancelled())
+					break;
+			}
+			preview_done = !cancelled();
+			continue;
+		}
+
+		const int pass = completedPasses();
+		if (pass >= targetPasses()) {
+			if (display_changed.load(std::memory_order_acquire)) {
+				refreshDisplay(scheduler);
+				continue;
+			}
+			std::lock_guard lock(camera_mutex);
+			if (!camera_changed.load(std::memory_order_acquire) && !display_changed.load(std::memory_order_acquire)) {
+				running.store(false, std::memory_order_release);
+				return;
+			}
+			continue;
+		}
+
+		// Tiles that already got this pass before a stop() are skipped.
+		runPass([&](const Tile& tile, Sampler& sampler) -> uint64_t {
+			const auto index = static_cast<size_t>(&tile - tiles.data());
+			return tile_samples[index] > pass ? 0 : renderTilePass(tile, sampler);
+		});
+		if (cancelled())
+			continue;
+
+		passes.store(pass + 1, std::memory_order_release);
+		if (pass == 0) {
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+			first_pass_seconds.store(elapsed.count(), std::memory_order_release);
+		}
+		const bool denoise_now = denoiseEnabled() && (isPowerOfTwo(pass + 1) || pass + 1 == targetPasses());
+		if (denoise_now || display_changed.load(std::memory_order_acquire))
+			refreshDisplay(scheduler);
+	}
+
+	std::lock_guard lock(camera_mutex);
+	running.store(false, std::memory_order_release);
+}
+
+uint64_t ProgressiveRenderer::renderTilePass(const Tile& tile, Sampler& sampler)
+{
+	const auto index = static_cast<size_t>(&tile - tiles.data());
+	const int sample = tile_samples[index];
+	const int width = camera.image_width;
+
+	uint64_t rays = 0;
+	for (int j = tile.y0; j < tile.y1; ++j) {
+		for (int i = tile.x0; i < tile.x1; ++i) {
+			SurfaceFeatures features;
+			const auto color = camera.samplePixel(*scene, i, j, sample, sampler, rays, features);
+			feature_sums.add(i, j, features);
+			float* sum = &accumulation[3 * (static_cast<size_t>(j) * width + i)];
+			sum[0] += static_cast<float>(color.x());
+			sum[1] += static_cast<float>(color.y());
+			sum[2] += static_cast<float>(color.z());
+		}
+	}
+	tile_samples[index] = sample + 1;
+	// The denoised display is refreshed as a whole after the pass.
+	if (denoiseEnabled())
+		return rays;
+
+	std::lock_guard lock(display_mutex);
+	toneMapTile(accumulation, display, width, tile, display_settings, 1.0f / (sample + 1));
+	if (!tile_dirty[index]) {
+		tile_dirty[index] = 1;
+		dirty_tiles.push_back(static_cast<uint32_t>(index));
+	}
+	return rays;
+}
+
+uint64_t ProgressiveRenderer::renderTilePreview(const Tile& tile, int block, Sampler& sampler)
+{
+	// The first sample of each block's top-left pixel, the same one pass 0 traces there.
+	uint64_t rays = 0;
+	std::vector<Color> colors;
+	for (int j = tile.y0; j < tile.y1; j += block) {
+		for (int i = tile.x0; i < tile.x1; i += block)
+			colors.push_back(camera.samplePixel(*scene, i, j, 0, sampler, rays));
+	}
+
+	// Each row of blocks spread over the pixels of the tile's rows.
+	const int blocks_per_row = (tile.width() + block - 1) / block;
+	std::vector<float> row(static_cast<size_t>(tile.width()) * 3);
+	const auto index = static_cast<size_t>(&tile - tiles.data());
+	std::lock_guard lock(display_mutex);
+	for (int j = tile.y0; j < tile.y1; ++j) {
+		const Color* blocks = &colors[static_cast<size_t>((j - tile.y0) / block) * blocks_per_row];
+		for (int i = 0; i < tile.width(); ++i) {
+			for (int c = 0; c < 3; ++c)
+				row[3 * i + c] = static_cast<float>(blocks[i / block][c]);
+		}
+		toneMapRow(row.data(), &display[4 * (static_cast<size_t>(j) * image_width + tile.x0)], tile.width(), tile.x0, j,
+				   display_settings);
+	}
+	if (!tile_dirty[index]) {
+		tile_dirty[index] = 1;
+		dirty_tiles.push_back(static_cast<uint32_t>(index));
+	}
+	return rays;
+}
+
+void ProgressiveRenderer::refreshDisplay(TileScheduler& scheduler)
+{
+	{
+		std::lock_guard lock(camera_mutex);
+		display_settings = pending_display;
+		display_changed.store(false, std::memory_order_release);
+	}
+	const bool denoised = denoiseEnabled();
+	std::vector<float> rgb(accumulation.size());
+	FeatureBuffers features = feature_sums;
+	for (size_t index = 0; index < tiles.size(); ++index) {
+		const auto& tile = tiles[index];
+		const float inv_samples = 1.0f / std::max(tile_samples[index], 1);
+		for (int j = tile.y0; j < tile.y1; ++j) {
+			for (int i = tile.x0; i < tile.x1; ++i) {
+				const auto pixel = 3 * (static_cast<size_t>(j) * image_width + i);
+				for (int c = 0; c < 3; ++c) {
+					rgb[pixel + c] = accumulation[pixel + c] * inv_samples;
+					features.albedo[pixel + c] *= inv_samples;
+					features.normal[pixel + c] *= inv_samples;
+				}
+			}
+		}
+	}
+	if (denoised)
+		rgb = denoise(rgb, features, DenoiseSettings(), scheduler);
+
+	std::lock_guard lock(display_mutex);
+	toneMap(rgb, display, image_width, image_height, display_settings, scheduler);
+	for (size_t index = 0; index < tiles.size(); ++index) {
+		if (!tile_dirty[index]) {
+			tile_dirty[index] = 1;
+			dirty_tiles.push_back(static_cast<uint32_t>(index));
+		}
+	}
+}
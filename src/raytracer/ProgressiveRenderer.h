@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Camera.h"
+#include "Scene.h"
+#include "TileScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Renders on a background thread, one sample per pixel per pass, into a float accumulation
+// buffer. Each finished tile refreshes its part of an RGBA8 display image with the running
+// average and is queued as dirty, so a viewer only re-uploads what changed. Rendering stops
+// when camera.samples_per_pixel passes are done or stop() is called; start() resumes it.
+//
+// setCamera() restarts the image from a new view without waiting: the frame in flight is
+// abandoned at the next tile, and the new view first appears as coarse previews (one path per
+// 8x8, 4x4 and 2x2 pixel block) before the full-resolution passes refine it.
+//
+// The display is tone mapped from the accumulation with the camera's display settings, and
+// setDisplay() re-exposes it without losing samples. With setDenoise(true), finished tiles no
+// longer refresh the display. The whole display is replaced by the denoised image instead, after
+// passes 1, 2, 4, 8, ... and the last one.
+class ProgressiveRenderer {
+public:
+	ProgressiveRenderer(std::shared_ptr<const Scene> scene, const Camera& camera);
+	~ProgressiveRenderer();
+
+	ProgressiveRenderer(const ProgressiveRenderer&) = delete;
+	ProgressiveRenderer& operator=(const ProgressiveRenderer&) = delete;
+
+	void start();
+	// Blocks until the in-flight tiles are done; a partial pass is kept and resumed by start().
+	void stop();
+	// Starts over with camera, which must have the same image size; starts rendering if stopped.
+	// Returns right away, the render thread picks the camera up at its next tile.
+	void setCamera(const Camera& camera);
+	// Switches the display between the running average and its denoised version, refreshing it
+	// after the pass in flight; starts rendering if stopped, to do that.
+	void setDenoise(bool enabled);
+	[[nodiscard]] bool denoiseEnabled() const noexcept { return denoise_enabled.load(std::memory_order_acquire); }
+	// Tone maps the display anew with settings, keeping the samples; like setDenoise(), after the
+	// pass in flight.
+	void setDisplay(const DisplaySettings& settings);
+
+	[[nodiscard]] bool isRunning() const noexcept { return running.load(std::memory_order_acquire); }
+	[[nodiscard]] int completedPasses() const noexcept { return passes.load(std::memory_order_acquire); }
+	[[nodiscard]] int targetPasses() const noexcept { return target_passes.load(std::memory_order_acquire); }
+	// Seconds from the first start() or the last camera change until the first full pass was
+	// rendered, 0 before that.
+	[[nodiscard]] double timeToFirstPass() const noexcept { return first_pass_seconds.load(std::memory_order_acquire); }
+	// Seconds spent rendering so far, without the time spent stopped.
+	[[nodiscard]] double renderSeconds() const noexcept { return render_seconds.load(std::memory_order_acquire); }
+	// Rays intersected with the scene so far.
+	[[nodiscard]] uint64_t raysTraced() const noexcept { return rays_traced.load(std::memory_order_acquire); }
+	// Counters of everything rendered so far, updated after every pass (and on stop()). All zero
+	// unless built with PHOTON_ENABLE_STATS.
+	[[nodiscard]] RenderStats renderStats() const;
+
+	[[nodiscard]] int width() const noexcept { return image_width; }
+	[[nodiscard]] int height() const noexcept { return image_height; }
+
+	// Whether takeUpdates() has anything to copy.
+	[[nodiscard]] bool hasUpdates();
+	// Copies the display pixels of every tile changed since the last call into rgba
+	// (width * height * 4 bytes) and returns those tiles.
+	std::vector<Tile> takeUpdates(std::span<uint8_t> rgba);
+
+private:
+	// Starts the render thread, joining a finished one first.
+	void launch();
+	void renderLoop();
+	// Switches to the pending camera and clears the image; called by the render thread.
+	void applyCamera();
+	[[nodiscard]] bool cancelled() const noexcept {
+		return stop_requested.load(std::memory_order_relaxed) || camera_changed.load(std::memory_order_relaxed);
+	}
+	// Returns the number of rays traced.
+	uint64_t renderTilePass(const Tile& tile, Sampler& sampler);
+	// Traces one path per block x block pixels of the tile into the display only.
+	uint64_t renderTilePreview(const Tile& tile, int block, Sampler& sampler);
+	// Rewrites the whole display from the accumulation with the pending display settings,
+	// denoised if that is enabled.
+	void refreshDisplay(TileScheduler& scheduler);
+
+	std::shared_ptr<const Scene> scene;
+	Camera camera;					// Owned by the render thread while it runs
+	const int image_width;
+	const int image_height;
+	std::atomic<int> target_passes;
+
+	std::mutex camera_mutex;
+	std::optional<Camera> pending_camera;
+	std::atomic<bool> camera_changed{false};
+	bool preview_done = false;		// Coarse previews of the current camera were shown
+
+	std::vector<Tile> tiles;
+	std::vector<int> tile_samples;	// Samples per pixel already in each tile, may run one ahead after stop()
+
+	std::vector<float> accumulation;	// Linear RGB sums, 3 floats per pixel
+	FeatureBuffers feature_sums;		// Sums of the samples' features, for the denoiser
+
+	std::atomic<bool> denoise_enabled{false};
+	std::atomic<bool> display_changed{false};	// Denoising or display settings changed since the last refresh
+	DisplaySettings pending_display;	// Guarded by camera_mutex
+	DisplaySettings display_settings;	// Owned by the render thread
+
+	mutable std::mutex stats_mutex;
+	RenderStats stats;
+
+	std::mutex display_mutex;
+	std::vector<uint8_t> display;		// Tone-mapped running average
+	std::vector<uint32_t> dirty_tiles;	// Indices of the tiles changed since the last takeUpdates()
+	std::vector<uint8_t> tile_dirty;	// Whether each tile is in dirty_tiles
+
+	std::atomic<int> passes{0};
+	std::atomic<bool> running{false};
+	std::atomic<bool> stop_requested{false};
+	std::atomic<double> first_pass_seconds{0.0};
+	std::atomic<double> render_seconds{0.0};
+	std::atomic<uint64_t> rays_traced{0};
+	std::chrono::steady_clock::time_point start_time;	// Of the first start() or the last camera change
+	std::thread thread;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+// 64-bit finalizer from SplitMix64. Turns structured input such as (pixel, sample) into well
+// distributed seeds.
+[[nodiscard]] inline constexpr uint64_t mix_bits(uint64_t v) noexcept {
+	v ^= v >> 30;
+	v *= 0xBF58476D1CE4E5B9ull;
+	v ^= v >> 27;
+	v *= 0x94D049BB133111EBull;
+	v ^= v >> 31;
+	return v;
+}
+
+// PCG32 (XSH RR variant, O'Neill 2014): 16 bytes of state, one multiply-add per draw.
+// The stream selects one of 2^63 independent sequences for the same seed.
+class Pcg32 {
+public:
+	constexpr Pcg32() noexcept = default;
+	constexpr Pcg32(uint64_t seed_state, uint64_t stream = default_stream) noexcept {
+		seed(seed_state, stream);
+	}
+
+	constexpr void seed(uint64_t seed_state, uint64_t stream = default_stream) noexcept {
+		state = 0;
+		inc = (stream << 1) | 1u;
+		nextUint();
+		state += seed_state;
+		nextUint();
+	}
+
+	constexpr uint32_t nextUint() noexcept {
+		const uint64_t old = state;
+		state = old * multiplier + inc;
+		const auto xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+		const auto rot = static_cast<uint32_t>(old >> 59);
+		return (xorshifted >> rot) | (xorshifted << ((~rot + 1) & 31));
+	}
+
+	// Uniform in [0,1) with 32 bits of resolution.
+	constexpr double nextDouble() noexcept {
+		return nextUint() * 0x1p-32;
+	}
+
+private:
+	static constexpr uint64_t multiplier = 0x5851F42D4C957F2Dull;
+	static constexpr uint64_t default_stream = 0xDA3E39CB94B95BDBull;
+
+	uint64_t state = 0x853C49E6748FEA9Bull;
+	uint64_t inc = 0xDA3E39CB94B95BDBull;
+};
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "vec3.h"
+#include "Vec3.h"
 
 class Ray {
 public:
@@ -12,7 +12,7 @@ public:
 	[[nodiscard]] constexpr const Point3& origin() const noexcept { return orig; }
 	[[nodiscard]] constexpr const Vec3& direction() const noexcept { return dir; }
 
-	[[nodiscard]] constexpr Point3 at(double t) const noexcept { 
+	[[nodiscard]] constexpr Point3 at(real t) const noexcept { 
 		return orig + t * dir; 
 	}
 
@@ -0,0 +1,158 @@
+#include "Raytracer.h"
+#include "BVH.h"
+#include "Instance.h"
+#include "PackedSpheres.h"
+#include "Sphere.h"
+#include "TriangleMesh.h"
+#include "Materials/AllMaterials.h"
+
+std::shared_ptr<Scene> makeDemoScene() {
+	auto scene = std::make_shared<Scene>();
+	auto world = std::make_shared<PackedSpheres>();
+
+	// Make the above work for my code
+	auto material_ground = scene->materials.add(Lambertian(Color(0.8, 0.8, 0.0)));
+	auto material_center = scene->materials.add(Lambertian(Color(0.1, 0.2, 0.5)));
+	auto material_left = scene->materials.add(Dielectric(1.50));
+	auto material_bubble = scene->materials.add(Dielectric(1.00 / 1.50));
+	auto material_right = scene->materials.add(Metal(Color(0.8, 0.6, 0.2), 1.0));
+
+	world->add(Point3(0.0, -100.5, -1.0), 100.0, material_ground);
+	world->add(Point3(0.0, 0.0, -1.2), 0.5, material_center);
+	world->add(Point3(-1.0, 0.0, -1.0), 0.5, material_left);
+	world->add(Point3(-1.0, 0.0, -1.0), 0.4, material_bubble);
+	world->add(Point3(1.0, 0.0, -1.0), 0.5, material_right);
+
+	scene->world = world;
+	return scene;
+}
+
+Camera makeDemoCamera(int width) {
+	return Camera(width, 16.0 / 9.0, 10, 10, 20.0, Point3(-2, 2, 1), Point3(0, 0, -1), Vec3(0, 1, 0), 10.0, 3.4);
+}
+
+std::shared_ptr<Scene> makeCoverScene(uint32_t seed) {
+	auto scene = std::make_shared<Scene>();
+	HittableList spheres;
+
+	seed_random(0, 0, 0, seed);
+	spheres.add(std::make_shared<Sphere>(Point3(0, -1000, 0), 1000, scene->materials.add(Lambertian(Color(0.5, 0.5, 0.5)))));
+
+	for (int a = -11; a < 11; a++) {
+		for (int b = -11; b < 11; b++) {
+			const auto choose_mat = random_double();
+			const Point3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+			if ((center - Point3(4, 0.2, 0)).length() <= 0.9)
+				continue;
+
+			uint32_t material;
+			if (choose_mat < 0.8)
+				material = scene->materials.add(Lambertian(Color::random() * Color::random()));
+			else if (choose_mat < 0.95)
+				material = scene->materials.add(Metal(Color::random(0.5, 1), random_double(0, 0.5)));
+			else
+				material = scene->materials.add(Dielectric(1.5));
+			spheres.add(std::make_shared<Sphere>(center, 0.2, material));
+		}
+	}
+
+	spheres.add(std::make_shared<Sphere>(Point3(0, 1, 0), 1.0, scene->materials.add(Dielectric(1.5))));
+	spheres.add(std::make_shared<Sphere>(Point3(-4, 1, 0), 1.0, scene->materials.add(Lambertian(Color(0.4, 0.2, 0.1)))));
+	spheres.add(std::make_shared<Sphere>(Point3(4, 1, 0), 1.0, scene->materials.add(Metal(Color(0.7, 0.6, 0.5), 0.0))));
+
+	scene->world = std::make_shared<BVH>(spheres);
+	return scene;
+}
+
+Camera makeCoverCamera(int width) {
+	return Camera(width, 16.0 / 9.0, 10, 50, 20.0, Point3(13, 2, 3), Point3(0, 0, 0), Vec3(0, 1, 0), 0.6, 10.0);
+}
+
+std::shared_ptr<Scene> makeInstanceScene(uint32_t count, uint32_t seed) {
+	auto scene = std::make_shared<Scene>();
+
+	// Each prototype is one mesh with its own BVH; a copy of it costs one matrix and an index.
+	const std::vector<std::shared_ptr<const Hittable>> prototypes = {
+		std::make_shared<TriangleMesh>(makeIcosphere(3), scene->materials.add(Lambertian(Color(0.7, 0.3, 0.2)))),
+		std::make_shared<TriangleMesh>(makeIcosphere(2), scene->materials.add(Metal(Color(0.8, 0.8, 0.9), 0.05))),
+		std::make_shared<TriangleMesh>(makeIcosphere(1), scene->materials.add(Lambertian(Color(0.2, 0.5, 0.3)))),
+	};
+
+	// Spread over a square that keeps the density constant however many copies there are.
+	seed_random(0, 0, 0, seed);
+	const double half_extent = 1.5 * std::sqrt(static_cast<double>(count));
+	std::vector<InstanceBVH::Placement> placements;
+	placements.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		const auto prototype = static_cast<uint32_t>(random_double() * prototypes.size());
+		const auto size = random_double(0.2, 0.5);
+		const Vec3 scale(size * random_double(0.8, 1.6), size * random_double(0.4, 1.2), size * random_double(0.8, 1.6));
+		const Vec3 offset(random_double(-half_extent, half_extent), scale.y(), random_double(-half_extent, half_extent));
+		placements.push_back(InstanceBVH::Placement{ prototype,
+			Transform::translate(offset) * Transform::rotate(Vec3(0, 1, 0), random_double(0, 360)) * Transform::scale(scale) });
+	}
+
+	auto world = std::make_shared<HittableList>();
+	world->add(std::make_shared<Sphere>(Point3(0, -100000, 0), 100000, scene->materials.add(Lambertian(Color(0.5, 0.5, 0.5)))));
+	world->add(std::make_shared<InstanceBVH>(prototypes, placements));
+	scene->world = world;
+	return scene;
+}
+
+Camera makeInstanceCamera(int width) {
+	return Camera(width, 16.0 / 9.0, 10, 10, 40.0, Point3(0, 6, 14), Point3(0, 0, 0), Vec3(0, 1, 0), 0.0, 10.0);
+}
+
+std::shared_ptr<Scene> makeLightsScene(uint32_t count, uint32_t seed) {
+	auto scene = std::make_shared<Scene>();
+	scene->sky = false;
+	HittableList objects;
+
+	objects.add(std::make_shared<Sphere>(Point3(0, -1000, 0), 1000, scene->materials.add(Lambertian(Color(0.5, 0.5, 0.5)))));
+	objects.add(std::make_shared<Sphere>(Point3(-2.2, 1, 0), 1.0, scene->materials.add(Lambertian(Color(0.6, 0.3, 0.2)))));
+	objects.add(std::make_shared<Sphere>(Point3(0, 1, 0), 1.0, scene->materials.add(Metal(Color(0.8, 0.8, 0.8), 0.5))));
+	objects.add(std::make_shared<Sphere>(Point3(2.2, 1, 0), 1.0, scene->materials.add(Dielectric(1.5))));
+
+	// Two triangles facing down.
+	MeshBuffers panel;
+	panel.positions = { Point3(-3, 5, -3), Point3(3, 5, -3), Point3(3, 5, 3), Point3(-3, 5, 3) };
+	panel.indices = { 0, 1, 2, 0, 2, 3 };
+	const auto panel_material = scene->materials.add(DiffuseLight(Color(0.2, 0.2, 0.25)));
+	scene->lights.addMesh(panel, panel_material);
+	objects.add(std::make_shared<TriangleMesh>(std::move(panel), panel_material));
+
+	// A few shared colors, each as bright as the total power over the light count asks for.
+	constexpr real light_radius = 0.05;
+	constexpr real total_power = 40;
+	const real radiance = total_power / (std::max(count, 1u) * 4 * pi * light_radius * light_radius);
+	const Color hues[] = { Color(1.0, 0.5, 0.3), Color(0.4, 1.0, 0.5), Color(0.4, 0.6, 1.0), Color(1.0, 0.9, 0.7) };
+	std::vector<uint32_t> colors;
+	for (const auto& hue : hues)
+		colors.push_back(scene->materials.add(DiffuseLight(hue * radiance)));
+
+	seed_random(0, 0, 0, seed);
+	for (uint32_t placed = 0; placed < count;) {
+		const Point3 center(random_double(-6, 6), random_double(0.1, 3), random_double(-6, 3));
+		const auto material = colors[static_cast<size_t>(random_double() * colors.size())];
+		// Not inside the large spheres.
+		if (std::fabs(center.x()) < 3.4 && std::fabs(center.z()) < 1.2 && center.y() < 2.2)
+			continue;
+		scene->lights.addSphere(center, light_radius, material);
+		objects.add(std::make_shared<Sphere>(center, light_radius, material));
+		++placed;
+	}
+
+	scene->lights.build(scene->materials);
+	scene->world = std::make_shared<BVH>(objects);
+	return scene;
+}
+
+Camera makeLightsCamera(int width) {
+	return Camera(width, 16.0 / 9.0, 16, 10, 35.0, Point3(0, 2.5, 9), Point3(0, 0.8, 0), Vec3(0, 1, 0), 0.0, 10.0);
+}
+
+[[nodiscard]] std::vector<uint8_t> raytrace(int width, int height) {
+	auto scene = makeDemoScene();
+	auto cam = makeDemoCamera(width);
+	return cam.render(*scene);
+}
\ No newline at end of file
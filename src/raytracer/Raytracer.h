@@ -1,3 +1,27 @@
 #pragma once
 
+#include "Camera.h"
+#include "Scene.h"
+
+#include <memory>
+#include <vector>
+
+// The demo scene: ground, a diffuse, a hollow glass and a metal sphere.
+[[nodiscard]] std::shared_ptr<Scene> makeDemoScene();
+[[nodiscard]] Camera makeDemoCamera(int width);
+
+// The cover of "Ray Tracing in One Weekend": about 480 random small spheres around three large ones.
+[[nodiscard]] std::shared_ptr<Scene> makeCoverScene(uint32_t seed = 0);
+[[nodiscard]] Camera makeCoverCamera(int width);
+
+// A field of count randomly rotated and scaled copies of a few shared meshes, instanced through
+// one top-level BVH.
+[[nodiscard]] std::shared_ptr<Scene> makeInstanceScene(uint32_t count, uint32_t seed = 0);
+[[nodiscard]] Camera makeInstanceCamera(int width);
+
+// Three large spheres under a night sky, lit by a dim panel overhead and count small colored
+// lights whose total power stays the same however many there are.
+[[nodiscard]] std::shared_ptr<Scene> makeLightsScene(uint32_t count, uint32_t seed = 0);
+[[nodiscard]] Camera makeLightsCamera(int width);
+
 [[nodiscard]] std::vector<uint8_t> raytrace(int width, int height);
\ No newline at end of file
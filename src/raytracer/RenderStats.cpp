@@ -0,0 +1,63 @@
+#include "RenderStats.h"
+#include "Materials/MaterialTable.h"
+
+#include <cstdio>
+
+void RenderStats::merge(const RenderStats& other) noexcept
+{
+	camera_rays += other.camera_rays;
+	bounce_rays += other.bounce_rays;
+	shadow_rays += other.shadow_rays;
+	hit_calls += other.hit_calls;
+	primitive_tests += other.primitive_tests;
+	escaped_paths += other.escaped_paths;
+	absorbed_paths += other.absorbed_paths;
+	roulette_paths += other.roulette_paths;
+	truncated_paths += other.truncated_paths;
+	for (size_t i = 0; i < scatter_events.size(); ++i)
+		scatter_events[i] += other.scatter_events[i];
+	for (size_t i = 0; i < path_depths.size(); ++i)
+		path_depths[i] += other.path_depths[i];
+}
+
+std::string RenderStats::toJson(double seconds) const
+{
+	std::string json = "{\n";
+	auto field = [&](const char* name, uint64_t value) {
+		json += "  \"" + std::string(name) + "\": " + std::to_string(value) + ",\n";
+	};
+
+	json += std::string("  \"enabled\": ") + (render_stats_enabled ? "true" : "false") + ",\n";
+	if (seconds > 0.0) {
+		char rates[160];
+		std::snprintf(rates, sizeof(rates), "  \"seconds\": %.6f,\n  \"rays_per_second\": %.1f,\n",
+					  seconds, rays() / seconds);
+		json += rates;
+	}
+	field("camera_rays", camera_rays);
+	field("bounce_rays", bounce_rays);
+	field("shadow_rays", shadow_rays);
+	field("rays", rays());
+	field("hit_calls", hit_calls);
+	field("primitive_tests", primitive_tests);
+	field("paths", paths());
+	field("escaped_paths", escaped_paths);
+	field("absorbed_paths", absorbed_paths);
+	field("roulette_paths", roulette_paths);
+	field("truncated_paths", truncated_paths);
+
+	json += "  \"scatter_events\": {";
+	for (size_t i = 0; i < material_type_names.size(); ++i)
+		json += std::string(i == 0 ? " " : ", ") + "\"" + material_type_names[i] + "\": " + std::to_string(scatter_events[i]);
+	json += " },\n";
+
+	// Trailing empty bins are left out; index i counts the paths that hit i surfaces.
+	size_t used_bins = path_depths.size();
+	while (used_bins > 0 && path_depths[used_bins - 1] == 0)
+		--used_bins;
+	json += "  \"path_depths\": [";
+	for (size_t i = 0; i < used_bins; ++i)
+		json += (i == 0 ? "" : ", ") + std::to_string(path_depths[i]);
+	json += "]\n}\n";
+	return json;
+}
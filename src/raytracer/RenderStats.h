@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Counters of what a render did: rays, intersection work, how paths scattered and ended. The hot
+// paths bump a thread-local copy through PHOTON_STAT, which is free of atomics and shared cache
+// lines; the render loops fold each thread's counts into a per-worker total after every tile and
+// merge those once the pass is done. Unless the build defines PHOTON_ENABLE_STATS the macro expands
+// to nothing and the renderers skip the merging, so the counters cost nothing.
+struct RenderStats {
+	// Bins of the path length histogram, the last one collects every longer path.
+	static constexpr size_t depth_bins = 64;
+	// Upper bound on the material types, indexed like the Material variant.
+	static constexpr size_t max_material_types = 8;
+
+	uint64_t camera_rays = 0;
+	uint64_t bounce_rays = 0;		// Scattered rays that went on to be traced
+	uint64_t shadow_rays = 0;		// Towards points sampled on lights
+	uint64_t hit_calls = 0;			// Hittable::hit calls, aggregates included
+	uint64_t primitive_tests = 0;	// Ray-primitive intersection tests
+	uint64_t escaped_paths = 0;		// Paths that left the scene
+	uint64_t absorbed_paths = 0;	// Paths a material did not scatter
+	uint64_t roulette_paths = 0;	// Paths ended by Russian roulette
+	uint64_t truncated_paths = 0;	// Paths cut off at max_depth
+	std::array<uint64_t, max_material_types> scatter_events{};
+	std::array<uint64_t, depth_bins> path_depths{};	// Paths by the number of surfaces they hit
+
+	[[nodiscard]] uint64_t rays() const noexcept { return camera_rays + bounce_rays + shadow_rays; }
+	[[nodiscard]] uint64_t paths() const noexcept { return escaped_paths + absorbed_paths + roulette_paths + truncated_paths; }
+
+	void recordPathEnd(int depth, uint64_t count = 1) noexcept {
+		path_depths[std::min(static_cast<size_t>(depth), depth_bins - 1)] += count;
+	}
+
+	void merge(const RenderStats& other) noexcept;
+
+	// The counters as a JSON object; `seconds` > 0 adds the render time and rates.
+	[[nodiscard]] std::string toJson(double seconds = 0.0) const;
+};
+
+#ifdef PHOTON_ENABLE_STATS
+inline constexpr bool render_stats_enabled = true;
+#else
+inline constexpr bool render_stats_enabled = false;
+#endif
+
+// The calling thread's counters.
+[[nodiscard]] inline RenderStats& threadRenderStats() noexcept
+{
+	thread_local RenderStats stats;
+	return stats;
+}
+
+// Returns the calling thread's counters and resets them.
+[[nodiscard]] inline RenderStats takeThreadRenderStats() noexcept
+{
+	RenderStats taken = threadRenderStats();
+	threadRenderStats() = RenderStats();
+	return taken;
+}
+
+// Runs work() and merges the counters it adds on the calling thread into `total`.
+template <typename Work>
+void collectRenderStats(RenderStats& total, Work&& work)
+{
+	if constexpr (render_stats_enabled) {
+		threadRenderStats() = RenderStats();
+		work();
+		total.merge(takeThreadRenderStats());
+	}
+	else {
+		work();
+	}
+}
+
+#ifdef PHOTON_ENABLE_STATS
+// Applies `member` to the calling thread's counters, e.g. PHOTON_STAT(hit_calls++).
+#define PHOTON_STAT(member) (threadRenderStats().member)
+#else
+#define PHOTON_STAT(member) ((void)0)
+#endif
@@ -0,0 +1,229 @@
+#include "Sampler.h"
+
+#include <array>
+#include <cmath>
+
+namespace {
+
+[[nodiscard]] constexpr uint32_t reverseBits(uint32_t v) noexcept {
+	v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+	v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+	v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+	v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+	return (v >> 16) | (v << 16);
+}
+
+[[nodiscard]] constexpr double toUnit(uint32_t v) noexcept {
+	return v * 0x1p-32;
+}
+
+// Element i of a pseudo-random permutation of [0, l) selected by p (Kensler, "Correlated
+// Multi-Jittered Sampling", 2013). Cycle-walks a hash on the next power of two.
+[[nodiscard]] constexpr uint32_t permutationElement(uint32_t i, uint32_t l, uint32_t p) noexcept {
+	uint32_t w = l - 1;
+	w |= w >> 1;
+	w |= w >> 2;
+	w |= w >> 4;
+	w |= w >> 8;
+	w |= w >> 16;
+	do {
+		i ^= p;
+		i *= 0xe170893d;
+		i ^= p >> 16;
+		i ^= (i & w) >> 4;
+		i ^= p >> 8;
+		i *= 0x0929eb3f;
+		i ^= p >> 23;
+		i ^= (i & w) >> 1;
+		i *= 1 | p >> 27;
+		i *= 0x6935fa69;
+		i ^= (i & w) >> 11;
+		i *= 0x74dcb303;
+		i ^= (i & w) >> 2;
+		i *= 0x9e501cc3;
+		i ^= (i & w) >> 2;
+		i *= 0xc860a3df;
+		i &= w;
+		i ^= i >> 5;
+	} while (i >= l);
+	return (i + p) % l;
+}
+
+// Owen scrambling as a hash on bit-reversed integers (Laine and Karras 2011, constants from Burley 2020).
+[[nodiscard]] constexpr uint32_t nestedUniformScramble(uint32_t x, uint32_t seed) noexcept {
+	x = reverseBits(x);
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return reverseBits(x);
+}
+
+// Second Sobol' dimension (primitive polynomial x + 1). Its generator matrix is applied a byte at
+// a time through four 256-entry tables, since the shuffled index uses all 32 bits.
+constexpr std::array<std::array<uint32_t, 256>, 4> sobol_1_tables = [] {
+	std::array<uint32_t, 32> columns{};
+	uint32_t m = 1;
+	for (int k = 0; k < 32; ++k) {
+		columns[k] = m << (31 - k);
+		m = (m << 1) ^ m;
+	}
+
+	std::array<std::array<uint32_t, 256>, 4> tables{};
+	for (int byte = 0; byte < 4; ++byte) {
+		for (uint32_t value = 0; value < 256; ++value) {
+			uint32_t v = 0;
+			for (int bit = 0; bit < 8; ++bit) {
+				if (value & (1u << bit))
+					v ^= columns[8 * byte + bit];
+			}
+			tables[byte][value] = v;
+		}
+	}
+	return tables;
+}();
+
+[[nodiscard]] constexpr uint32_t sobolDimension0(uint32_t index) noexcept {
+	return reverseBits(index);
+}
+
+[[nodiscard]] constexpr uint32_t sobolDimension1(uint32_t index) noexcept {
+	return sobol_1_tables[0][index & 0xFF] ^ sobol_1_tables[1][(index >> 8) & 0xFF]
+		^ sobol_1_tables[2][(index >> 16) & 0xFF] ^ sobol_1_tables[3][index >> 24];
+}
+
+[[nodiscard]] inline uint64_t dimensionHash(uint64_t pixel_hash, int dimension) noexcept {
+	return mix_bits(pixel_hash ^ (uint64_t(uint32_t(dimension)) * 0x9E3779B97F4A7C15ull));
+}
+
+}
+
+// IndependentSampler
+
+void IndependentSampler::startPixelSample(int x, int y, int index, int dim) noexcept
+{
+	pixel_hash = pixelHash(x, y);
+	sample_index = index;
+	dimension = dim;
+	rng.seed(pixel_hash, mix_bits((uint64_t(uint32_t(index)) << 32) | uint32_t(dim)));
+}
+
+double IndependentSampler::get1D() noexcept
+{
+	++dimension;
+	return rng.nextDouble();
+}
+
+Point2 IndependentSampler::get2D() noexcept
+{
+	dimension += 2;
+	const auto u = rng.nextDouble();
+	return Point2{ u, rng.nextDouble() };
+}
+
+std::unique_ptr<Sampler> IndependentSampler::clone() const
+{
+	return std::make_unique<IndependentSampler>(*this);
+}
+
+// StratifiedSampler
+
+StratifiedSampler::StratifiedSampler(int samples_per_pixel, uint64_t seed) noexcept
+	: Sampler(samples_per_pixel, seed)
+	, strata_per_axis(static_cast<int>(std::ceil(std::sqrt(static_cast<double>(this->samples_per_pixel)))))
+{
+}
+
+void StratifiedSampler::startPixelSample(int x, int y, int index, int dim) noexcept
+{
+	pixel_hash = pixelHash(x, y);
+	sample_index = index;
+	dimension = dim;
+	rng.seed(pixel_hash, mix_bits((uint64_t(uint32_t(index)) << 32) | uint32_t(dim)));
+}
+
+double StratifiedSampler::get1D() noexcept
+{
+	// Samples past samples_per_pixel start a new, independently shuffled round of strata.
+	const auto strata = static_cast<uint32_t>(samples_per_pixel);
+	const auto round = static_cast<uint32_t>(sample_index) / strata;
+	const auto hash = static_cast<uint32_t>(dimensionHash(pixel_hash, dimension) + round);
+	const auto stratum = permutationElement(static_cast<uint32_t>(sample_index) % strata, strata, hash);
+	++dimension;
+	return (stratum + rng.nextDouble()) / strata;
+}
+
+Point2 StratifiedSampler::get2D() noexcept
+{
+	const auto n = static_cast<uint32_t>(strata_per_axis);
+	const auto strata = n * n;
+	const auto round = static_cast<uint32_t>(sample_index) / strata;
+	const auto hash = static_cast<uint32_t>(dimensionHash(pixel_hash, dimension) + round);
+	const auto stratum = permutationElement(static_cast<uint32_t>(sample_index) % strata, strata, hash);
+	dimension += 2;
+	const auto jx = rng.nextDouble();
+	const auto jy = rng.nextDouble();
+	return Point2{ (stratum % n + jx) / n, (stratum / n + jy) / n };
+}
+
+std::unique_ptr<Sampler> StratifiedSampler::clone() const
+{
+	return std::make_unique<StratifiedSampler>(*this);
+}
+
+// SobolSampler
+
+void SobolSampler::startPixelSample(int x, int y, int index, int dim) noexcept
+{
+	pixel_hash = pixelHash(x, y);
+	sample_index = index;
+	dimension = dim;
+}
+
+double SobolSampler::get1D() noexcept
+{
+	const auto hash = dimensionHash(pixel_hash, dimension++);
+	const auto index = nestedUniformScramble(static_cast<uint32_t>(sample_index), static_cast<uint32_t>(hash));
+	return toUnit(nestedUniformScramble(sobolDimension0(index), static_cast<uint32_t>(hash >> 32)));
+}
+
+Point2 SobolSampler::get2D() noexcept
+{
+	const auto hash = dimensionHash(pixel_hash, dimension);
+	dimension += 2;
+	const auto index = nestedUniformScramble(static_cast<uint32_t>(sample_index), static_cast<uint32_t>(hash));
+	const auto scramble = mix_bits(hash);
+	return Point2{
+		toUnit(nestedUniformScramble(sobolDimension0(index), static_cast<uint32_t>(hash >> 32))),
+		toUnit(nestedUniformScramble(sobolDimension1(index), static_cast<uint32_t>(scramble))),
+	};
+}
+
+std::unique_ptr<Sampler> SobolSampler::clone() const
+{
+	return std::make_unique<SobolSampler>(*this);
+}
+
+std::unique_ptr<Sampler> makeSampler(SamplerType type, int samples_per_pixel, uint64_t seed)
+{
+	switch (type) {
+	case SamplerType::Independent:
+		return std::make_unique<IndependentSampler>(samples_per_pixel, seed);
+	case SamplerType::Stratified:
+		return std::make_unique<StratifiedSampler>(samples_per_pixel, seed);
+	case SamplerType::Sobol:
+		break;
+	}
+	return std::make_unique<SobolSampler>(samples_per_pixel, seed);
+}
+
+const char* samplerName(SamplerType type) noexcept
+{
+	switch (type) {
+	case SamplerType::Independent: return "independent";
+	case SamplerType::Stratified: return "stratified";
+	case SamplerType::Sobol: return "sobol";
+	}
+	return "unknown";
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Random.h"
+
+#include <memory>
+
+struct Point2 {
+	double x{0.0};
+	double y{0.0};
+};
+
+// Hands out the sample values of one camera sample, one dimension at a time. Call
+// startPixelSample() before each sample; get1D()/get2D() then walk through the dimensions in
+// the fixed order the integrator consumes them (pixel position, lens, then per bounce).
+// A sampler is stateful, so every render thread uses its own clone.
+class Sampler {
+public:
+	virtual ~Sampler() = default;
+
+	// `dimension` lets a caller resume a sample part-way through its dimensions.
+	virtual void startPixelSample(int x, int y, int sample_index, int dimension = 0) noexcept = 0;
+
+	[[nodiscard]] virtual double get1D() noexcept = 0;
+	[[nodiscard]] virtual Point2 get2D() noexcept = 0;
+
+	[[nodiscard]] virtual std::unique_ptr<Sampler> clone() const = 0;
+
+	[[nodiscard]] int samplesPerPixel() const noexcept { return samples_per_pixel; }
+	// Next dimension get1D()/get2D() will consume.
+	[[nodiscard]] int currentDimension() const noexcept { return dimension; }
+
+protected:
+	Sampler(int samples_per_pixel, uint64_t seed) noexcept
+		: samples_per_pixel(samples_per_pixel < 1 ? 1 : samples_per_pixel), seed(seed) {}
+
+	// Hash of the current pixel and seed, recomputed by startPixelSample().
+	[[nodiscard]] uint64_t pixelHash(int x, int y) const noexcept {
+		return mix_bits(seed ^ mix_bits((uint64_t(uint32_t(y)) << 32) | uint32_t(x)));
+	}
+
+	int samples_per_pixel;
+	uint64_t seed;
+
+	uint64_t pixel_hash = 0;
+	int sample_index = 0;
+	int dimension = 0;
+};
+
+// Independent uniform random numbers, the baseline every other sampler is compared against.
+class IndependentSampler final : public Sampler {
+public:
+	IndependentSampler(int samples_per_pixel, uint64_t seed) noexcept : Sampler(samples_per_pixel, seed) {}
+
+	void startPixelSample(int x, int y, int sample_index, int dimension = 0) noexcept override;
+	[[nodiscard]] double get1D() noexcept override;
+	[[nodiscard]] Point2 get2D() noexcept override;
+	[[nodiscard]] std::unique_ptr<Sampler> clone() const override;
+
+private:
+	Pcg32 rng;
+};
+
+// Jittered stratification: every dimension of a pixel splits [0,1) (or [0,1)^2) into about
+// samples_per_pixel strata, each visited once in a per-pixel, per-dimension shuffled order.
+class StratifiedSampler final : public Sampler {
+public:
+	StratifiedSampler(int samples_per_pixel, uint64_t seed) noexcept;
+
+	void startPixelSample(int x, int y, int sample_index, int dimension = 0) noexcept override;
+	[[nodiscard]] double get1D() noexcept override;
+	[[nodiscard]] Point2 get2D() noexcept override;
+	[[nodiscard]] std::unique_ptr<Sampler> clone() const override;
+
+private:
+	int strata_per_axis;
+	Pcg32 rng;
+};
+
+// Owen-scrambled Sobol' points, padded per dimension: each 1D/2D request draws from the first
+// one or two Sobol' dimensions with an index shuffle and scramble seeded by (pixel, dimension),
+// following Burley, "Practical Hash-based Owen Scrambling" (JCGT 2020). Converges fastest when
+// samples_per_pixel is a power of two.
+class SobolSampler final : public Sampler {
+public:
+	SobolSampler(int samples_per_pixel, uint64_t seed) noexcept : Sampler(samples_per_pixel, seed) {}
+
+	void startPixelSample(int x, int y, int sample_index, int dimension = 0) noexcept override;
+	[[nodiscard]] double get1D() noexcept override;
+	[[nodiscard]] Point2 get2D() noexcept override;
+	[[nodiscard]] std::unique_ptr<Sampler> clone() const override;
+};
+
+enum class SamplerType {
+	Independent,
+	Stratified,
+	Sobol,
+};
+
+[[nodiscard]] std::unique_ptr<Sampler> makeSampler(SamplerType type, int samples_per_pixel, uint64_t seed);
+[[nodiscard]] const char* samplerName(SamplerType type) noexcept;
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Hittable.h"
+#include "Lights.h"
+#include "Materials/MaterialTable.h"
+
+#include <memory>
+
+// What a camera renders: the geometry, the material table its hit records index into and the
+// emitters among the geometry, built with LightList::build().
+struct Scene {
+	std::shared_ptr<Hittable> world;
+	MaterialTable materials;
+	LightList lights;
+	bool sky = true;	// Rays that leave the scene see Camera::skyColor(); false leaves them black
+};
@@ -0,0 +1,591 @@
+#include "SceneFile.h"
+#include "BVH.h"
+#include "MappedFile.h"
+#include "ObjLoader.h"
+#include "RenderStats.h"
+#include "Sphere.h"
+#include "TextParsing.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+
+// Binary image layout: a header, then each section at a multiple of section_alignment from the
+// start. Everything is stored in the native representation of the writing build; the header
+// records enough of it (byte order, size of real, size of a BVH node) to reject an image another
+// build cannot read in place.
+constexpr char image_magic[8] = { 'P', 'H', 'O', 'T', 'O', 'N', 'S', 'C' };
+constexpr uint32_t image_version = 3;
+constexpr uint32_t byte_order_tag = 0x01020304;
+constexpr size_t section_alignment = 64;
+
+enum Section { CenterX, CenterY, CenterZ, Radius, MaterialIndex, Nodes, Materials, Meshes, MeshPaths, SectionCount };
+
+// A mesh reference; the path is path_length chars at path_offset in the MeshPaths section.
+struct MeshRecord {
+	uint32_t material;
+	uint32_t path_length;
+	uint64_t path_offset;
+};
+
+struct ImageHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t real_size;
+	uint32_t node_size;
+	uint64_t sphere_count;
+	uint64_t node_count;
+	uint64_t material_count;
+	uint64_t mesh_count;
+	uint64_t mesh_path_bytes;
+	uint64_t offsets[SectionCount];	// Byte offset of each section from the start of the image
+	SceneCamera camera;
+	uint32_t sky;
+	uint32_t reserved;
+};
+
+static_assert(std::is_trivially_copyable_v<ImageHeader>);
+static_assert(std::is_trivially_copyable_v<SceneMaterial>);
+static_assert(std::is_trivially_copyable_v<BVHNode>);
+
+constexpr size_t alignSection(size_t offset) noexcept
+{
+	return (offset + section_alignment - 1) / section_alignment * section_alignment;
+}
+
+// Byte size of every section for the counts in the header.
+void sectionSizes(const ImageHeader& header, uint64_t (&sizes)[SectionCount]) noexcept
+{
+	const uint64_t spheres = header.sphere_count;
+	sizes[CenterX] = sizes[CenterY] = sizes[CenterZ] = sizes[Radius] = spheres * sizeof(real);
+	sizes[MaterialIndex] = spheres * sizeof(uint32_t);
+	sizes[Nodes] = header.node_count * sizeof(BVHNode);
+	sizes[Materials] = header.material_count * sizeof(SceneMaterial);
+	sizes[Meshes] = header.mesh_count * sizeof(MeshRecord);
+	sizes[MeshPaths] = header.mesh_path_bytes;
+}
+
+template <typename T>
+std::span<const T> section(std::span<const std::byte> image, const ImageHeader& header, Section s, uint64_t count) noexcept
+{
+	return { reinterpret_cast<const T*>(image.data() + header.offsets[s]), static_cast<size_t>(count) };
+}
+
+// Spheres read in place from a scene image: attribute arrays in leaf order and a flat BVH over them.
+class SceneSpheres : public Hittable {
+public:
+	SceneSpheres(std::span<const std::byte> image, const ImageHeader& header, std::shared_ptr<const void> storage) noexcept
+		: storage(std::move(storage))
+		, center_x(section<real>(image, header, CenterX, header.sphere_count))
+		, center_y(section<real>(image, header, CenterY, header.sphere_count))
+		, center_z(section<real>(image, header, CenterZ, header.sphere_count))
+		, radius(section<real>(image, header, Radius, header.sphere_count))
+		, materials(section<uint32_t>(image, header, MaterialIndex, header.sphere_count))
+		, nodes(section<BVHNode>(image, header, Nodes, header.node_count))
+	{
+	}
+
+	bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept override {
+		PHOTON_STAT(hit_calls++);
+		uint32_t nearest = 0;
+		real nearest_t = 0;
+		const bool found = traverseBVH(nodes, r, ray_t, [&](uint32_t slot, Interval& t) {
+			PHOTON_STAT(primitive_tests++);
+			real t_hit;
+			if (!Sphere::intersect(Point3(center_x[slot], center_y[slot], center_z[slot]), radius[slot], r, t, t_hit))
+				return false;
+			nearest = slot;
+			nearest_t = t_hit;
+			t.max = t_hit;
+			return true;
+		});
+		if (!found)
+			return false;
+
+		// Full attributes only for the winner.
+		const Point3 center(center_x[nearest], center_y[nearest], center_z[nearest]);
+		Sphere::fillHitRecord(center, radius[nearest], materials[nearest], r, nearest_t, rec);
+		return true;
+	}
+
+	[[nodiscard]] AABB boundingBox() const noexcept override {
+		return nodes.empty() ? AABB() : nodes.front().bounds;
+	}
+
+private:
+	std::shared_ptr<const void> storage;	// The mapped file or in-memory image the spans point into
+	std::span<const real> center_x, center_y, center_z, radius;
+	std::span<const uint32_t> materials;
+	std::span<const BVHNode> nodes;
+};
+
+// Checks that an image can be used in place: a compatible header, sections inside the image and
+// indices that cannot lead a traversal out of bounds. Linear in the size of the image.
+bool validateImage(std::span<const std::byte> image, std::string& error)
+{
+	if (image.size() < sizeof(ImageHeader) || std::memcmp(image.data(), image_magic, sizeof(image_magic)) != 0) {
+		error = "not a scene image";
+		return false;
+	}
+	ImageHeader header;
+	std::memcpy(&header, image.data(), sizeof(header));
+	if (header.version != image_version || header.byte_order != byte_order_tag
+		|| header.real_size != sizeof(real) || header.node_size != sizeof(BVHNode)) {
+		error = "scene image written by an incompatible build";
+		return false;
+	}
+
+	// Counts are bounded by the image size first, so the section sizes cannot overflow.
+	const auto& camera = header.camera;
+	if (camera.samples_per_pixel <= 0 || camera.max_depth <= 0 || !(camera.aspect_ratio > 0) || !(camera.focus_dist > 0)
+		|| header.sphere_count > image.size() || header.node_count > image.size() || header.material_count > image.size()
+		|| header.mesh_count > image.size() || header.mesh_path_bytes > image.size()) {
+		error = "corrupt scene image";
+		return false;
+	}
+	uint64_t sizes[SectionCount];
+	sectionSizes(header, sizes);
+	for (int s = 0; s < SectionCount; ++s) {
+		if (header.offsets[s] % section_alignment != 0 || header.offsets[s] > image.size()
+			|| sizes[s] > image.size() - header.offsets[s]) {
+			error = "corrupt scene image";
+			return false;
+		}
+	}
+
+	for (const auto& material : section<SceneMaterial>(image, header, Materials, header.material_count)) {
+		if (material.type > SceneMaterial::Type::Emissive) {
+			error = "corrupt scene image";
+			return false;
+		}
+	}
+	for (const auto& mesh : section<MeshRecord>(image, header, Meshes, header.mesh_count)) {
+		if (mesh.material >= header.material_count || mesh.path_offset > header.mesh_path_bytes
+			|| mesh.path_length > header.mesh_path_bytes - mesh.path_offset) {
+			error = "corrupt scene image";
+			return false;
+		}
+	}
+	for (const auto material : section<uint32_t>(image, header, MaterialIndex, header.sphere_count)) {
+		if (material >= header.material_count) {
+			error = "corrupt scene image";
+			return false;
+		}
+	}
+
+	// Children always follow their parent, so one forward pass finds the deepest path, which bounds
+	// the traversal stack.
+	const auto nodes = section<BVHNode>(image, header, Nodes, header.node_count);
+	std::vector<uint8_t> depth(nodes.size(), 0);
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const auto& node = nodes[i];
+		bool valid;
+		if (node.isLeaf()) {
+			valid = node.offset <= header.sphere_count && node.count <= header.sphere_count - node.offset;
+		}
+		else {
+			valid = node.axis < 3 && node.offset > i + 1 && node.offset < nodes.size() && depth[i] + 1 < bvh_max_depth;
+			if (valid) {
+				depth[i + 1] = std::max<uint8_t>(depth[i + 1], depth[i] + 1);
+				depth[node.offset] = std::max<uint8_t>(depth[node.offset], depth[i] + 1);
+			}
+		}
+		if (!valid) {
+			error = "corrupt scene image";
+			return false;
+		}
+	}
+	return true;
+}
+
+// Builds the scene on a validated image and loads its meshes, whose relative paths start at
+// directory. storage keeps the image alive as long as the scene.
+bool openImage(std::span<const std::byte> image, std::shared_ptr<const void> storage,
+			   const std::filesystem::path& directory, LoadedScene& loaded, std::string& error)
+{
+	ImageHeader header;
+	std::memcpy(&header, image.data(), sizeof(header));
+
+	auto scene = std::make_shared<Scene>();
+	const auto materials = section<SceneMaterial>(image, header, Materials, header.material_count);
+	scene->materials.reserve(materials.size());
+	for (const auto& material : materials)
+		scene->materials.add(material.toMaterial());
+	scene->sky = header.sky != 0;
+	auto spheres = std::make_shared<SceneSpheres>(image, header, storage);
+
+	const auto emits = [&](uint32_t material) { return scene->materials.emission(material).length_squared() > 0; };
+	const auto sphere_materials = section<uint32_t>(image, header, MaterialIndex, header.sphere_count);
+	for (size_t i = 0; i < sphere_materials.size(); ++i) {
+		if (emits(sphere_materials[i])) {
+			const auto coordinate = [&](Section s) { return section<real>(image, header, s, header.sphere_count)[i]; };
+			scene->lights.addSphere(Point3(coordinate(CenterX), coordinate(CenterY), coordinate(CenterZ)), coordinate(Radius),
+									sphere_materials[i]);
+		}
+	}
+
+	if (header.mesh_count == 0) {
+		scene->world = std::move(spheres);
+	}
+	else {
+		auto world = std::make_shared<HittableList>();
+		if (header.sphere_count > 0)
+			world->add(std::move(spheres));
+
+		const auto paths = section<char>(image, header, MeshPaths, header.mesh_path_bytes);
+		for (const auto& mesh : section<MeshRecord>(image, header, Meshes, header.mesh_count)) {
+			const std::string path = (directory / std::string(&paths[mesh.path_offset], mesh.path_length)).string();
+			MeshBuffers buffers;
+			if (!loadOBJ(path, buffers, error))
+				return false;
+			if (emits(mesh.material))
+				scene->lights.addMesh(buffers, mesh.material);
+			world->add(std::make_shared<TriangleMesh>(std::move(buffers), mesh.material));
+		}
+		scene->world = std::move(world);
+	}
+	scene->lights.build(scene->materials);
+
+	loaded.scene = std::move(scene);
+	loaded.camera = header.camera;
+	loaded.image = image;
+	loaded.image_storage = std::move(storage);
+	return true;
+}
+
+bool parseCamera(std::istringstream& tokens, SceneCamera& camera, std::string& message)
+{
+	std::string key;
+	while (tokens >> key) {
+		bool ok;
+		if (key == "lookfrom")
+			ok = readNumbers(tokens, camera.lookfrom.data(), 3);
+		else if (key == "lookat")
+			ok = readNumbers(tokens, camera.lookat.data(), 3);
+		else if (key == "vup")
+			ok = readNumbers(tokens, camera.vup.data(), 3);
+		else if (key == "vfov")
+			ok = readNumbers(tokens, &camera.vfov, 1);
+		else if (key == "defocus")
+			ok = readNumbers(tokens, &camera.defocus_angle, 1);
+		else if (key == "focus")
+			ok = readNumbers(tokens, &camera.focus_dist, 1) && camera.focus_dist > 0;
+		else if (key == "spp")
+			ok = readNumbers(tokens, &camera.samples_per_pixel, 1) && camera.samples_per_pixel > 0;
+		else if (key == "depth")
+			ok = readNumbers(tokens, &camera.max_depth, 1) && camera.max_depth > 0;
+		else if (key == "aspect") {
+			// Either a ratio like 1.7778 or W:H.
+			double height = 1.0;
+			ok = readNumbers(tokens, &camera.aspect_ratio, 1);
+			if (ok && tokens.peek() == ':')
+				ok = tokens.get() && readNumbers(tokens, &height, 1);
+			ok = ok && camera.aspect_ratio > 0 && height > 0;
+			camera.aspect_ratio /= height;
+		}
+		else {
+			message = "unknown camera setting '" + key + "'";
+			return false;
+		}
+
+		if (!ok) {
+			message = "invalid value for camera setting '" + key + "'";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool parseMaterial(std::istringstream& tokens, SceneMaterial& material, std::string& message)
+{
+	std::string type;
+	tokens >> type;
+	bool ok;
+	if (type == "lambertian") {
+		material.type = SceneMaterial::Type::Lambertian;
+		ok = readNumbers(tokens, material.params.data(), 3);
+	}
+	else if (type == "metal") {
+		material.type = SceneMaterial::Type::Metal;
+		ok = readNumbers(tokens, material.params.data(), 4);
+	}
+	else if (type == "dielectric") {
+		material.type = SceneMaterial::Type::Dielectric;
+		ok = readNumbers(tokens, material.params.data(), 1) && material.params[0] > 0;
+	}
+	else if (type == "emissive") {
+		material.type = SceneMaterial::Type::Emissive;
+		ok = readNumbers(tokens, material.params.data(), 3) && material.params[0] >= 0 && material.params[1] >= 0
+			&& material.params[2] >= 0;
+	}
+	else {
+		message = "unknown material type '" + type + "'";
+		return false;
+	}
+
+	if (!ok)
+		message = "invalid parameters for " + type + " material";
+	return ok;
+}
+
+}
+
+Camera SceneCamera::makeCamera(int image_width) const
+{
+	return Camera(image_width, aspect_ratio, samples_per_pixel, max_depth, vfov,
+				  Point3(lookfrom[0], lookfrom[1], lookfrom[2]), Point3(lookat[0], lookat[1], lookat[2]),
+				  Vec3(vup[0], vup[1], vup[2]), defocus_angle, focus_dist);
+}
+
+Material SceneMaterial::toMaterial() const
+{
+	const Color albedo(params[0], params[1], params[2]);
+	switch (type) {
+	case Type::Metal:
+		return Metal(albedo, static_cast<real>(params[3]));
+	case Type::Dielectric:
+		return Dielectric(static_cast<real>(params[0]));
+	case Type::Emissive:
+		return DiffuseLight(albedo);
+	default:
+		return Lambertian(albedo);
+	}
+}
+
+bool parseSceneText(const std::string& path, SceneDescription& description, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file) {
+		error = path + ": cannot open";
+		return false;
+	}
+
+	description = SceneDescription();
+	std::unordered_map<std::string, uint32_t> material_indices;
+	std::string line;
+	for (int line_number = 1; std::getline(file, line); ++line_number) {
+		if (const auto comment = line.find('#'); comment != std::string::npos)
+			line.erase(comment);
+
+		std::istringstream tokens(line);
+		std::string keyword;
+		if (!(tokens >> keyword))
+			continue;
+
+		std::string message;
+		bool ok = true;
+		if (keyword == "camera") {
+			ok = parseCamera(tokens, description.camera, message);
+		}
+		else if (keyword == "sky") {
+			std::string setting;
+			tokens >> setting;
+			ok = setting == "on" || setting == "off";
+			if (ok)
+				description.sky = setting == "on";
+			else
+				message = "expected 'sky on' or 'sky off'";
+		}
+		else if (keyword == "material") {
+			std::string name;
+			SceneMaterial material;
+			if (!(tokens >> name)) {
+				message = "material without a name";
+				ok = false;
+			}
+			else if (material_indices.contains(name)) {
+				message = "material '" + name + "' defined twice";
+				ok = false;
+			}
+			else if ((ok = parseMaterial(tokens, material, message))) {
+				material_indices.emplace(name, static_cast<uint32_t>(description.materials.size()));
+				description.materials.push_back(material);
+			}
+		}
+		else if (keyword == "mesh") {
+			SceneMesh mesh;
+			std::string name;
+			if (!(tokens >> mesh.path >> name)) {
+				message = "expected 'mesh path material'";
+				ok = false;
+			}
+			else if (const auto found = material_indices.find(name); found == material_indices.end()) {
+				message = "unknown material '" + name + "'";
+				ok = false;
+			}
+			else {
+				mesh.material = found->second;
+				description.meshes.push_back(mesh);
+			}
+		}
+		else if (keyword == "sphere") {
+			SceneSphere sphere;
+			std::string name;
+			ok = readNumbers(tokens, sphere.center.data(), 3) && readNumbers(tokens, &sphere.radius, 1)
+				&& sphere.radius >= 0 && static_cast<bool>(tokens >> name);
+			if (!ok) {
+				message = "expected 'sphere x y z radius material'";
+			}
+			else if (const auto found = material_indices.find(name); found == material_indices.end()) {
+				message = "unknown material '" + name + "'";
+				ok = false;
+			}
+			else {
+				sphere.material = found->second;
+				description.spheres.push_back(sphere);
+			}
+		}
+		else {
+			message = "unknown keyword '" + keyword + "'";
+			ok = false;
+		}
+
+		std::string extra;
+		if (ok && tokens >> extra) {
+			message = "unexpected '" + extra + "'";
+			ok = false;
+		}
+		if (!ok) {
+			error = path + ":" + std::to_string(line_number) + ": " + message;
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<std::byte> compileScene(const SceneDescription& description)
+{
+	const auto& spheres = description.spheres;
+	std::vector<AABB> bounds;
+	bounds.reserve(spheres.size());
+	for (const auto& sphere : spheres) {
+		const Point3 center(sphere.center[0], sphere.center[1], sphere.center[2]);
+		const auto r = static_cast<real>(sphere.radius);
+		bounds.emplace_back(center - Vec3(r, r, r), center + Vec3(r, r, r));
+	}
+	std::vector<BVHNode> nodes;
+	std::vector<uint32_t> order;
+	buildBVH(bounds, nodes, order);
+
+	ImageHeader header{};
+	std::memcpy(header.magic, image_magic, sizeof(image_magic));
+	header.version = image_version;
+	header.byte_order = byte_order_tag;
+	header.real_size = sizeof(real);
+	header.node_size = sizeof(BVHNode);
+	header.sphere_count = spheres.size();
+	header.node_count = nodes.size();
+	header.material_count = description.materials.size();
+	header.mesh_count = description.meshes.size();
+	for (const auto& mesh : description.meshes)
+		header.mesh_path_bytes += mesh.path.size();
+	header.camera = description.camera;
+	header.sky = description.sky;
+
+	uint64_t sizes[SectionCount];
+	sectionSizes(header, sizes);
+	size_t end = alignSection(sizeof(ImageHeader));
+	for (int s = 0; s < SectionCount; ++s) {
+		header.offsets[s] = end;
+		end = alignSection(end + sizes[s]);
+	}
+
+	std::vector<std::byte> image(end, std::byte{ 0 });
+	std::memcpy(image.data(), &header, sizeof(header));
+	auto store = [&](Section s, size_t index, const auto& value) {
+		std::memcpy(image.data() + header.offsets[s] + index * sizeof(value), &value, sizeof(value));
+	};
+	for (size_t slot = 0; slot < order.size(); ++slot) {
+		const auto& sphere = spheres[order[slot]];
+		store(CenterX, slot, static_cast<real>(sphere.center[0]));
+		store(CenterY, slot, static_cast<real>(sphere.center[1]));
+		store(CenterZ, slot, static_cast<real>(sphere.center[2]));
+		store(Radius, slot, static_cast<real>(sphere.radius));
+		store(MaterialIndex, slot, sphere.material);
+	}
+	for (size_t i = 0; i < nodes.size(); ++i)
+		store(Nodes, i, nodes[i]);
+	for (size_t i = 0; i < description.materials.size(); ++i)
+		store(Materials, i, description.materials[i]);
+	uint64_t path_offset = 0;
+	for (size_t i = 0; i < description.meshes.size(); ++i) {
+		const auto& mesh = description.meshes[i];
+		store(Meshes, i, MeshRecord{ mesh.material, static_cast<uint32_t>(mesh.path.size()), path_offset });
+		std::memcpy(image.data() + header.offsets[MeshPaths] + path_offset, mesh.path.data(), mesh.path.size());
+		path_offset += mesh.path.size();
+	}
+	return image;
+}
+
+bool loadScene(const std::string& path, LoadedScene& loaded, std::string& error)
+{
+	namespace fs = std::filesystem;
+
+	// Mesh paths are relative to the scene file, which sits next to its cache.
+	const auto directory = fs::path(path).parent_path();
+
+	// The mapped image, or null if it cannot be used.
+	auto mapValid = [](const std::string& image_path, std::string& reason) -> std::shared_ptr<const MappedFile> {
+		auto file = std::make_shared<const MappedFile>(image_path);
+		if (!file->isOpen()) {
+			reason = "cannot open";
+			return nullptr;
+		}
+		return validateImage(file->bytes(), reason) ? file : nullptr;
+	};
+
+	std::string reason;
+	if (path.ends_with(scene_cache_suffix)) {
+		const auto file = mapValid(path, reason);
+		if (!file) {
+			error = path + ": " + reason;
+			return false;
+		}
+		return openImage(file->bytes(), file, directory, loaded, error);
+	}
+
+	// Reuse the cache while it is newer than the text. A cache from an incompatible build fails
+	// validation and is rebuilt like a stale one.
+	const std::string cache_path = path + scene_cache_suffix;
+	std::error_code text_error, cache_error;
+	const auto text_time = fs::last_write_time(path, text_error);
+	const auto cache_time = fs::last_write_time(cache_path, cache_error);
+	if (!text_error && !cache_error && cache_time > text_time) {
+		if (const auto file = mapValid(cache_path, reason))
+			return openImage(file->bytes(), file, directory, loaded, error);
+	}
+
+	SceneDescription description;
+	if (!parseSceneText(path, description, error))
+		return false;
+	auto image = std::make_shared<std::vector<std::byte>>(compileScene(description));
+
+	// Written under a temporary name and renamed, so a concurrent load never maps a partial file.
+	// A read-only directory only costs the cache.
+	const std::string temp_path = cache_path + ".tmp";
+	std::ofstream file(temp_path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(image->data()), static_cast<std::streamsize>(image->size()));
+	file.close();
+	std::error_code write_error;
+	if (file)
+		fs::rename(temp_path, cache_path, write_error);
+	if (!file || write_error)
+		fs::remove(temp_path, write_error);
+
+	return openImage(*image, image, directory, loaded, error);
+}
+
+bool openSceneImage(std::vector<std::byte> image, const std::string& directory, LoadedScene& loaded, std::string& error)
+{
+	auto storage = std::make_shared<const std::vector<std::byte>>(std::move(image));
+	if (!validateImage(*storage, error))
+		return false;
+	return openImage(*storage, storage, directory, loaded, error);
+}
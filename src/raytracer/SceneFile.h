@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Camera.h"
+#include "Scene.h"
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+// Scene files. The text form (.scene) is line based, '#' starts a comment:
+//
+//   camera lookfrom 13 2 3 lookat 0 0 0 vup 0 1 0 vfov 20 aspect 16:9 defocus 0.6 focus 10 spp 10 depth 50
+//   material ground lambertian 0.5 0.5 0.5
+//   material gold metal 0.8 0.6 0.2 0.1          # albedo, fuzz
+//   material glass dielectric 1.5                # refraction index
+//   material lamp emissive 4 4 4                 # radiance of the front side
+//   sphere 0 -1000 0 1000 ground                 # center, radius, material name
+//   mesh models/bunny.obj gold                   # OBJ path relative to the scene file, material name
+//   sky off                                      # black background instead of the sky gradient
+//
+// Spheres and meshes of emissive materials are the scene's lights.
+// Every camera setting is optional. Loading compiles the text into a binary image with a fixed
+// layout: the sphere attributes as arrays in BVH leaf order and the flattened BVH itself. The image
+// is cached next to the text as <path>.bin and memory-mapped on later loads, which then render
+// straight from the mapped arrays without parsing, building or allocating per sphere. Meshes are
+// only referenced by the image and read from their OBJ files on every load.
+
+// Camera settings of a scene file; the image width is chosen by whoever renders it.
+struct SceneCamera {
+	std::array<double, 3> lookfrom{ 0, 0, 0 };
+	std::array<double, 3> lookat{ 0, 0, -1 };
+	std::array<double, 3> vup{ 0, 1, 0 };
+	double vfov = 90.0;
+	double aspect_ratio = 16.0 / 9.0;
+	double defocus_angle = 0.0;
+	double focus_dist = 10.0;
+	int32_t samples_per_pixel = 10;
+	int32_t max_depth = 10;
+
+	[[nodiscard]] Camera makeCamera(int image_width) const;
+};
+
+// One material of a scene file, in the same form in memory and in the binary image.
+struct SceneMaterial {
+	enum class Type : uint32_t { Lambertian, Metal, Dielectric, Emissive };
+
+	Type type = Type::Lambertian;
+	uint32_t reserved = 0;
+	std::array<double, 4> params{};	// Lambertian: albedo. Metal: albedo, fuzz. Dielectric: refraction index. Emissive: radiance.
+
+	[[nodiscard]] Material toMaterial() const;
+};
+
+struct SceneSphere {
+	std::array<double, 3> center{};
+	double radius = 0.0;
+	uint32_t material = 0;	// Index into SceneDescription::materials
+};
+
+struct SceneMesh {
+	std::string path;		// As written in the scene file
+	uint32_t material = 0;
+};
+
+// A parsed scene file.
+struct SceneDescription {
+	SceneCamera camera;
+	bool sky = true;
+	std::vector<SceneMaterial> materials;
+	std::vector<SceneSphere> spheres;
+	std::vector<SceneMesh> meshes;
+};
+
+// A scene ready to render, with the camera its file describes.
+struct LoadedScene {
+	std::shared_ptr<Scene> scene;
+	SceneCamera camera;
+	std::span<const std::byte> image;		// The binary image the scene was opened from
+	std::shared_ptr<const void> image_storage;	// Keeps image alive
+};
+
+inline constexpr const char* scene_cache_suffix = ".bin";
+
+// Parses a .scene text file. On failure, error holds "path:line: message".
+[[nodiscard]] bool parseSceneText(const std::string& path, SceneDescription& description, std::string& error);
+
+// The binary image of a scene: the exact contents of its cache file. Builds the BVH.
+[[nodiscard]] std::vector<std::byte> compileScene(const SceneDescription& description);
+
+// Loads a scene file. A .scene text file goes through its cache <path>.bin, which is rebuilt
+// when it is missing, older than the text or was written by an incompatible build; if the cache
+// cannot be written, the compiled image is used from memory. A path ending in .bin is mapped
+// directly. On failure, error says why.
+[[nodiscard]] bool loadScene(const std::string& path, LoadedScene& loaded, std::string& error);
+
+// Opens a binary image received from elsewhere, e.g. the LoadedScene::image of another process.
+// Mesh paths start at directory.
+[[nodiscard]] bool openSceneImage(std::vector<std::byte> image, const std::string& directory, LoadedScene& loaded,
+								  std::string& error);
@@ -0,0 +1,227 @@
+#include "Sequence.h"
+#include "BackgroundWriter.h"
+#include "ImageIO.h"
+#include "TextParsing.h"
+#include "Tonemap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+bool readPoint(std::istringstream& tokens, Point3& point)
+{
+	double xyz[3];
+	if (!readNumbers(tokens, xyz, 3))
+		return false;
+	point = Point3(xyz[0], xyz[1], xyz[2]);
+	return true;
+}
+
+// Cubic Hermite between p0 and p1 over a segment of length frames, with tangents m0 and m1 per
+// frame, at t in [0, 1].
+Vec3 hermite(const Vec3& p0, const Vec3& m0, const Vec3& p1, const Vec3& m1, double frames, double t) noexcept
+{
+	const double t2 = t * t;
+	const double t3 = t2 * t;
+	return (2 * t3 - 3 * t2 + 1) * p0 + ((t3 - 2 * t2 + t) * frames) * m0 + (-2 * t3 + 3 * t2) * p1
+		+ ((t3 - t2) * frames) * m1;
+}
+
+// A traced frame on its way to disk.
+struct Frame {
+	std::string path;
+	std::vector<float> rgb;
+	int width = 0;
+	int height = 0;
+	DisplaySettings display;
+};
+
+bool writeFrame(const Frame& frame, std::string& error)
+{
+	bool written;
+	if (frame.path.ends_with(".pfm")) {
+		written = writePFM(frame.path, frame.rgb, frame.width, frame.height);
+	}
+	else if (frame.path.ends_with(".exr")) {
+		written = writeEXR(frame.path, frame.rgb, frame.width, frame.height);
+	}
+	else {
+		// On one thread: the pool is busy with the next frame.
+		const auto rgba = to_rgba8(frame.rgb, frame.width, frame.height, frame.display);
+		written = frame.path.ends_with(".ppm") ? writePPM(frame.path, rgba, frame.width, frame.height)
+											   : writePNG(frame.path, rgba, frame.width, frame.height);
+	}
+	if (!written)
+		error = "Could not write " + frame.path;
+	return written;
+}
+
+}
+
+void CameraPath::add(const CameraKey& key)
+{
+	const auto at = std::lower_bound(keys.begin(), keys.end(), key.frame,
+									 [](const CameraKey& k, double frame) { return k.frame < frame; });
+	if (at != keys.end() && at->frame == key.frame)
+		*at = key;
+	else
+		keys.insert(at, key);
+}
+
+CameraKey CameraPath::at(double frame) const noexcept
+{
+	if (keys.empty())
+		return CameraKey{ frame };
+	if (frame <= keys.front().frame)
+		return CameraKey{ frame, keys.front().lookfrom, keys.front().lookat, keys.front().vfov, keys.front().focus_dist };
+	if (frame >= keys.back().frame)
+		return CameraKey{ frame, keys.back().lookfrom, keys.back().lookat, keys.back().vfov, keys.back().focus_dist };
+
+	const auto next = static_cast<size_t>(std::upper_bound(keys.begin(), keys.end(), frame,
+		[](double f, const CameraKey& k) { return f < k.frame; }) - keys.begin());
+	const auto i = next - 1;
+	const auto& k0 = keys[i];
+	const auto& k1 = keys[next];
+	const double frames = k1.frame - k0.frame;
+	const double t = (frame - k0.frame) / frames;
+
+	// Catmull-Rom tangents for uneven key spacing: the slope between the neighbours of a key, or
+	// towards its only neighbour at either end.
+	const auto tangent = [&](size_t k, auto member) {
+		const size_t before = k > 0 ? k - 1 : k;
+		const size_t after = k + 1 < keys.size() ? k + 1 : k;
+		return (keys[after].*member - keys[before].*member) / (keys[after].frame - keys[before].frame);
+	};
+	CameraKey key;
+	key.frame = frame;
+	key.lookfrom = hermite(k0.lookfrom, tangent(i, &CameraKey::lookfrom), k1.lookfrom, tangent(next, &CameraKey::lookfrom), frames, t);
+	key.lookat = hermite(k0.lookat, tangent(i, &CameraKey::lookat), k1.lookat, tangent(next, &CameraKey::lookat), frames, t);
+	key.vfov = k0.vfov + t * (k1.vfov - k0.vfov);
+	key.focus_dist = k0.focus_dist + t * (k1.focus_dist - k0.focus_dist);
+	return key;
+}
+
+CameraPath CameraPath::turntable(const Camera& camera, int frame_count)
+{
+	// Rodrigues' rotation of the offset from lookat about the up axis, a key on every frame.
+	const Vec3 axis = unit_vector(camera.vup);
+	const Vec3 offset = camera.lookfrom - camera.lookat;
+	CameraPath path;
+	for (int frame = 0; frame < frame_count; ++frame) {
+		const double angle = 2 * pi * frame / frame_count;
+		const Vec3 rotated = std::cos(angle) * offset + std::sin(angle) * cross(axis, offset)
+			+ ((1 - std::cos(angle)) * dot(axis, offset)) * axis;
+		path.add(CameraKey{ static_cast<double>(frame), camera.lookat + rotated, camera.lookat, camera.vfov, camera.focus_dist });
+	}
+	return path;
+}
+
+bool loadCameraPath(const std::string& path, const Camera& camera, CameraPath& camera_path, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file) {
+		error = "Cannot open " + path;
+		return false;
+	}
+
+	CameraKey previous{ 0.0, camera.lookfrom, camera.lookat, camera.vfov, camera.focus_dist };
+	std::string line;
+	for (int line_number = 1; std::getline(file, line); ++line_number) {
+		line = line.substr(0, line.find('#'));
+		std::istringstream tokens(line);
+		std::string keyword;
+		if (!(tokens >> keyword))
+			continue;
+
+		CameraKey key = previous;
+		std::string message;
+		if (keyword != "key") {
+			message = "unknown keyword '" + keyword + "'";
+		}
+		else if (!readNumbers(tokens, &key.frame, 1)) {
+			message = "expected 'key FRAME'";
+		}
+		else {
+			std::string setting;
+			while (message.empty() && tokens >> setting) {
+				bool ok;
+				if (setting == "lookfrom")
+					ok = readPoint(tokens, key.lookfrom);
+				else if (setting == "lookat")
+					ok = readPoint(tokens, key.lookat);
+				else if (setting == "vfov")
+					ok = readNumbers(tokens, &key.vfov, 1) && key.vfov > 0 && key.vfov < 180;
+				else if (setting == "focus")
+					ok = readNumbers(tokens, &key.focus_dist, 1) && key.focus_dist > 0;
+				else {
+					message = "unknown camera setting '" + setting + "'";
+					break;
+				}
+				if (!ok)
+					message = "invalid value for camera setting '" + setting + "'";
+			}
+		}
+		if (!message.empty()) {
+			error = path + ":" + std::to_string(line_number) + ": " + message;
+			return false;
+		}
+		camera_path.add(key);
+		previous = key;
+	}
+	if (camera_path.empty()) {
+		error = path + ": no keys";
+		return false;
+	}
+	return true;
+}
+
+std::string framePath(const std::string& pattern, int frame)
+{
+	const auto slash = pattern.find_last_of("/\\");
+	const auto name_start = slash == std::string::npos ? 0 : slash + 1;
+	auto last = pattern.find_last_of('#');
+	if (last == std::string::npos || last < name_start) {
+		const auto dot = pattern.find_last_of('.');
+		const auto at = dot == std::string::npos || dot < name_start ? pattern.size() : dot;
+		return framePath(pattern.substr(0, at) + "_####" + pattern.substr(at), frame);
+	}
+
+	auto first = last;
+	while (first > 0 && pattern[first - 1] == '#')
+		--first;
+	std::string number = std::to_string(frame);
+	const auto digits = last - first + 1;
+	if (number.size() < digits)
+		number.insert(0, digits - number.size(), '0');
+	return pattern.substr(0, first) + number + pattern.substr(last + 1);
+}
+
+bool renderSequence(Camera camera, const Scene& scene, const CameraPath& camera_path, TileScheduler& scheduler,
+					const SequenceSettings& settings, SequenceReport& report, std::string& error)
+{
+	const auto start = std::chrono::steady_clock::now();
+	BackgroundWriter<Frame> writer(writeFrame, WriterPolicy::Queue, static_cast<size_t>(std::max(settings.frames_in_flight, 1)));
+	for (int frame = settings.first_frame; frame <= settings.last_frame; ++frame) {
+		const auto key = camera_path.at(frame);
+		camera.setView(key.lookfrom, key.lookat, key.vfov, key.focus_dist);
+		camera.frame = static_cast<uint32_t>(frame);
+
+		Frame image{ framePath(settings.output, frame), {}, camera.image_width, camera.imageHeight(), camera.display };
+		const auto trace_start = std::chrono::steady_clock::now();
+		image.rgb = camera.renderLinear(scene, scheduler);
+		report.trace_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - trace_start).count();
+		report.samples += camera.samplesTraced();
+		report.rays += camera.raysTraced();
+		report.stall_seconds += writer.push(std::move(image));
+		++report.frames;
+	}
+
+	const bool written = writer.flush(error);
+	report.write_seconds = writer.writeSeconds();
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return written;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Camera.h"
+#include "Scene.h"
+#include "TileScheduler.h"
+
+#include <span>
+#include <string>
+#include <vector>
+
+// Animation sequences: a camera moving along keyframes through a static scene, rendered frame by
+// frame into numbered images. The scene, its BVH and the render threads are set up once for the
+// whole sequence, and each frame is tone mapped and written on a thread of its own while the
+// next one is traced.
+
+// The view at one frame of a camera path.
+struct CameraKey {
+	double frame = 0.0;
+	Point3 lookfrom = Point3(0, 0, 0);
+	Point3 lookat = Point3(0, 0, -1);
+	double vfov = 90.0;
+	double focus_dist = 10.0;
+};
+
+// Keyframes in frame order. Between keys, lookfrom and lookat follow Catmull-Rom splines, which
+// pass through every key without a kink; vfov and focus_dist are interpolated linearly, so they
+// never overshoot past their keys. Before the first key and after the last the view holds still.
+class CameraPath {
+public:
+	// Inserts key in frame order, replacing a key at the same frame.
+	void add(const CameraKey& key);
+	[[nodiscard]] CameraKey at(double frame) const noexcept;
+
+	[[nodiscard]] bool empty() const noexcept { return keys.empty(); }
+	[[nodiscard]] std::span<const CameraKey> keyframes() const noexcept { return keys; }
+
+	// One full turn of camera's lookfrom around its lookat, about its vup axis, over frames 0 to
+	// frame_count - 1. Frame frame_count would be frame 0 again, so the sequence loops.
+	[[nodiscard]] static CameraPath turntable(const Camera& camera, int frame_count);
+
+private:
+	std::vector<CameraKey> keys;
+};
+
+// Reads a camera path file, one key per line:
+//
+//   # frame, then any of the view settings
+//   key 0  lookfrom 13 2 3 lookat 0 0 0 vfov 20 focus 10
+//   key 48 lookfrom 0 2 13                      # the rest as at frame 0
+//
+// A setting a key leaves out keeps its value from the key before, or from camera for the first.
+[[nodiscard]] bool loadCameraPath(const std::string& path, const Camera& camera, CameraPath& camera_path,
+								  std::string& error);
+
+struct SequenceSettings {
+	int first_frame = 0;
+	int last_frame = 0;				// Inclusive
+	// Image path of each frame. The last run of '#' becomes the frame number, zero-padded to the
+	// run's length; without one, "_####" is inserted before the extension. The extension picks the
+	// format: .png, .ppm, or linear .pfm or .exr.
+	std::string output = "frame_####.png";
+	int frames_in_flight = 2;		// Traced frames waiting to be written at most; tracing waits beyond
+};
+
+// How a sequence went.
+struct SequenceReport {
+	int frames = 0;
+	double seconds = 0.0;			// Wall time of the whole sequence
+	double trace_seconds = 0.0;		// Spent tracing
+	double write_seconds = 0.0;		// Spent tone mapping and writing, on the writer thread
+	double stall_seconds = 0.0;		// Tracing waited for the writer
+	uint64_t samples = 0;
+	uint64_t rays = 0;
+};
+
+// The path of frame under the output pattern of SequenceSettings.
+[[nodiscard]] std::string framePath(const std::string& pattern, int frame);
+
+// Renders every frame of settings' range with camera moved to camera_path.at(frame); all other
+// camera settings apply as they are. Each frame gets its own frame number in camera.frame, so
+// the noise differs between frames. Returns false if an image could not be written; error says
+// which.
+[[nodiscard]] bool renderSequence(Camera camera, const Scene& scene, const CameraPath& camera_path,
+								  TileScheduler& scheduler, const SequenceSettings& settings, SequenceReport& report,
+								  std::string& error);
@@ -0,0 +1,243 @@
+#include "Socket.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+using Length = int;
+
+bool startNetwork() noexcept
+{
+	static const bool started = [] {
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+	return started;
+}
+
+int closeNative(NativeSocket s) noexcept { return ::closesocket(s); }
+int pollNative(pollfd* fds, size_t count, int timeout_ms) noexcept { return ::WSAPoll(fds, static_cast<ULONG>(count), timeout_ms); }
+bool interrupted() noexcept { return ::WSAGetLastError() == WSAEINTR; }
+#else
+using NativeSocket = int;
+using Length = size_t;
+
+bool startNetwork() noexcept { return true; }
+int closeNative(NativeSocket s) noexcept { return ::close(s); }
+int pollNative(pollfd* fds, size_t count, int timeout_ms) noexcept { return ::poll(fds, static_cast<nfds_t>(count), timeout_ms); }
+// The last call failed because a signal arrived first; it can simply be made again.
+bool interrupted() noexcept { return errno == EINTR; }
+#endif
+
+// Tile batches are small messages that should leave right away, and a vanished peer should be
+// an error return rather than a SIGPIPE.
+void configureConnection(NativeSocket s) noexcept
+{
+	const int on = 1;
+	::setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+#ifdef SO_NOSIGPIPE
+	::setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+// Resolves host:port and calls open on each address until it returns an open socket.
+template <typename Open>
+intptr_t openFirst(const std::string& host, uint16_t port, bool passive, std::string& error, Open&& open)
+{
+	if (!startNetwork()) {
+		error = "cannot start the network stack";
+		return -1;
+	}
+
+	addrinfo hints{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = passive ? AI_PASSIVE : 0;
+	addrinfo* addresses = nullptr;
+	if (const int status = ::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses); status != 0) {
+		error = host + ": " + ::gai_strerror(status);
+		return -1;
+	}
+
+	intptr_t result = -1;
+	int last_error = 0;
+	for (const addrinfo* address = addresses; address && result == -1; address = address->ai_next) {
+		const NativeSocket s = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (static_cast<intptr_t>(s) == -1) {
+			last_error = errno;
+			continue;
+		}
+		if (open(s, *address)) {
+			result = static_cast<intptr_t>(s);
+		}
+		else {
+			last_error = errno;
+			closeNative(s);
+		}
+	}
+	::freeaddrinfo(addresses);
+	if (result == -1)
+		error = host + ":" + std::to_string(port) + ": " + std::strerror(last_error);
+	return result;
+}
+
+}
+
+Socket::~Socket()
+{
+	close();
+}
+
+Socket::Socket(Socket&& other) noexcept
+	: handle(other.handle)
+{
+	other.handle = invalid_handle;
+}
+
+Socket& Socket::operator=(Socket&& other) noexcept
+{
+	if (this != &other) {
+		close();
+		handle = other.handle;
+		other.handle = invalid_handle;
+	}
+	return *this;
+}
+
+Socket Socket::listen(const std::string& host, uint16_t port, std::string& error)
+{
+	return Socket(openFirst(host, port, true, error, [](NativeSocket s, const addrinfo& address) {
+		// A restarted coordinator can take its port back while old connections linger.
+		const int reuse = 1;
+		::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+		return ::bind(s, address.ai_addr, static_cast<int>(address.ai_addrlen)) == 0 && ::listen(s, SOMAXCONN) == 0;
+	}));
+}
+
+Socket Socket::connect(const std::string& host, uint16_t port, std::string& error)
+{
+	return Socket(openFirst(host, port, false, error, [](NativeSocket s, const addrinfo& address) {
+		if (::connect(s, address.ai_addr, static_cast<int>(address.ai_addrlen)) != 0)
+			return false;
+		configureConnection(s);
+		return true;
+	}));
+}
+
+uint16_t Socket::localPort() const noexcept
+{
+	sockaddr_storage address{};
+	socklen_t length = sizeof(address);
+	if (::getsockname(static_cast<NativeSocket>(handle), reinterpret_cast<sockaddr*>(&address), &length) != 0)
+		return 0;
+	if (address.ss_family == AF_INET)
+		return ntohs(reinterpret_cast<const sockaddr_in&>(address).sin_port);
+	if (address.ss_family == AF_INET6)
+		return ntohs(reinterpret_cast<const sockaddr_in6&>(address).sin6_port);
+	return 0;
+}
+
+Socket Socket::accept() noexcept
+{
+	const NativeSocket s = ::accept(static_cast<NativeSocket>(handle), nullptr, nullptr);
+	if (static_cast<intptr_t>(s) == -1)
+		return Socket();
+	configureConnection(s);
+	return Socket(static_cast<intptr_t>(s));
+}
+
+bool Socket::sendAll(std::span<const std::byte> bytes) noexcept
+{
+#ifdef MSG_NOSIGNAL
+	constexpr int flags = MSG_NOSIGNAL;
+#else
+	constexpr int flags = 0;
+#endif
+	while (!bytes.empty()) {
+		const auto sent = ::send(static_cast<NativeSocket>(handle), reinterpret_cast<const char*>(bytes.data()),
+								 static_cast<Length>(bytes.size()), flags);
+		if (sent < 0 && interrupted())
+			continue;
+		if (sent <= 0)
+			return false;
+		bytes = bytes.subspan(static_cast<size_t>(sent));
+	}
+	return true;
+}
+
+bool Socket::receiveAll(std::span<std::byte> bytes) noexcept
+{
+	while (!bytes.empty()) {
+		size_t received;
+		if (!receiveSome(bytes, received))
+			return false;
+		bytes = bytes.subspan(received);
+	}
+	return true;
+}
+
+bool Socket::receiveSome(std::span<std::byte> bytes, size_t& received) noexcept
+{
+	while (true) {
+		const auto result = ::recv(static_cast<NativeSocket>(handle), reinterpret_cast<char*>(bytes.data()),
+								   static_cast<Length>(bytes.size()), 0);
+		if (result > 0) {
+			received = static_cast<size_t>(result);
+			return true;
+		}
+		if (result == 0 || !interrupted())
+			return false;
+	}
+}
+
+void Socket::close() noexcept
+{
+	if (handle != invalid_handle)
+		closeNative(static_cast<NativeSocket>(handle));
+	handle = invalid_handle;
+}
+
+bool Socket::poll(std::span<Socket* const> sockets, std::span<uint8_t> readable, int timeout_ms) noexcept
+{
+	std::vector<pollfd> fds(sockets.size());
+	for (size_t i = 0; i < sockets.size(); ++i) {
+		fds[i].fd = static_cast<NativeSocket>(sockets[i]->handle);
+		fds[i].events = POLLIN;
+	}
+	using Clock = std::chrono::steady_clock;
+	const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+	int ready;
+	while ((ready = pollNative(fds.data(), fds.size(), timeout_ms)) < 0 && interrupted()) {
+		// Wait out the rest of the time; a negative timeout waits forever.
+		if (timeout_ms > 0) {
+			const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count();
+			timeout_ms = static_cast<int>(std::max<decltype(left)>(left, 0));
+		}
+	}
+	if (ready < 0)
+		return false;
+	for (size_t i = 0; i < sockets.size(); ++i)
+		readable[i] = (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+	return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Blocking TCP socket, either a listener or one end of a connection. Just enough for the
+// coordinator and workers of a distributed render: no TLS, no timeouts on sends.
+class Socket {
+public:
+	Socket() noexcept = default;
+	~Socket();
+
+	Socket(Socket&& other) noexcept;
+	Socket& operator=(Socket&& other) noexcept;
+	Socket(const Socket&) = delete;
+	Socket& operator=(const Socket&) = delete;
+
+	// Listens on host:port, e.g. "127.0.0.1" or "0.0.0.0"; port 0 picks a free one, see localPort().
+	// Check isOpen() for failure, then error says why.
+	[[nodiscard]] static Socket listen(const std::string& host, uint16_t port, std::string& error);
+	// Connects to host:port, where host is a name or numeric address.
+	[[nodiscard]] static Socket connect(const std::string& host, uint16_t port, std::string& error);
+
+	[[nodiscard]] bool isOpen() const noexcept { return handle != invalid_handle; }
+	[[nodiscard]] uint16_t localPort() const noexcept;
+
+	// Next pending connection of a listener, closed on failure.
+	[[nodiscard]] Socket accept() noexcept;
+	// Both return false once the connection is broken or closed by the peer.
+	[[nodiscard]] bool sendAll(std::span<const std::byte> bytes) noexcept;
+	[[nodiscard]] bool receiveAll(std::span<std::byte> bytes) noexcept;
+	// Reads what has arrived, at least one byte and at most bytes.size(), into received; blocks only
+	// if nothing has, so it does not after poll() found the socket readable. Returns false like
+	// receiveAll().
+	[[nodiscard]] bool receiveSome(std::span<std::byte> bytes, size_t& received) noexcept;
+	void close() noexcept;
+
+	// Waits up to timeout_ms for any of the sockets to have data, a pending connection or a closed
+	// peer, and sets readable (one flag per socket) accordingly. A signal does not cut the wait
+	// short. Returns false if waiting failed.
+	[[nodiscard]] static bool poll(std::span<Socket* const> sockets, std::span<uint8_t> readable, int timeout_ms) noexcept;
+
+private:
+	using Handle = intptr_t;	// A file descriptor, or a SOCKET on Windows
+	static constexpr Handle invalid_handle = -1;
+
+	explicit Socket(Handle handle) noexcept : handle(handle) {}
+
+	Handle handle = invalid_handle;
+};
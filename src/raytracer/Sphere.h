@@ -1,44 +1,73 @@
 #pragma once
 
 #include "Hittable.h"
+#include "RenderStats.h"
 #include "Vec3.h"
 
 class Sphere : public Hittable {
 public:
-	Sphere(const Point3& cen, double r, std::shared_ptr<Material> mat) noexcept : center(cen), radius(std::fmax(0,r)), mat(mat) {}
+	Sphere(const Point3& cen, real r, uint32_t material) noexcept : center(cen), radius(std::fmax(real(0), r)), material(material) {}
 
 	bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept override {
-		Vec3 oc = center - r.origin();
+		PHOTON_STAT(hit_calls++);
+		PHOTON_STAT(primitive_tests++);
+		real t;
+		if (!intersect(center, radius, r, ray_t, t)) [[likely]]
+			return false;
+
+		fillHitRecord(center, radius, material, r, t, rec);
+		return true;
+	}
+
+	[[nodiscard]] AABB boundingBox() const noexcept override {
+		const auto rvec = Vec3(radius, radius, radius);
+		return AABB(center - rvec, center + rvec);
+	}
+
+	// Nearest root of |origin + t * dir - center| = radius inside ray_t. The discriminant is taken as
+	// a * (r^2 - |l|^2), l the offset of the closest point on the ray from the center, and the roots
+	// as q / a and c / q; both avoid the cancellation that breaks h^2 - a * c in float for large or
+	// distant spheres ("Precision Improvements for Ray/Sphere Intersection", Ray Tracing Gems).
+	[[nodiscard]] static bool intersect(const Point3& center, real radius, const Ray& r, Interval ray_t, real& t) noexcept {
+		const Vec3 oc = center - r.origin();
 		const auto a = r.direction().length_squared();
 		const auto h = dot(oc, r.direction());
-		const auto c = oc.length_squared() - radius * radius;
-
-		const auto discriminant = h * h - a * c;
+		const Vec3 l = oc - (h / a) * r.direction();
+		const auto discriminant = a * (radius * radius - l.length_squared());
 
-		if (discriminant < 0) [[likely]]
+		if (discriminant < 0)
 			return false;
 
-		const auto sqrt_d = std::sqrt(discriminant);
+		const auto c = oc.length_squared() - radius * radius;
+		const auto q = h + std::copysign(std::sqrt(discriminant), h);
+		const auto t_a = q / a;
+		const auto t_b = q != 0 ? c / q : t_a;	// A ray grazing the sphere at its origin has the one root 0
 
 		// Find the nearest root that lies in the acceptable range.
-		auto root = (h - sqrt_d) / a;
+		auto root = std::min(t_a, t_b);
 		if (!ray_t.surrounds(root)) {
-			root = (h + sqrt_d) / a;
+			root = std::max(t_a, t_b);
 			if (!ray_t.surrounds(root))
 				return false;
 		}
+		t = root;
+		return true;
+	}
 
-		rec.t = root;
-		rec.p = r.at(rec.t);
-		Vec3 outward_normal = (rec.p - center) / radius;
+	// Fills rec for a hit at t. The point is projected back onto the sphere, so its error is the
+	// rounding of center + radius * normal, not the error accumulated along the ray.
+	static void fillHitRecord(const Point3& center, real radius, uint32_t material, const Ray& r, real t, HitRecord& rec) noexcept {
+		const Vec3 outward_normal = unit_vector(r.at(t) - center);
+		rec.t = t;
+		rec.p = center + radius * outward_normal;
+		rec.p_error = error_gamma(1) * std::max({ std::fabs(rec.p.x()), std::fabs(rec.p.y()), std::fabs(rec.p.z()) })
+			+ error_gamma(5) * radius;
 		rec.set_face_normal(r, outward_normal);
-		rec.mat = mat;
-
-		return true;
+		rec.material = material;
 	}
 
 private:
 	Point3 center;
-	double radius;
-	std::shared_ptr<Material> mat;
-};
\ No newline at end of file
+	real radius;
+	uint32_t material;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <sstream>
+
+// Shared by the line-based text formats: scene files and camera paths.
+
+// Reads count numbers from the stream into values; false if one is missing or malformed.
+template <typename T>
+[[nodiscard]] bool readNumbers(std::istringstream& tokens, T* values, int count)
+{
+	for (int i = 0; i < count; ++i) {
+		if (!(tokens >> values[i]))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,126 @@
+#include "TileScheduler.h"
+
+#include <algorithm>
+
+std::vector<Tile> makeTiles(int width, int height, int tile_size)
+{
+	tile_size = std::max(tile_size, 1);
+
+	std::vector<Tile> tiles;
+	tiles.reserve(static_cast<size_t>((width + tile_size - 1) / tile_size) * ((height + tile_size - 1) / tile_size));
+	for (int y = 0; y < height; y += tile_size) {
+		for (int x = 0; x < width; x += tile_size) {
+			tiles.push_back(Tile{ x, y, std::min(x + tile_size, width), std::min(y + tile_size, height) });
+		}
+	}
+	return tiles;
+}
+
+TileScheduler::TileScheduler(int thread_count)
+{
+	if (thread_count <= 0)
+		thread_count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+	queues.reserve(thread_count);
+	for (int i = 0; i < thread_count; ++i)
+		queues.push_back(std::make_unique<WorkQueue>());
+
+	// Worker 0 is whichever thread calls run().
+	threads.reserve(thread_count - 1);
+	for (int i = 1; i < thread_count; ++i)
+		threads.emplace_back(&TileScheduler::workerLoop, this, i);
+}
+
+TileScheduler::~TileScheduler()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void TileScheduler::run(std::span<const Tile> tiles, const TileFunction& fn)
+{
+	if (tiles.empty())
+		return;
+
+	// Deal tiles round-robin so neighbouring (and similarly expensive) tiles start on different workers.
+	const auto worker_count = queues.size();
+	for (size_t i = 0; i < tiles.size(); ++i)
+		queues[i % worker_count]->items.push_back(static_cast<uint32_t>(i));
+
+	{
+		std::lock_guard lock(mutex);
+		batch_tiles = tiles;
+		batch_fn = &fn;
+		busy_workers = static_cast<int>(threads.size());
+		++generation;
+	}
+	wake.notify_all();
+
+	drain(0);
+
+	std::unique_lock lock(mutex);
+	finished.wait(lock, [this] { return busy_workers == 0; });
+	batch_fn = nullptr;
+	batch_tiles = {};
+}
+
+void TileScheduler::workerLoop(int worker)
+{
+	uint64_t seen_generation = 0;
+	while (true) {
+		{
+			std::unique_lock lock(mutex);
+			wake.wait(lock, [&] { return stopping || generation != seen_generation; });
+			if (stopping)
+				return;
+			seen_generation = generation;
+		}
+
+		drain(worker);
+
+		{
+			std::lock_guard lock(mutex);
+			--busy_workers;
+		}
+		finished.notify_one();
+	}
+}
+
+void TileScheduler::drain(int worker)
+{
+	// No tiles are added while a batch runs, so once every queue is empty the worker is done.
+	uint32_t item;
+	while (pop(worker, item) || steal(worker, item))
+		(*batch_fn)(batch_tiles[item], worker);
+}
+
+bool TileScheduler::pop(int worker, uint32_t& item)
+{
+	auto& queue = *queues[worker];
+	std::lock_guard lock(queue.mutex);
+	if (queue.items.empty())
+		return false;
+	item = queue.items.back();
+	queue.items.pop_back();
+	return true;
+}
+
+bool TileScheduler::steal(int thief, uint32_t& item)
+{
+	const auto worker_count = static_cast<int>(queues.size());
+	for (int offset = 1; offset < worker_count; ++offset) {
+		auto& victim = *queues[(thief + offset) % worker_count];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.items.empty()) {
+			item = victim.items.front();
+			victim.items.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Half-open pixel rectangle [x0,x1) x [y0,y1).
+struct Tile {
+	int x0{0}, y0{0};
+	int x1{0}, y1{0};
+
+	[[nodiscard]] constexpr int width() const noexcept { return x1 - x0; }
+	[[nodiscard]] constexpr int height() const noexcept { return y1 - y0; }
+	[[nodiscard]] constexpr int pixelCount() const noexcept { return width() * height(); }
+};
+
+// Splits a width x height image into row-major tiles of at most tile_size x tile_size pixels.
+[[nodiscard]] std::vector<Tile> makeTiles(int width, int height, int tile_size);
+
+// Persistent pool of worker threads that processes a batch of tiles with work stealing.
+// Tiles are dealt round-robin to per-worker queues; a worker pops from the back of its own
+// queue and, once empty, steals from the front of the others. The calling thread takes part
+// as worker 0, so a scheduler with a thread count of 1 never spawns a thread.
+class TileScheduler {
+public:
+	using TileFunction = std::function<void(const Tile& tile, int worker)>;
+
+	// thread_count <= 0 selects std::thread::hardware_concurrency().
+	explicit TileScheduler(int thread_count = 0);
+	~TileScheduler();
+
+	TileScheduler(const TileScheduler&) = delete;
+	TileScheduler& operator=(const TileScheduler&) = delete;
+	TileScheduler(TileScheduler&&) = delete;
+	TileScheduler& operator=(TileScheduler&&) = delete;
+
+	[[nodiscard]] int threadCount() const noexcept { return static_cast<int>(queues.size()); }
+
+	// Runs fn once for every tile and blocks until all of them are done.
+	// Not reentrant: only one batch may be in flight at a time.
+	void run(std::span<const Tile> tiles, const TileFunction& fn);
+
+private:
+	struct alignas(64) WorkQueue {
+		std::mutex mutex;
+		std::deque<uint32_t> items;
+	};
+
+	void workerLoop(int worker);
+	void drain(int worker);
+	[[nodiscard]] bool pop(int worker, uint32_t& item);
+	[[nodiscard]] bool steal(int thief, uint32_t& item);
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> threads;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	uint64_t generation = 0;
+	int busy_workers = 0;
+	bool stopping = false;
+
+	std::span<const Tile> batch_tiles;
+	const TileFunction* batch_fn = nullptr;
+};
@@ -0,0 +1,145 @@
+#include "Tonemap.h"
+#include "FloatLanes.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int chunk_pixels = 64;	// Encoded at a time, on the stack
+constexpr int band_rows = 16;		// Rows per work item of toneMap()
+
+// The sRGB transfer function for x in [0, 1]. The power 1/2.4 is Ian Taylor's fit over three
+// nested square roots, within a quarter of an 8-bit level of the exact curve.
+template <typename L>
+inline typename L::Reg encodeSRGB(typename L::Reg x) noexcept
+{
+	const auto s1 = L::sqrt(x);
+	const auto s2 = L::sqrt(s1);
+	const auto s3 = L::sqrt(s2);
+	const auto curve = L::sub(L::add(L::mul(L::set1(0.662002687f), s1), L::mul(L::set1(0.684122060f), s2)),
+							  L::add(L::mul(L::set1(0.323583601f), s3), L::mul(L::set1(0.0225411470f), x)));
+	return L::selectLess(x, L::set1(0.0031308f), L::mul(x, L::set1(12.92f)), curve);
+}
+
+// Display value in [0, 1] of the radiance x.
+template <ToneCurve curve, typename L>
+inline typename L::Reg encode(typename L::Reg x) noexcept
+{
+	// Negative and NaN components come out black.
+	x = L::max(x, L::set1(0.0f));
+	if constexpr (curve == ToneCurve::Gamma2) {
+		return L::sqrt(L::min(x, L::set1(1.0f)));
+	}
+	else if constexpr (curve == ToneCurve::SRGB) {
+		return encodeSRGB<L>(L::min(x, L::set1(1.0f)));
+	}
+	else {
+		// The 0.6 matches the fit's exposure to the reference transform's.
+		x = L::mul(x, L::set1(0.6f));
+		const auto numerator = L::mul(x, L::add(L::mul(x, L::set1(2.51f)), L::set1(0.03f)));
+		const auto denominator = L::add(L::mul(x, L::add(L::mul(x, L::set1(2.43f)), L::set1(0.59f))), L::set1(0.14f));
+		return encodeSRGB<L>(L::min(L::div(numerator, denominator), L::set1(1.0f)));
+	}
+}
+
+// count components of rgb times gain into 8-bit levels, rounded up by half a level so that
+// truncating them rounds to nearest.
+template <ToneCurve curve>
+void encodeComponents(const float* rgb, float* levels, int count, float gain) noexcept
+{
+	int i = 0;
+	for (; i + FloatLanes::width <= count; i += FloatLanes::width) {
+		const auto value = encode<curve, FloatLanes>(FloatLanes::mul(FloatLanes::load(rgb + i), FloatLanes::set1(gain)));
+		FloatLanes::store(levels + i, FloatLanes::add(FloatLanes::mul(value, FloatLanes::set1(255.0f)), FloatLanes::set1(0.5f)));
+	}
+	for (; i < count; ++i)
+		levels[i] = encode<curve, ScalarLanes>(rgb[i] * gain) * 255.0f + 0.5f;
+}
+
+// Interleaved gradient noise (Jimenez 2014) in [-0.5, 0.5) for count pixels from (x, y) on:
+// cheap, and without the visible structure of an ordered dither.
+void ditherOffsets(float* offsets, int count, int x, int y) noexcept
+{
+	const auto pattern = [y](auto lanes, auto first) {
+		using L = decltype(lanes);
+		// The arguments are never negative, so truncating takes the fraction.
+		const auto f = L::add(L::mul(L::set1(0.06711056f), first), L::set1(0.00583715f * y));
+		const auto g = L::mul(L::set1(52.9829189f), L::sub(f, L::truncate(f)));
+		return L::sub(L::sub(g, L::truncate(g)), L::set1(0.5f));
+	};
+	float lane_x[FloatLanes::width];
+	int i = 0;
+	for (; i + FloatLanes::width <= count; i += FloatLanes::width) {
+		for (int k = 0; k < FloatLanes::width; ++k)
+			lane_x[k] = static_cast<float>(x + i + k);
+		FloatLanes::store(offsets + i, pattern(FloatLanes{}, FloatLanes::load(lane_x)));
+	}
+	for (; i < count; ++i)
+		offsets[i] = pattern(ScalarLanes{}, static_cast<float>(x + i));
+}
+
+}
+
+const char* toneCurveName(ToneCurve curve) noexcept
+{
+	switch (curve) {
+	case ToneCurve::Gamma2: return "gamma2";
+	case ToneCurve::SRGB: return "srgb";
+	case ToneCurve::ACES: return "aces";
+	}
+	return "unknown";
+}
+
+void toneMapRow(const float* rgb, uint8_t* rgba, int count, int x, int y, const DisplaySettings& settings,
+				float scale) noexcept
+{
+	const float gain = scale * std::exp2(settings.exposure);
+	float levels[3 * chunk_pixels];
+	float offsets[chunk_pixels] = {};
+	for (int first = 0; first < count; first += chunk_pixels) {
+		const int pixels = std::min(chunk_pixels, count - first);
+		switch (settings.curve) {
+		case ToneCurve::Gamma2: encodeComponents<ToneCurve::Gamma2>(rgb + 3 * first, levels, 3 * pixels, gain); break;
+		case ToneCurve::SRGB: encodeComponents<ToneCurve::SRGB>(rgb + 3 * first, levels, 3 * pixels, gain); break;
+		case ToneCurve::ACES: encodeComponents<ToneCurve::ACES>(rgb + 3 * first, levels, 3 * pixels, gain); break;
+		}
+
+		if (settings.dither)
+			ditherOffsets(offsets, pixels, x + first, y);
+
+		// Levels are at least half a level and offsets at most half a level below zero, so only
+		// the top needs clamping.
+		uint8_t* out = rgba + 4 * static_cast<size_t>(first);
+		for (int p = 0; p < pixels; ++p, out += 4) {
+			for (int c = 0; c < 3; ++c)
+				out[c] = static_cast<uint8_t>(std::min(static_cast<int>(levels[3 * p + c] + offsets[p]), 255));
+			out[3] = 255;
+		}
+	}
+}
+
+void toneMapTile(std::span<const float> rgb, std::span<uint8_t> rgba, int width, const Tile& tile,
+				 const DisplaySettings& settings, float scale) noexcept
+{
+	for (int j = tile.y0; j < tile.y1; ++j) {
+		const auto first = static_cast<size_t>(j) * width + tile.x0;
+		toneMapRow(&rgb[3 * first], &rgba[4 * first], tile.width(), tile.x0, j, settings, scale);
+	}
+}
+
+void toneMap(std::span<const float> rgb, std::span<uint8_t> rgba, int width, int height, const DisplaySettings& settings,
+			 TileScheduler& scheduler)
+{
+	std::vector<Tile> bands;
+	for (int y = 0; y < height; y += band_rows)
+		bands.push_back(Tile{ 0, y, width, std::min(y + band_rows, height) });
+	scheduler.run(bands, [&](const Tile& band, int) { toneMapTile(rgb, rgba, width, band, settings); });
+}
+
+std::vector<uint8_t> to_rgba8(const std::vector<float>& rgb, int width, int height, const DisplaySettings& settings)
+{
+	std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+	toneMapTile(rgb, rgba, width, Tile{ 0, 0, width, height }, settings);
+	return rgba;
+}
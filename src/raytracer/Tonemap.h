@@ -0,0 +1,39 @@
+#pragma once
+
+#include "TileScheduler.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// How linear radiance in [0, 1] and beyond maps to display values.
+enum class ToneCurve {
+	Gamma2,	// sqrt(x), clipped at 1; the look of the renders so far
+	SRGB,	// The sRGB transfer function, clipped at 1
+	ACES,	// Narkowicz's fit of the ACES filmic curve, then sRGB: rolls highlights off instead of clipping
+};
+
+[[nodiscard]] const char* toneCurveName(ToneCurve curve) noexcept;
+
+// Everything between the linear framebuffer and the RGBA8 display image. Changing it needs no
+// re-render, only a new toneMap() pass.
+struct DisplaySettings {
+	float exposure = 0.0f;	// In stops: radiance is multiplied by 2^exposure
+	ToneCurve curve = ToneCurve::Gamma2;
+	bool dither = false;	// Noise of up to half a level before quantizing, which breaks up banding in smooth gradients
+};
+
+// Tone maps count pixels of linear RGB (3 floats each) into RGBA8 (4 bytes each, alpha 255). The
+// first pixel is (x, y) of the image, which places the dither pattern. The radiance is multiplied
+// by scale on top of the exposure, e.g. to turn accumulated sums into means.
+void toneMapRow(const float* rgb, uint8_t* rgba, int count, int x, int y, const DisplaySettings& settings,
+				float scale = 1.0f) noexcept;
+// The pixels of tile, from a whole linear image of the given width into a whole RGBA8 image.
+void toneMapTile(std::span<const float> rgb, std::span<uint8_t> rgba, int width, const Tile& tile,
+				 const DisplaySettings& settings, float scale = 1.0f) noexcept;
+// A whole image, bands of rows in parallel.
+void toneMap(std::span<const float> rgb, std::span<uint8_t> rgba, int width, int height, const DisplaySettings& settings,
+			 TileScheduler& scheduler);
+// A linear RGB image (3 floats per pixel) as a new RGBA8 image, on the calling thread.
+[[nodiscard]] std::vector<uint8_t> to_rgba8(const std::vector<float>& rgb, int width, int height,
+											const DisplaySettings& settings = {});
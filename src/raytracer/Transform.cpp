@@ -0,0 +1,112 @@
+#include "Transform.h"
+
+#include <cmath>
+
+Transform Transform::translate(const Vec3& offset) noexcept
+{
+	Transform t;
+	for (int i = 0; i < 3; ++i)
+		t.m[i][3] = offset[i];
+	return t;
+}
+
+Transform Transform::scale(const Vec3& factors) noexcept
+{
+	Transform t;
+	for (int i = 0; i < 3; ++i)
+		t.m[i][i] = factors[i];
+	return t;
+}
+
+Transform Transform::rotate(const Vec3& axis, real degrees) noexcept
+{
+	// Rodrigues' rotation formula.
+	const Vec3 a = unit_vector(axis);
+	const real s = std::sin(degrees_to_radians(degrees));
+	const real c = std::cos(degrees_to_radians(degrees));
+
+	Transform t;
+	t.m[0][0] = a.x() * a.x() + (1 - a.x() * a.x()) * c;
+	t.m[0][1] = a.x() * a.y() * (1 - c) - a.z() * s;
+	t.m[0][2] = a.x() * a.z() * (1 - c) + a.y() * s;
+	t.m[1][0] = a.x() * a.y() * (1 - c) + a.z() * s;
+	t.m[1][1] = a.y() * a.y() + (1 - a.y() * a.y()) * c;
+	t.m[1][2] = a.y() * a.z() * (1 - c) - a.x() * s;
+	t.m[2][0] = a.x() * a.z() * (1 - c) - a.y() * s;
+	t.m[2][1] = a.y() * a.z() * (1 - c) + a.x() * s;
+	t.m[2][2] = a.z() * a.z() + (1 - a.z() * a.z()) * c;
+	return t;
+}
+
+Transform Transform::operator*(const Transform& other) const noexcept
+{
+	Transform t;
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			t.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] + m[i][2] * other.m[2][j];
+			if (j == 3)
+				t.m[i][j] += m[i][3];
+		}
+	}
+	return t;
+}
+
+Transform Transform::inverse() const noexcept
+{
+	// Inverse of the linear part from its cofactors; the translation is then -A^-1 * t.
+	const real c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+	const real c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+	const real c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+	const real inv_det = 1 / (m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02);
+
+	Transform t;
+	t.m[0][0] = c00 * inv_det;
+	t.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+	t.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+	t.m[1][0] = c01 * inv_det;
+	t.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+	t.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+	t.m[2][0] = c02 * inv_det;
+	t.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+	t.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+	for (int i = 0; i < 3; ++i)
+		t.m[i][3] = -(t.m[i][0] * m[0][3] + t.m[i][1] * m[1][3] + t.m[i][2] * m[2][3]);
+	return t;
+}
+
+AABB Transform::applyToBox(const AABB& box) const noexcept
+{
+	// Each output coordinate is extreme at the box corner picked by the signs of its matrix row
+	// (Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems).
+	if (box.isEmpty())
+		return box;
+
+	AABB result;
+	for (int i = 0; i < 3; ++i) {
+		result.min[i] = result.max[i] = m[i][3];
+		real magnitude = std::fabs(m[i][3]);
+		for (int j = 0; j < 3; ++j) {
+			const real a = m[i][j] * box.min[j];
+			const real b = m[i][j] * box.max[j];
+			result.min[i] += std::fmin(a, b);
+			result.max[i] += std::fmax(a, b);
+			magnitude += std::fmax(std::fabs(a), std::fabs(b));
+		}
+
+		// Widened by the rounding error, so the box never ends short of what applyToPoint() produces.
+		result.min[i] -= error_gamma(3) * magnitude;
+		result.max[i] += error_gamma(3) * magnitude;
+	}
+	return result;
+}
+
+real Transform::pointError(const Point3& p, real p_error) const noexcept
+{
+	real error = 0;
+	for (int i = 0; i < 3; ++i) {
+		const real rounding = std::fabs(m[i][0] * p.x()) + std::fabs(m[i][1] * p.y()) + std::fabs(m[i][2] * p.z()) + std::fabs(m[i][3]);
+		const real propagated = std::fabs(m[i][0]) + std::fabs(m[i][1]) + std::fabs(m[i][2]);
+		error = std::fmax(error, error_gamma(3) * rounding + (1 + error_gamma(3)) * propagated * p_error);
+	}
+	return error;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AABB.h"
+#include "Vec3.h"
+
+// Affine transform, stored as the top three rows of a 4x4 matrix: p' = M * (p, 1). Composition
+// reads right to left, so translate(t) * rotate(axis, angle) rotates first.
+class Transform {
+public:
+	real m[3][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } };
+
+	[[nodiscard]] static Transform translate(const Vec3& offset) noexcept;
+	[[nodiscard]] static Transform scale(const Vec3& factors) noexcept;
+	// Counterclockwise rotation about axis when looking down it towards the origin.
+	[[nodiscard]] static Transform rotate(const Vec3& axis, real degrees) noexcept;
+
+	[[nodiscard]] Transform operator*(const Transform& other) const noexcept;
+	// The transform must not be singular.
+	[[nodiscard]] Transform inverse() const noexcept;
+
+	[[nodiscard]] Point3 applyToPoint(const Point3& p) const noexcept {
+		return Point3(m[0][0] * p.x() + m[0][1] * p.y() + m[0][2] * p.z() + m[0][3],
+					  m[1][0] * p.x() + m[1][1] * p.y() + m[1][2] * p.z() + m[1][3],
+					  m[2][0] * p.x() + m[2][1] * p.y() + m[2][2] * p.z() + m[2][3]);
+	}
+
+	[[nodiscard]] Vec3 applyToVector(const Vec3& v) const noexcept {
+		return Vec3(m[0][0] * v.x() + m[0][1] * v.y() + m[0][2] * v.z(),
+					m[1][0] * v.x() + m[1][1] * v.y() + m[1][2] * v.z(),
+					m[2][0] * v.x() + m[2][1] * v.y() + m[2][2] * v.z());
+	}
+
+	// Multiplies by the transposed linear part. Called on the inverse of a transform, this maps
+	// normals, which must stay perpendicular to the transformed surface.
+	[[nodiscard]] Vec3 applyTransposeToVector(const Vec3& v) const noexcept {
+		return Vec3(m[0][0] * v.x() + m[1][0] * v.y() + m[2][0] * v.z(),
+					m[0][1] * v.x() + m[1][1] * v.y() + m[2][1] * v.z(),
+					m[0][2] * v.x() + m[1][2] * v.y() + m[2][2] * v.z());
+	}
+
+	// Bounds of the transformed box.
+	[[nodiscard]] AABB applyToBox(const AABB& box) const noexcept;
+
+	// Bound on the rounding error of each coordinate of applyToPoint(p), for a p whose coordinates
+	// are already off by up to p_error (PBRT, section 3.9.3).
+	[[nodiscard]] real pointError(const Point3& p, real p_error) const noexcept;
+};
@@ -0,0 +1,231 @@
+#include "TriangleMesh.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <type_traits>
+
+WatertightRay::WatertightRay(const Ray& r) noexcept
+	: origin(r.origin())
+{
+	const auto& d = r.direction();
+	kz = std::fabs(d.x()) > std::fabs(d.y())
+		? (std::fabs(d.x()) > std::fabs(d.z()) ? 0 : 2)
+		: (std::fabs(d.y()) > std::fabs(d.z()) ? 1 : 2);
+	kx = (kz + 1) % 3;
+	ky = (kx + 1) % 3;
+	// Keep the winding, and so the sign of the edge functions, independent of the ray direction.
+	if (d[kz] < 0)
+		std::swap(kx, ky);
+
+	sx = d[kx] / d[kz];
+	sy = d[ky] / d[kz];
+	sz = 1 / d[kz];
+}
+
+bool WatertightRay::intersect(const Point3& p0, const Point3& p1, const Point3& p2, Interval ray_t,
+							  real& t, real (&barycentrics)[3]) const noexcept
+{
+	// Vertices relative to the ray origin, sheared into the ray's frame.
+	const Vec3 a = p0 - origin;
+	const Vec3 b = p1 - origin;
+	const Vec3 c = p2 - origin;
+	const real ax = a[kx] - sx * a[kz], ay = a[ky] - sy * a[kz];
+	const real bx = b[kx] - sx * b[kz], by = b[ky] - sy * b[kz];
+	const real cx = c[kx] - sx * c[kz], cy = c[ky] - sy * c[kz];
+
+	real u = cx * by - cy * bx;
+	real v = ax * cy - ay * cx;
+	real w = bx * ay - by * ax;
+
+	// In float an edge function that rounds to zero is redone in double, where it is exact.
+	if constexpr (std::is_same_v<real, float>) {
+		if (u == 0 || v == 0 || w == 0) {
+			u = static_cast<float>(static_cast<double>(cx) * by - static_cast<double>(cy) * bx);
+			v = static_cast<float>(static_cast<double>(ax) * cy - static_cast<double>(ay) * cx);
+			w = static_cast<float>(static_cast<double>(bx) * ay - static_cast<double>(by) * ax);
+		}
+	}
+
+	if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0))
+		return false;
+	const real det = u + v + w;
+	if (det == 0)
+		return false;
+
+	const real az = sz * a[kz], bz = sz * b[kz], cz = sz * c[kz];
+	const real inv_det = 1 / det;
+	t = (u * az + v * bz + w * cz) * inv_det;
+	if (!(t > ray_t.min && t < ray_t.max))
+		return false;
+
+	// Bound on the error of t (PBRT, section 3.9.6); anything closer could be the surface the
+	// ray started on.
+	const real max_z = std::max({ std::fabs(az), std::fabs(bz), std::fabs(cz) });
+	const real max_x = std::max({ std::fabs(ax), std::fabs(bx), std::fabs(cx) });
+	const real max_y = std::max({ std::fabs(ay), std::fabs(by), std::fabs(cy) });
+	const real delta_x = error_gamma(5) * (max_x + max_z);
+	const real delta_y = error_gamma(5) * (max_y + max_z);
+	const real delta_z = error_gamma(3) * max_z;
+	const real delta_e = 2 * (error_gamma(2) * max_x * max_y + delta_y * max_x + delta_x * max_y);
+	const real max_e = std::max({ std::fabs(u), std::fabs(v), std::fabs(w) });
+	const real delta_t = 3 * (error_gamma(3) * max_e * max_z + delta_e * max_z + delta_z * max_e) * std::fabs(inv_det);
+	if (t <= delta_t)
+		return false;
+
+	barycentrics[0] = u * inv_det;
+	barycentrics[1] = v * inv_det;
+	barycentrics[2] = w * inv_det;
+	return true;
+}
+
+uint32_t encodeNormal(const Vec3& n) noexcept
+{
+	// Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half over the upper one.
+	const real l1 = std::fabs(n.x()) + std::fabs(n.y()) + std::fabs(n.z());
+	real x = n.x() / l1;
+	real y = n.y() / l1;
+	if (n.z() < 0) {
+		const real fx = (1 - std::fabs(y)) * (x < 0 ? -1 : 1);
+		const real fy = (1 - std::fabs(x)) * (y < 0 ? -1 : 1);
+		x = fx;
+		y = fy;
+	}
+	auto quantize = [](real value) {
+		return static_cast<uint32_t>(static_cast<uint16_t>(static_cast<int16_t>(std::lround(std::clamp<real>(value, -1, 1) * 32767))));
+	};
+	return quantize(x) | (quantize(y) << 16);
+}
+
+Vec3 decodeNormal(uint32_t encoded) noexcept
+{
+	real x = static_cast<int16_t>(encoded & 0xffff) / real(32767);
+	real y = static_cast<int16_t>(encoded >> 16) / real(32767);
+	const real z = 1 - std::fabs(x) - std::fabs(y);
+	if (z < 0) {
+		const real fx = (1 - std::fabs(y)) * (x < 0 ? -1 : 1);
+		const real fy = (1 - std::fabs(x)) * (y < 0 ? -1 : 1);
+		x = fx;
+		y = fy;
+	}
+	return unit_vector(Vec3(x, y, z));
+}
+
+TriangleMesh::TriangleMesh(MeshBuffers buffers, uint32_t material, int max_leaf_size)
+	: positions(std::move(buffers.positions))
+	, material(material)
+{
+	const size_t triangle_count = buffers.indices.size() / 3;
+	std::vector<AABB> bounds(triangle_count);
+	for (size_t i = 0; i < triangle_count; ++i) {
+		for (size_t k = 0; k < 3; ++k)
+			bounds[i].expand(positions[buffers.indices[3 * i + k]]);
+	}
+
+	std::vector<uint32_t> order;
+	buildBVH(bounds, nodes, order, max_leaf_size);
+
+	indices.reserve(3 * triangle_count);
+	for (const auto triangle : order) {
+		for (size_t k = 0; k < 3; ++k)
+			indices.push_back(buffers.indices[3 * triangle + k]);
+	}
+
+	if (buffers.normals.size() == positions.size()) {
+		normals.reserve(buffers.normals.size());
+		for (const auto& n : buffers.normals)
+			normals.push_back(encodeNormal(n));
+	}
+}
+
+bool TriangleMesh::hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept
+{
+	PHOTON_STAT(hit_calls++);
+	const WatertightRay ray(r);
+	uint32_t nearest = 0;
+	real nearest_t = 0;
+	real b[3]{};
+	const bool found = traverseBVH(nodes, r, ray_t, [&](uint32_t slot, Interval& t) {
+		PHOTON_STAT(primitive_tests++);
+		const uint32_t* triangle = &indices[3 * static_cast<size_t>(slot)];
+		real t_hit;
+		real barycentrics[3];
+		if (!ray.intersect(positions[triangle[0]], positions[triangle[1]], positions[triangle[2]], t, t_hit, barycentrics))
+			return false;
+		nearest = slot;
+		nearest_t = t_hit;
+		std::copy_n(barycentrics, 3, b);
+		t.max = t_hit;
+		return true;
+	});
+	if (!found)
+		return false;
+
+	// Full attributes only for the winner. The point is interpolated from the vertices rather
+	// than taken along the ray, which keeps its error independent of the ray length.
+	const uint32_t* triangle = &indices[3 * static_cast<size_t>(nearest)];
+	const Point3& p0 = positions[triangle[0]];
+	const Point3& p1 = positions[triangle[1]];
+	const Point3& p2 = positions[triangle[2]];
+	rec.t = nearest_t;
+	rec.p = b[0] * p0 + b[1] * p1 + b[2] * p2;
+	const Vec3 abs_sum = Vec3(std::fabs(b[0] * p0.x()), std::fabs(b[0] * p0.y()), std::fabs(b[0] * p0.z()))
+		+ Vec3(std::fabs(b[1] * p1.x()), std::fabs(b[1] * p1.y()), std::fabs(b[1] * p1.z()))
+		+ Vec3(std::fabs(b[2] * p2.x()), std::fabs(b[2] * p2.y()), std::fabs(b[2] * p2.z()));
+	rec.p_error = error_gamma(7) * std::max({ abs_sum.x(), abs_sum.y(), abs_sum.z() });
+	rec.material = material;
+
+	// The side is decided by the geometric normal; an interpolated normal is turned to the same
+	// side, which also covers files whose normals disagree with the winding.
+	rec.set_face_normal(r, unit_vector(cross(p1 - p0, p2 - p0)));
+	if (!normals.empty()) {
+		const Vec3 shading = b[0] * decodeNormal(normals[triangle[0]]) + b[1] * decodeNormal(normals[triangle[1]])
+			+ b[2] * decodeNormal(normals[triangle[2]]);
+		if (shading.length_squared() > 0)
+			rec.normal = unit_vector(dot(shading, rec.normal) < 0 ? -shading : shading);
+	}
+	return true;
+}
+
+AABB TriangleMesh::boundingBox() const noexcept
+{
+	return nodes.empty() ? AABB() : nodes.front().bounds;
+}
+
+size_t TriangleMesh::memoryBytes() const noexcept
+{
+	return positions.size() * sizeof(Point3) + normals.size() * sizeof(uint32_t)
+		+ indices.size() * sizeof(uint32_t) + nodes.size() * sizeof(BVHNode);
+}
+
+MeshBuffers makeIcosphere(int subdivisions)
+{
+	const double g = (1.0 + std::sqrt(5.0)) / 2.0;
+	MeshBuffers mesh;
+	for (const auto& p : { Vec3(-1, g, 0), Vec3(1, g, 0), Vec3(-1, -g, 0), Vec3(1, -g, 0), Vec3(0, -1, g), Vec3(0, 1, g),
+						   Vec3(0, -1, -g), Vec3(0, 1, -g), Vec3(g, 0, -1), Vec3(g, 0, 1), Vec3(-g, 0, -1), Vec3(-g, 0, 1) })
+		mesh.positions.push_back(unit_vector(p));
+	mesh.indices = { 0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+					 3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1 };
+
+	for (int s = 0; s < subdivisions; ++s) {
+		std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+		auto midpoint = [&](uint32_t a, uint32_t b) {
+			const auto key = std::minmax(a, b);
+			const auto [it, inserted] = midpoints.try_emplace(key, static_cast<uint32_t>(mesh.positions.size()));
+			if (inserted)
+				mesh.positions.push_back(unit_vector(mesh.positions[a] + mesh.positions[b]));
+			return it->second;
+		};
+		std::vector<uint32_t> indices;
+		for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+			const uint32_t a = mesh.indices[t], b = mesh.indices[t + 1], c = mesh.indices[t + 2];
+			const uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+			indices.insert(indices.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+		}
+		mesh.indices = std::move(indices);
+	}
+	mesh.normals = mesh.positions;
+	return mesh;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "BVH.h"
+#include "Hittable.h"
+
+#include <vector>
+
+// Vertex and index buffers of a mesh as a loader produces them.
+struct MeshBuffers {
+	std::vector<Point3> positions;
+	std::vector<Vec3> normals;		// Empty or one per position
+	std::vector<uint32_t> indices;	// Three per triangle
+};
+
+// Per-ray setup of the watertight ray/triangle test (Woop, Benthin and Wald, "Watertight
+// Ray/Triangle Intersection", JCGT 2013). The ray is sheared so it runs along +z from the origin;
+// the edge functions are then evaluated in 2D with the same operations for the edge shared by two
+// triangles, so a ray through an edge or vertex cannot slip between them.
+struct WatertightRay {
+	explicit WatertightRay(const Ray& r) noexcept;
+
+	// Ray parameter and barycentrics (b0 for p0) of a hit inside ray_t. Hits closer than the
+	// error bound of t are rejected, so a ray spawned on the triangle does not find it again.
+	[[nodiscard]] bool intersect(const Point3& p0, const Point3& p1, const Point3& p2, Interval ray_t,
+								 real& t, real (&barycentrics)[3]) const noexcept;
+
+	Point3 origin;
+	int kx, ky, kz;		// Permuted axes, kz the dominant direction component
+	real sx, sy, sz;	// Shear constants
+};
+
+// Triangles sharing one vertex buffer, with a BVH of their own so a mesh of any size is a single
+// entry in a HittableList. Triangles are reordered into BVH leaf order, so a leaf reads its vertex
+// indices from one contiguous run. Normals, if given, are stored octahedrally encoded in 32 bits
+// and interpolated for shading; otherwise the mesh is flat shaded.
+class TriangleMesh : public Hittable {
+public:
+	TriangleMesh(MeshBuffers buffers, uint32_t material, int max_leaf_size = 4);
+
+	bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const noexcept override;
+	[[nodiscard]] AABB boundingBox() const noexcept override;
+
+	[[nodiscard]] size_t triangleCount() const noexcept { return indices.size() / 3; }
+	[[nodiscard]] size_t vertexCount() const noexcept { return positions.size(); }
+	[[nodiscard]] bool hasNormals() const noexcept { return !normals.empty(); }
+	// Bytes held by the vertex, index and BVH buffers.
+	[[nodiscard]] size_t memoryBytes() const noexcept;
+
+private:
+	std::vector<Point3> positions;
+	std::vector<uint32_t> normals;	// Octahedral encoding, see encodeNormal()
+	std::vector<uint32_t> indices;	// Three per triangle, in BVH leaf order
+	std::vector<BVHNode> nodes;
+	uint32_t material;
+};
+
+// Unit vector to two 16-bit octahedral coordinates and back, with an angular error below 1e-4.
+[[nodiscard]] uint32_t encodeNormal(const Vec3& n) noexcept;
+[[nodiscard]] Vec3 decodeNormal(uint32_t encoded) noexcept;
+
+// A closed unit icosphere with vertex normals, each subdivision splitting every triangle into four.
+[[nodiscard]] MeshBuffers makeIcosphere(int subdivisions);
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "math_utils.h"
+
+class Vec3 {
+public:
+	real e[3];
+
+	constexpr Vec3() noexcept : e{ 0, 0, 0 } {}
+	constexpr Vec3(real x, real y, real z) noexcept : e{ x, y, z } {}
+
+	[[nodiscard]] constexpr real x() const noexcept { return e[0]; }
+	[[nodiscard]] constexpr real y() const noexcept { return e[1]; }
+	[[nodiscard]] constexpr real z() const noexcept { return e[2]; }
+
+	[[nodiscard]] constexpr real operator[](int i) const noexcept { return e[i]; }
+	constexpr real& operator[](int i) noexcept { return e[i]; }
+
+	constexpr Vec3& operator+=(const Vec3& v) noexcept {
+		e[0] += v.e[0];
+		e[1] += v.e[1];
+		e[2] += v.e[2];
+		return *this;
+	}
+	constexpr Vec3& operator-=(const Vec3& v) noexcept {
+		e[0] -= v.e[0];
+		e[1] -= v.e[1];
+		e[2] -= v.e[2];
+		return *this;
+	}
+	constexpr Vec3& operator*=(const real t) noexcept {
+		e[0] *= t;
+		e[1] *= t;
+		e[2] *= t;
+		return *this;
+	}
+	constexpr Vec3& operator*=(const Vec3& v) noexcept {
+		e[0] *= v.e[0];
+		e[1] *= v.e[1];
+		e[2] *= v.e[2];
+		return *this;
+	}
+	constexpr Vec3& operator/=(const real t) noexcept {
+		return *this *= (1 / t);
+	}
+
+	[[nodiscard]] constexpr real length_squared() const noexcept {
+		return e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+	}
+
+	// Not constexpr because of std::sqrt
+	[[nodiscard]] real length() const noexcept {
+		return std::sqrt(length_squared());
+	}
+
+	[[nodiscard]] bool near_zero() const noexcept {
+		// Return true if the vector is close to zero in all dimensions.
+		constexpr auto s = real(1e-8);
+		return (std::fabs(e[0]) < s) && (std::fabs(e[1]) < s) && (std::fabs(e[2]) < s);
+	}
+
+	void normalize() noexcept {
+		*this /= length();
+	}
+
+	static Vec3 random() noexcept {
+		return Vec3(real(random_double()), real(random_double()), real(random_double()));
+	}
+
+	static Vec3 random(real min, real max) noexcept {
+		return Vec3(real(random_double(min, max)), real(random_double(min, max)), real(random_double(min, max)));
+	}
+};
+
+// Define Point3 as an alias for Vec3, for code clarity
+using Point3 = Vec3;
+
+inline constexpr Vec3 operator-(const Vec3& v) noexcept {
+	return Vec3{ -v.e[0], -v.e[1], -v.e[2] };
+}
+
+inline constexpr Vec3 operator+(Vec3 a, const Vec3& b) noexcept {
+	return a += b;
+}
+
+inline constexpr Vec3 operator-(Vec3 a, const Vec3& b) noexcept {
+	return a -= b;
+}
+
+inline constexpr Vec3 operator*(Vec3 a, const real t) noexcept {
+	return a *= t;
+}
+
+inline constexpr Vec3 operator*(const real t, Vec3 a) noexcept {
+	return a *= t;
+}
+
+inline constexpr Vec3 operator*(Vec3 a, const Vec3& b) noexcept {
+	return a *= b;
+}
+
+inline constexpr Vec3 operator/(Vec3 a, const real t) noexcept {
+	return a /= t;
+}
+
+// Not constexpr because of std::fma
+[[nodiscard]] inline real dot(const Vec3& a, const Vec3& b) noexcept {
+	return std::fma(a.e[0], b.e[0], std::fma(a.e[1], b.e[1], a.e[2] * b.e[2]));
+}
+
+[[nodiscard]] inline constexpr Vec3 cross(const Vec3& a, const Vec3& b) noexcept {
+	return Vec3{ a.e[1] * b.e[2] - a.e[2] * b.e[1],
+				 a.e[2] * b.e[0] - a.e[0] * b.e[2],
+				 a.e[0] * b.e[1] - a.e[1] * b.e[0] };
+}
+
+[[nodiscard]] inline Vec3 unit_vector(Vec3 v) noexcept {
+	return v /= std::sqrt(v.length_squared());
+}
+
+// Uniform direction on the unit sphere from two uniforms in [0,1), in closed form so that
+// stratified or low-discrepancy inputs keep their structure.
+[[nodiscard]] inline Vec3 sample_uniform_sphere(real u1, real u2) noexcept {
+	const auto z = 1 - 2 * u1;
+	const auto r = std::sqrt(std::max(real(0), 1 - z * z));
+	const auto phi = 2 * pi * u2;
+	return Vec3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
+// Shirley-Chiu concentric mapping of [0,1)^2 onto the unit disk (z = 0). Unlike the polar
+// mapping it keeps neighbouring strata adjacent and undistorted.
+[[nodiscard]] inline Vec3 sample_uniform_disk_concentric(real u1, real u2) noexcept {
+	const auto ox = 2 * u1 - 1;
+	const auto oy = 2 * u2 - 1;
+	if (ox == 0 && oy == 0)
+		return Vec3(0, 0, 0);
+
+	real r, theta;
+	if (std::fabs(ox) > std::fabs(oy)) {
+		r = ox;
+		theta = (pi / 4) * (oy / ox);
+	}
+	else {
+		r = oy;
+		theta = (pi / 2) - (pi / 4) * (ox / oy);
+	}
+	return Vec3(r * std::cos(theta), r * std::sin(theta), 0);
+}
+
+[[nodiscard]] inline Vec3 random_unit_vector() noexcept {
+	const auto u1 = real(random_double());
+	return sample_uniform_sphere(u1, real(random_double()));
+}
+
+[[nodiscard]] inline Vec3 random_on_hemisphere(const Vec3& normal) noexcept {
+	Vec3 on_unit_sphere = random_unit_vector();
+	if (dot(on_unit_sphere, normal) > 0) // In the same hemisphere as the normal
+		return on_unit_sphere;
+	else
+		return -on_unit_sphere;
+}
+
+[[nodiscard]] inline Vec3 random_in_unit_disk() noexcept {
+	const auto u1 = real(random_double());
+	return sample_uniform_disk_concentric(u1, real(random_double()));
+}
+
+[[nodiscard]] inline Vec3 reflect(const Vec3& v, const Vec3& n) noexcept {
+	return v - 2 * dot(v, n) * n;
+}
+
+[[nodiscard]] inline Vec3 refract(const Vec3& uv, const Vec3& n, real etai_over_etat) noexcept {
+	auto cos_theta = std::min(dot(-uv, n), real(1));
+	Vec3 r_out_perp = etai_over_etat * (uv + cos_theta * n);
+	Vec3 r_out_parallel = -std::sqrt(std::fabs(1 - r_out_perp.length_squared())) * n;
+	return r_out_perp + r_out_parallel;
+}
\ No newline at end of file
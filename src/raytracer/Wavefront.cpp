@@ -0,0 +1,131 @@
+#include "Wavefront.h"
+
+#include <algorithm>
+#include <utility>
+
+WavefrontTracer::WavefrontTracer(const Camera& camera, size_t max_paths)
+	: camera(&camera)
+	, max_paths(std::max<size_t>(max_paths, 1))
+{
+}
+
+const std::vector<Color>& WavefrontTracer::traceTile(const Scene& scene, const Tile& tile, Sampler& sampler, uint64_t& rays)
+{
+	const auto pixels = static_cast<uint32_t>(tile.pixelCount());
+	const int samples_per_pixel = camera->samples_per_pixel;
+	const int samples_per_wave = std::max(static_cast<int>(max_paths / pixels), 1);
+	pixel_sums.assign(pixels, Color(0, 0, 0));
+
+	for (int first_sample = 0; first_sample < samples_per_pixel; first_sample += samples_per_wave) {
+		const int last_sample = std::min(first_sample + samples_per_wave, samples_per_pixel);
+
+		// Sample-major slots, so adding up the results in slot order sums each pixel's samples in the
+		// same order as a path-by-path render.
+		paths.clear();
+		radiance.assign(static_cast<size_t>(last_sample - first_sample) * pixels, Color(0, 0, 0));
+		uint32_t slot = 0;
+		for (int sample = first_sample; sample < last_sample; ++sample) {
+			for (int j = tile.y0; j < tile.y1; ++j) {
+				for (int i = tile.x0; i < tile.x1; ++i) {
+					const Ray ray = camera->cameraRay(i, j, sample, sampler);
+					paths.push_back(PathState{ ray, Color(1, 1, 1), slot++, i, j, sample, sampler.currentDimension(), 0 });
+				}
+			}
+		}
+
+		for (int depth = 0; depth < camera->max_depth && !paths.empty(); ++depth) {
+			rays += paths.size();
+			if (depth > 0)
+				PHOTON_STAT(bounce_rays += paths.size());
+			intersect(scene, depth);
+			shade(scene, depth, sampler);
+			rays += traceShadows(scene);
+			paths.swap(next_paths);
+		}
+		PHOTON_STAT(truncated_paths += paths.size());
+		PHOTON_STAT(recordPathEnd(camera->max_depth, paths.size()));
+
+		for (uint32_t s = 0; s < radiance.size(); ++s)
+			pixel_sums[s % pixels] += radiance[s];
+	}
+
+	return pixel_sums;
+}
+
+void WavefrontTracer::intersect(const Scene& scene, [[maybe_unused]] int depth)
+{
+	for (auto& bin : bins)
+		bin.clear();
+
+	const Hittable& world = *scene.world;
+	hits.resize(paths.size());
+	for (uint32_t k = 0; k < paths.size(); ++k) {
+		const auto& path = paths[k];
+		if (!world.hit(path.ray, Interval(0, infinity), hits[k])) {
+			PHOTON_STAT(escaped_paths++);
+			PHOTON_STAT(recordPathEnd(depth));
+			radiance[path.slot] += path.throughput * Camera::backgroundColor(scene, path.ray);
+			continue;
+		}
+		const auto& rec = hits[k];
+		if (const Color emitted = scene.materials.emitted(rec); emitted.length_squared() > 0)
+			radiance[path.slot] += path.throughput * emitted * camera->emitterWeight(scene, path.ray, rec, emitted, path.scatter_pdf);
+		bins[scene.materials[rec.material].index()].push_back(k);
+	}
+}
+
+void WavefrontTracer::shade(const Scene& scene, int depth, Sampler& sampler)
+{
+	next_paths.clear();
+	shadows.clear();
+	[&]<size_t... Type>(std::index_sequence<Type...>) {
+		(shadeBin<Type>(scene, depth, sampler), ...);
+	}(std::make_index_sequence<std::variant_size_v<Material>>{});
+}
+
+template <size_t Type>
+void WavefrontTracer::shadeBin(const Scene& scene, int depth, Sampler& sampler)
+{
+	for (const uint32_t k : bins[Type]) {
+		const auto& path = paths[k];
+		const auto& rec = hits[k];
+		const auto& material = std::get<Type>(scene.materials[rec.material]);
+
+		sampler.startPixelSample(path.x, path.y, path.sample, path.dimension);
+		Ray shadow;
+		Color direct;
+		if (camera->sampleDirectLight(scene, path.ray, rec, sampler, shadow, direct))
+			shadows.push_back(ShadowRay{ shadow, path.throughput * direct, path.slot });
+
+		PHOTON_STAT(scatter_events[Type]++);
+		Ray scattered;
+		Color attenuation;
+		if (!material.scatter(path.ray, rec, attenuation, scattered, sampler)) {
+			PHOTON_STAT(absorbed_paths++);
+			PHOTON_STAT(recordPathEnd(depth + 1));
+			continue;
+		}
+
+		Color throughput = path.throughput * attenuation;
+		if (!camera->survivesRoulette(depth, throughput, sampler)) {
+			PHOTON_STAT(roulette_paths++);
+			PHOTON_STAT(recordPathEnd(depth + 1));
+			continue;
+		}
+
+		next_paths.push_back(PathState{ scattered, throughput, path.slot, path.x, path.y, path.sample, sampler.currentDimension(),
+										camera->scatterDensity(scene, path.ray, rec, scattered) });
+	}
+}
+
+size_t WavefrontTracer::traceShadows(const Scene& scene)
+{
+	const Hittable& world = *scene.world;
+	PHOTON_STAT(shadow_rays += shadows.size());
+	for (const auto& shadow : shadows) {
+		HitRecord blocker;
+		if (!world.hit(shadow.ray, Interval(0, 1), blocker))
+			radiance[shadow.slot] += shadow.radiance;
+	}
+	return shadows.size();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Camera.h"
+#include "Scene.h"
+#include "Sampler.h"
+#include "TileScheduler.h"
+
+#include <array>
+#include <vector>
+
+// Wavefront execution of a tile: the camera rays of all its samples go into a queue, which is
+// intersected in bulk, binned by material type and shaded one bin at a time, producing the queue
+// of extension rays for the next bounce. Intersection and each material's scatter code then run in
+// tight loops of their own instead of alternating per ray; so do the shadow rays of next-event
+// estimation, which shading queues and which are traced in bulk after it.
+//
+// A path keeps its pixel, sample index and sampler dimension, so resuming it draws the same sample
+// values as Camera::samplePixel() would. With the stratified and Sobol samplers the image is the
+// same as a path-by-path render; the independent sampler reseeds on resume, so it is only the same
+// in distribution. One tracer per render thread, it keeps its queues between tiles.
+class WavefrontTracer {
+public:
+	// `max_paths` bounds the queue; tiles with more pixels * samples are traced in several waves.
+	explicit WavefrontTracer(const Camera& camera, size_t max_paths = 1 << 14);
+
+	// Radiance summed over camera.samples_per_pixel samples for each pixel of the tile, row by row,
+	// valid until the next call. Adds the number of rays intersected with the scene to `rays`.
+	const std::vector<Color>& traceTile(const Scene& scene, const Tile& tile, Sampler& sampler, uint64_t& rays);
+
+private:
+	struct PathState {
+		Ray ray;
+		Color throughput;
+		uint32_t slot;		// Index of the path's entry in `radiance`
+		int x, y;
+		int sample;
+		int dimension;		// Next sampler dimension of this path
+		real scatter_pdf;	// Of the bounce that led to ray, see Camera::scatterDensity()
+	};
+
+	// A shadow ray and what it adds to its path's radiance if nothing blocks it.
+	struct ShadowRay {
+		Ray ray;
+		Color radiance;
+		uint32_t slot;
+	};
+
+	void intersect(const Scene& scene, int depth);
+	void shade(const Scene& scene, int depth, Sampler& sampler);
+	// Scatters the paths of one bin with the material type known at compile time.
+	template <size_t Type>
+	void shadeBin(const Scene& scene, int depth, Sampler& sampler);
+	// Returns the number of shadow rays traced.
+	size_t traceShadows(const Scene& scene);
+
+	const Camera* camera;
+	size_t max_paths;
+
+	std::vector<PathState> paths;
+	std::vector<PathState> next_paths;
+	std::vector<HitRecord> hits;		// Parallel to `paths`
+	std::vector<ShadowRay> shadows;
+	std::array<std::vector<uint32_t>, std::variant_size_v<Material>> bins;	// Indices into `paths` per material type
+	std::vector<Color> radiance;		// Result of every path in the current wave
+	std::vector<Color> pixel_sums;
+};
@@ -1,26 +1,54 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <limits>
 #include <memory>
-#include <random>
+
+#include "Random.h"
+
+// Scalar type of the geometry and shading math. Double by default; configuring with
+// PHOTON_USE_FLOAT=ON halves vectors, rays and hit records and doubles the SIMD width.
+#ifdef PHOTON_USE_FLOAT
+using real = float;
+#else
+using real = double;
+#endif
 
 // Constants
 
-inline constexpr double infinity = std::numeric_limits<double>::infinity();
-inline constexpr double pi = 3.1415926535897932385;
+inline constexpr real infinity = std::numeric_limits<real>::infinity();
+inline constexpr real pi = real(3.1415926535897932385);
 
 // Utility Functions
 
-[[nodiscard]] inline constexpr double degrees_to_radians(double degrees) noexcept {
-	return degrees * pi / 180.0;
+[[nodiscard]] inline constexpr real degrees_to_radians(real degrees) noexcept {
+	return degrees * pi / 180;
+}
+
+// Bound on the relative rounding error of n chained floating point operations (PBRT's gamma(n)).
+[[nodiscard]] inline constexpr real error_gamma(int n) noexcept {
+	constexpr real unit_roundoff = std::numeric_limits<real>::epsilon() / 2;
+	return (n * unit_roundoff) / (1 - n * unit_roundoff);
+}
+
+// Each thread owns a small PCG32 generator, so render workers never share state.
+[[nodiscard]] inline Pcg32& random_generator() noexcept {
+	thread_local Pcg32 generator;
+	return generator;
+}
+
+// Seeds the calling thread's generator for one camera sample. Every (pixel, sample, frame)
+// gets its own sequence, so any pixel re-renders identically whatever thread or tile order.
+inline void seed_random(uint32_t pixel, uint32_t sample, uint32_t frame, uint32_t seed = 0) noexcept {
+	random_generator().seed(mix_bits((uint64_t(frame) << 32) | pixel),
+							mix_bits((uint64_t(seed) << 32) | sample));
 }
 
 inline double random_double() {
-	static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-	static std::mt19937 generator;
-	return distribution(generator);
+	return random_generator().nextDouble();
 }
 
 inline double random_double(double min, double max) {
@@ -1,27 +0,0 @@
-#pragma once
-
-#include "Hittable.h"
-#include "HittableList.h"
-#include "Sphere.h"
-#include "Camera.h"
-#include "Materials/AllMaterials.h"
-
-[[nodiscard]] std::vector<uint8_t> raytrace(int width, int height) {
-	HittableList world;
-
-	// Make the above work for my code
-	auto material_ground = std::make_shared<Lambertian>(Color(0.8, 0.8, 0.0));
-	auto material_center = std::make_shared<Lambertian>(Color(0.1, 0.2, 0.5));
-	auto material_left = std::make_shared<Dielectric>(1.50);
-	auto material_bubble = std::make_shared<Dielectric>(1.00 / 1.50);
-	auto material_right = std::make_shared<Metal>(Color(0.8, 0.6, 0.2), 1.0);
-
-	world.add(std::make_shared<Sphere>(Point3(0.0, -100.5, -1.0), 100.0, material_ground));
-	world.add(std::make_shared<Sphere>(Point3(0.0, 0.0, -1.2), 0.5, material_center));
-	world.add(std::make_shared<Sphere>(Point3(-1.0, 0.0, -1.0), 0.5, material_left));
-	world.add(std::make_shared<Sphere>(Point3(-1.0, 0.0, -1.0), 0.4, material_bubble));
-	world.add(std::make_shared<Sphere>(Point3(1.0, 0.0, -1.0), 0.5, material_right));
-
-	Camera cam(width, 16.0 / 9.0, 10, 10, 20.0, Point3(-2, 2, 1), Point3(0, 0, -1), Vec3(0, 1, 0), 10.0, 3.4);
-	return cam.render(world);
-}
\ No newline at end of file